@@ -18,6 +18,7 @@ AIBrain::AIBrain()
 	manufacturing = std::make_unique<ManufacturingManager>(this);
 	population = std::make_unique<PopulationManager>(this);
 	taskAllocator = std::make_unique<TaskAllocator>(this);
+	reachability = std::make_unique<Reachability>(&grid, [this](const PathNode* node) { return usableNodes[node->id] != 0; });
 
 	// initialize some inventory
 	resources->Add(ItemType::Wood, 0);
@@ -27,13 +28,15 @@ AIBrain::AIBrain()
 	int rows = grid.GetRows();
 	int cols = grid.GetCols();
 	knownNodes.assign(rows, std::vector<KnownNode>(cols));
+	usableNodes.assign(rows * cols, 0);
+	knownResourceIndex.Reset(rows, cols, grid.cellSize, grid.GetOrigin());
 
 	KnownNode& kNode = NodeToKnown(homeNode);
 	kNode.resource = PathNode::ResourceType::Building;
 
 	double gameTime = GameLoop::Instance().GetGameTime();
 	ExploreNode(startNode, grid, gameTime);
-	for (auto n : startNode->neighbors)
+	for (auto n : grid.Neighbors(startNode))
 	{
 		ExploreNode(n, grid, gameTime);
 	}
@@ -260,7 +263,9 @@ void AIBrain::UpdateDiscovered()
 		PathNode* currentNode = grid.GetNodeAt(scout->ai->GetPosition());
 		if (currentNode->IsObstacle())
 			continue;
-		visible = currentNode->neighbors;
+		visible.clear();
+		for (PathNode* node : grid.Neighbors(currentNode))
+			visible.push_back(node);
 
 		ExploreNode(currentNode, grid, gameTime);
 
@@ -281,24 +286,42 @@ void AIBrain::ExploreNode(PathNode* node, Grid& grid, double& gameTime)
 
 	KnownNode& kNode = knownNodes[r][c];
 
+	bool wasUsable = kNode.discovered && kNode.walkable;
+
 	kNode.walkable = !node->IsObstacle();
 	kNode.lastSeenTime = gameTime;
 
 	if (kNode.discovered)
+	{
+		if (wasUsable != kNode.walkable)
+			OnBeliefChanged(node);
 		return;
+	}
 
 	kNode.resource = node->resource;
 	kNode.resourceAmount = node->resourceAmount;
 	kNode.discovered = true;
 
+	if (kNode.walkable)
+		OnBeliefChanged(node);
+
 	if (node->resource != PathNode::ResourceType::None && node->resourceAmount > 0)
 	{
 		knownResources[node->resource].push_back(node);
+		OnKnownResourceChanged(node);
 	}
 
 	GameLoop::Instance().renderer->MarkNodeDirty(grid.Index(c, r));
 }
 
+void AIBrain::OnBeliefChanged(const PathNode* node)
+{
+	usableNodes[node->id] = CanUseNode(node) ? 1 : 0;
+	beliefVersion++;
+	nodeChanges.push_back(node);
+	reachability->OnNodeChanged(node);
+}
+
 bool AIBrain::IsDiscovered(int index) const
 {
 	Grid& grid = GameLoop::Instance().GetGrid();
@@ -322,9 +345,11 @@ bool AIBrain::IsDiscovered(const PathNode* node)
 	return kNode.discovered;
 }
 
-// not used
-Agent* AIBrain::GetBestAgent(PopulationType type, PathNode* node)
+Agent* AIBrain::GetBestAgent(PopulationType type, BuildingType buildingType)
 {
+	Grid& grid = GameLoop::Instance().GetGrid();
+	Building* building = build->GetBuilding(buildingType);
+
 	float bestScore = FLT_MAX;
 	Agent* bestAgent = nullptr;
 	for (Agent* agent : populationMap[type])
@@ -333,102 +358,70 @@ Agent* AIBrain::GetBestAgent(PopulationType type, PathNode* node)
 			continue;
 
 		float dist;
-		if (agent->ai->CanGoTo(node, dist))
-		{
-			if (dist < bestScore)
-			{
-				bestScore = dist;
-				bestAgent = agent;
-			}
-		}
-	}
-	return bestAgent;
-}
-
-void AIBrain::UpdatePopulationTasks(float dt)
-{
-	for (Agent* agent : populationMap[PopulationType::Worker])
-	{
-		if (agent->busy)
+		if (build->HasBuilding(buildingType))
 		{
-			continue;
+			// Read off the building's distance field, no search per agent
+			dist = build->GetWalkingDistance(buildingType, grid.GetNodeAt(agent->ai->GetPosition()), agent->ai->GetRadius());
+			if (dist < 0)
+				continue;
 		}
-
-		Task* t = nullptr;
-		t = taskAllocator->GetNext(TaskType::Gather);
-		if (!t)
-			t = taskAllocator->GetNext(TaskType::Transport);
-
-		if (t)
+		else if (building && building->targetNode)
 		{
-			agent->currentTask = t;
-			agent->busy = true;
+			// Not built yet so there is no field, the straight line still tells the agents apart
+			dist = DistanceBetween(agent->ai->GetPosition(), building->targetNode->position);
 		}
-	}
-	for (Agent* agent : populationMap[PopulationType::ArmSmith])
-	{
-		if (agent->busy)
+		else
 		{
-			continue;
+			dist = 0;
 		}
 
-		Task* t = taskAllocator->GetNext(TaskType::ForgeWeapon);
-
-		if (t)
+		if (dist < bestScore)
 		{
-			agent->currentTask = t;
-			agent->busy = true;
+			bestScore = dist;
+			bestAgent = agent;
 		}
-
 	}
-	for (Agent* agent : populationMap[PopulationType::Builder])
-	{
-		if (agent->busy)
-		{
-			continue;
-		}
-
-		Task* t = taskAllocator->GetNext(TaskType::Build);
-
-		if (t)
-		{
-			agent->currentTask = t;
-			agent->busy = true;
-		}
+	return bestAgent;
+}
 
-	}
-	for (Agent* agent : populationMap[PopulationType::Coal_Miner])
+void AIBrain::UpdatePopulationTasks(float dt)
+{
+	for (Agent* agent : populationMap[PopulationType::Worker])
 	{
 		if (agent->busy)
 		{
 			continue;
 		}
 
-		Task* t = taskAllocator->GetNext(TaskType::MineCoal);
+		Task* t = taskAllocator->GetNext(TaskType::Gather);
 
 		if (t)
 		{
 			agent->currentTask = t;
 			agent->busy = true;
 		}
-
 	}
-	for (Agent* agent : populationMap[PopulationType::Smelter])
+
+	// The remaining tasks are worked on at a building, they go to the idle agent with the shortest walk there
+	auto assignClosest = [this](PopulationType type, TaskType taskType)
 	{
-		if (agent->busy)
+		while (Task* next = taskAllocator->PeekNext(taskType))
 		{
-			continue;
-		}
-
-		Task* t = taskAllocator->GetNext(TaskType::Smelt);
+			Agent* agent = GetBestAgent(type, taskType == TaskType::Transport ? next->resourceFrom : next->resourceTo);
+			if (!agent)
+				return;
 
-		if (t)
-		{
-			agent->currentTask = t;
+			agent->currentTask = taskAllocator->GetNext(taskType);
 			agent->busy = true;
 		}
+	};
+
+	assignClosest(PopulationType::Worker, TaskType::Transport);
+	assignClosest(PopulationType::ArmSmith, TaskType::ForgeWeapon);
+	assignClosest(PopulationType::Builder, TaskType::Build);
+	assignClosest(PopulationType::Coal_Miner, TaskType::MineCoal);
+	assignClosest(PopulationType::Smelter, TaskType::Smelt);
 
-	}
 	for (Agent* agent : populationMap[PopulationType::Scout])
 	{
 		if (agent->busy)
@@ -556,7 +549,7 @@ static PathNode* BFS(PathNode* startNode, std::vector<std::vector<KnownNode>>& k
 		if (ended)
 			continue;
 
-		for (PathNode* n : current->neighbors)
+		for (PathNode* n : grid.Neighbors(current))
 		{
 			int r = -1;
 			int c = -1;
@@ -650,14 +643,6 @@ void Agent::Update(float dt)
 			std::vector<PathNode*> nodes;
 			grid.QueryNodes(ai->GetPosition(), ai->GetRadius() * 2, nodes, resource);
 
-			for (std::vector<PathNode*>::iterator it = nodes.begin(); it != nodes.end();)
-			{
-				if ((*it)->resourceAmount <= 0)
-					it = nodes.erase(it);
-				else
-					it++;
-			}
-
 			// is close to resource
 			if (!nodes.empty())
 			{
@@ -666,13 +651,14 @@ void Agent::Update(float dt)
 					PathNode* node = nodes[0];
 					holding = ResourceToItem(resource);
 
-					node->resourceAmount--;
+					grid.SetNode(node, node->resource, node->resourceAmount - 1);
 					if (node->resourceAmount <= 0)
 					{
-						node->resource = PathNode::ResourceType::None;
+						grid.SetNode(node, PathNode::ResourceType::None, node->resourceAmount);
 						int r, c;
 						grid.WorldToGrid(node->position, r, c);
 						brain->knownNodes[r][c].resource = PathNode::ResourceType::None;
+						brain->OnKnownResourceChanged(node);
 						for (std::vector<PathNode*>::iterator it = brain->knownResources[resource].begin(); it != brain->knownResources[resource].end();)
 						{
 							if (*it == node)
@@ -704,25 +690,54 @@ void Agent::Update(float dt)
 					return;
 				}
 
-				Pathfinder* p = game.pathfinder;
-
 				PathNode* currentNode = grid.GetNodeAt(ai->GetPosition());
 
-				float outDist;
+				PathNode* closest = nullptr;
+				if (game.pathRequests)
+				{
+					// The closest resource is searched by the request service, the path arrives through ReceivePath on a later tick
+					if (game.pathRequests->IsSearchingClosest(ai))
+						return;
 
-				auto filter = [this](const PathNode* node) { return brain->CanUseNode(node); };
+					// Another agent may have taken the last of the found resource meanwhile
+					if (game.pathRequests->TakeClosestTarget(ai, closest) && closest && brain->GetKnownResources().GetType(closest->id) != resource)
+						closest = nullptr;
+				}
 
-				std::vector<PathNode*> path = p->RequestClosestPath(currentNode, brain->KnownNodesOfType(resource), outDist, ai->GetRadius(), filter);
-				if (path.empty())
+				if (closest == nullptr)
 				{
-					return;
-				}
+					// Resources in another component can never be reached, searching for them would flood the whole component
+					std::vector<PathNode*> targets = brain->KnownNodesOfType(resource);
+					Reachability* reachability = brain->GetReachability();
+					targets.erase(std::remove_if(targets.begin(), targets.end(),
+						[&](PathNode* target) { return !reachability->MayReach(currentNode, target, ai->GetRadius()); }), targets.end());
+					if (targets.empty())
+						return;
+
+					if (game.pathRequests)
+					{
+						// Services that do not queue closest searches answer right away
+						game.pathRequests->SubmitClosest(ai, currentNode, targets, ai->GetRadius(), brain);
+						if (!game.pathRequests->TakeClosestTarget(ai, closest) || closest == nullptr)
+							return;
+					}
+					else
+					{
+						float outDist;
+						std::vector<PathNode*> path = game.pathfinder->RequestClosestPath(currentNode, targets, outDist, ai->GetRadius(), brain->UsableFilter());
+						if (path.empty())
+						{
+							return;
+						}
 
-				PathNode* closest = path.front();
+						closest = path.front();
+					}
+				}
 
 				KnownNode& kNode = brain->NodeToKnown(closest);
 
 				kNode.resourceAmount--;
+				brain->OnKnownResourceChanged(closest);
 				approaching = closest;
 
 				bool valid = true;
@@ -903,20 +918,23 @@ std::vector<PathNode*> AIBrain::KnownNodesOfType(PathNode::ResourceType type)
 {
 	Grid& grid = GameLoop::Instance().GetGrid();
 
-	std::vector<PathNode*> known;
-	for (auto node : knownResources[type])
-	{
-		int r;
-		int c;
-		grid.WorldToGrid(node->position, r, c);
+	std::vector<int> ids;
+	knownResourceIndex.GetAll(type, ids);
 
-		if (knownNodes[r][c].resourceAmount > 0)
-			known.push_back(node);
-	}
+	std::vector<PathNode*> known;
+	known.reserve(ids.size());
+	for (int id : ids)
+		known.push_back(grid.GetNode(id));
 
 	return known;
 }
 
+void AIBrain::OnKnownResourceChanged(const PathNode* node)
+{
+	KnownNode& kNode = NodeToKnown(node);
+	knownResourceIndex.Set(node->id, kNode.resourceAmount > 0 ? kNode.resource : PathNode::ResourceType::None);
+}
+
 bool AIBrain::CanUseNode(const PathNode* node)
 {
 	Grid& grid = GameLoop::Instance().GetGrid();
@@ -7,6 +7,9 @@
 #include <unordered_set>
 
 #include "AIBrainManagers.h"
+#include "Reachability.h"
+#include "ResourceIndex.h"
+#include "TraversalFilters.h"
 
 struct KnownNode
 {
@@ -70,12 +73,43 @@ public:
 
 	int discoveredAllTicks = 0;
 	bool discoveredAll = false;
+
+	// Get the known nodes of a resource type believed to have resources left, read from the index of known resources
 	std::vector<PathNode*> KnownNodesOfType(PathNode::ResourceType type);
+
+	// Get the known nodes believed to have resources left by resource type, for nearest and radius queries
+	const ResourceIndex& GetKnownResources() const { return knownResourceIndex; }
+
+	// Called every time the believed resource or resource amount of a node changes, see KnownNode
+	void OnKnownResourceChanged(const PathNode* node);
+
 	bool CanUseNode(const PathNode* node);
+
+	// Get a filter that answers like CanUseNode, the searches run it without a std::function call
+	MaskFilter UsableFilter() const { return MaskFilter{ usableNodes.data() }; }
+
+	// Get CanUseNode for every node, indexed by PathNode::id
+	const std::vector<uint8_t>& GetUsableNodes() const { return usableNodes; }
+
+	// Get a counter that changes every time CanUseNode starts answering differently for a node
+	uint32_t GetBeliefVersion() const { return beliefVersion; }
+
+	// Get every node CanUseNode started answering differently for or whose terrain or clearance changed, oldest first
+	// Incremental searches remember how far they read and only look at the entries added since
+	const std::vector<const PathNode*>& GetNodeChanges() const { return nodeChanges; }
+
+	// Called by the grid for a node whose terrain or clearance changed, so incremental searches repair their costs around it
+	void OnTerrainChanged(const PathNode* node) { nodeChanges.push_back(node); }
+
+	// Get the components of the nodes CanUseNode accepts, kept up to date as nodes are explored
+	Reachability* GetReachability() { return reachability.get(); }
 	KnownNode& NodeToKnown(const PathNode* node);
 	std::map<PathNode::ResourceType, std::vector<PathNode*>> knownResources;
 private:
-	Agent* GetBestAgent(PopulationType type, PathNode* node);
+	// Get the idle agent of a type with the shortest walk to a building, read off the building's distance field
+	// --------------------------
+	// returns nullptr if no idle agent can reach the building
+	Agent* GetBestAgent(PopulationType type, BuildingType buildingType);
 	void UpdatePopulationTasks(float dt);
 	bool TrainUnit(PopulationType type);
 	void PickupNewTrained();
@@ -85,6 +119,9 @@ private:
 	void Gather(ItemType resource, int amount, float priority);
 	void CheckDeath();
 
+	// Called every time CanUseNode starts answering differently for a node
+	void OnBeliefChanged(const PathNode* node);
+
 	std::map<PopulationType, std::vector<Agent*>> populationMap;
 	std::vector<Agent*> agents;
 
@@ -93,6 +130,7 @@ private:
 	std::unique_ptr<ManufacturingManager> manufacturing;
 	std::unique_ptr<PopulationManager> population;
 	std::unique_ptr<TaskAllocator> taskAllocator;
+	std::unique_ptr<Reachability> reachability;
 
 	std::map<PopulationType, float> tryTraining;
 
@@ -100,5 +138,11 @@ private:
 
 	int frames = 0;
 
+	uint32_t beliefVersion = 0;
+	std::vector<uint8_t> usableNodes; // CanUseNode per node id, refreshed by OnBeliefChanged
+	std::vector<const PathNode*> nodeChanges; // see GetNodeChanges
+
+	ResourceIndex knownResourceIndex; // the nodes of knownNodes with a resource and a resourceAmount above zero
+
 	Vec2 startPos = { 965, 491 };
 };
\ No newline at end of file
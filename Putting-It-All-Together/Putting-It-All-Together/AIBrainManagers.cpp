@@ -65,6 +65,22 @@ Task* TaskAllocator::GetNext(TaskType type)
 	return bestTask;
 }
 
+Task* TaskAllocator::PeekNext(TaskType type)
+{
+	Task* bestTask = nullptr;
+	float highestPriority = -1.0f;
+	for (Task* task : tasks[type])
+	{
+		if (task->priority > highestPriority)
+		{
+			highestPriority = task->priority;
+			bestTask = task;
+		}
+	}
+
+	return bestTask;
+}
+
 void TaskAllocator::Clear()
 {
 	// delete current tasks
@@ -151,6 +167,7 @@ void BuildManager::Update(float dt)
 		if ((*it)->productionTime <= 0)
 		{
 			builtBuildings[(*it)->type] = *it;
+			PruneDistanceFields(); // a building of the same type may have been replaced
 			(*it)->PlaceBuilding();
 			Logger::Instance().Log(std::string("Built: ") + ToString((*it)->type) + "\n");
 			(*it)->built = true;
@@ -235,6 +252,127 @@ Building* BuildManager::QueueBuilding(BuildingType type, PathNode* node)
 	queue.push_back(building);
 	return building;
 }
+bool BuildManager::IsBuildingNode(const PathNode* node) const
+{
+	if (node == nullptr)
+		return false;
+
+	for (auto b : builtBuildings)
+		if (b.second->targetNode == node)
+			return true;
+	for (auto b : underConstruction)
+		if (b->targetNode == node)
+			return true;
+	for (auto b : queue)
+		if (b->targetNode == node)
+			return true;
+
+	return false;
+}
+
+const FlowField* BuildManager::GetDistanceField(const PathNode* node, float agentRadius)
+{
+	if (node == nullptr)
+		return nullptr;
+
+	Building* building = nullptr;
+	for (auto b : builtBuildings)
+		if (b.second->targetNode == node)
+			building = b.second;
+	if (building == nullptr)
+		return nullptr;
+
+	DistanceField* entry = nullptr;
+	DistanceField* freeSlot = nullptr;
+	for (DistanceField& distanceField : distanceFields)
+	{
+		if (distanceField.node == node && distanceField.radius == agentRadius)
+			entry = &distanceField;
+		else if (distanceField.node == nullptr)
+			freeSlot = &distanceField;
+	}
+
+	if (entry == nullptr)
+	{
+		if (freeSlot == nullptr)
+		{
+			distanceFields.emplace_back();
+			freeSlot = &distanceFields.back();
+		}
+		entry = freeSlot;
+		entry->node = node;
+		entry->radius = agentRadius;
+		entry->built = false;
+	}
+
+	// Only changes next to what the field reached can change it, most of them happen far away at the edge of the explored area
+	const std::vector<const PathNode*>& changes = owner->GetNodeChanges();
+	bool stale = !entry->built;
+	for (size_t i = entry->changesSeen; i < changes.size() && !stale; i++)
+		stale = AffectsField(*entry, changes[i]);
+	entry->changesSeen = changes.size();
+
+	if (stale)
+	{
+		Grid& grid = GameLoop::Instance().GetGrid();
+		entry->field.Build(&grid, building->targetNode, agentRadius, owner->UsableFilter());
+		entry->built = true;
+	}
+
+	return &entry->field;
+}
+
+bool BuildManager::AffectsField(const DistanceField& entry, const PathNode* node) const
+{
+	Grid& grid = GameLoop::Instance().GetGrid();
+
+	// The field's goal moves to a neighbor of the building when the agent doesn't fit on it
+	if (node == entry.node || grid.AreNeighbors(node, entry.node))
+		return true;
+
+	// A node is entered, and diagonal steps cut past it, only from its neighbors
+	auto reached = [&](const PathNode* n) { return n == entry.field.GetGoal() || entry.field.GetCost(n) >= 0; };
+	if (reached(node))
+		return true;
+	for (PathNode* neighbor : grid.Around(node))
+		if (reached(neighbor))
+			return true;
+
+	return false;
+}
+
+void BuildManager::PruneDistanceFields()
+{
+	for (DistanceField& distanceField : distanceFields)
+	{
+		if (distanceField.node == nullptr)
+			continue;
+
+		bool standing = false;
+		for (auto b : builtBuildings)
+			if (b.second->targetNode == distanceField.node)
+				standing = true;
+
+		if (!standing)
+		{
+			distanceField.node = nullptr;
+			distanceField.field = FlowField();
+			distanceField.built = false;
+		}
+	}
+}
+
+float BuildManager::GetWalkingDistance(BuildingType type, const PathNode* from, float agentRadius)
+{
+	if (builtBuildings.count(type) == 0)
+		return -1;
+
+	const FlowField* field = GetDistanceField(builtBuildings.at(type)->targetNode, agentRadius);
+	if (field == nullptr)
+		return -1;
+
+	return field->GetCost(from);
+}
 
 void Building::PlaceBuilding()
 {
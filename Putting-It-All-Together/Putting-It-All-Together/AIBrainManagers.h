@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <deque>
 #include <string>
 #include <map>
 #include <algorithm>
@@ -7,6 +8,7 @@
 #include "PathNode.h"
 #include <memory>
 #include "Renderer.h"
+#include "FlowField.h"
 
 class GameAI;
 class AIBrain; // forward
@@ -101,6 +103,9 @@ public:
 	int AddTask(const Task& t);
 	void Update(float dt);
 	Task* GetNext(TaskType type);
+
+	// Get the task GetNext would hand out next without taking it
+	Task* PeekNext(TaskType type);
 	void Clear();
 
 	std::map<TaskType, std::vector<Task*>> tasks;
@@ -244,8 +249,40 @@ public:
 	Building* FromUnderConstruction(const BuildingType type);
 	Building* QueueBuilding(BuildingType type, PathNode* node);
 
+	// Check if node is where a built, queued or under construction building is worked on
+	bool IsBuildingNode(const PathNode* node) const;
+
+	// Get the walking distance field towards the built building standing on node, as seen by the owner
+	// The field is rebuilt first if the building was placed since it was built, or a node the owner's belief,
+	// the terrain or the clearance changed for since then is one the field reached or steps next to
+	// --------------------------
+	// returns nullptr if no built building stands on node, the field stays where it is for as long as the manager exists
+	const FlowField* GetDistanceField(const PathNode* node, float agentRadius);
+
+	// Get the walking distance from a node to a built building, read off its distance field
+	// --------------------------
+	// returns -1 if the building is not built or can't be reached from node
+	float GetWalkingDistance(BuildingType type, const PathNode* from, float agentRadius);
+
 private:
+	// Distance field towards one built building for one agent radius
+	struct DistanceField
+	{
+		const PathNode* node = nullptr; // nullptr for a slot released by PruneDistanceFields
+		float radius = 0;
+		FlowField field;
+		bool built = false;
+		size_t changesSeen = 0; // entries of AIBrain::GetNodeChanges looked at since the field was built
+	};
+
+	// Check if a change of node could make field disagree with a field built now
+	bool AffectsField(const DistanceField& entry, const PathNode* node) const;
+
+	// Release the fields towards nodes no built building stands on anymore, their slots are reused by later fields
+	void PruneDistanceFields();
+
 	AIBrain* owner;
+	std::deque<DistanceField> distanceFields; // a deque so adding a field never moves the ones handed out before
 	std::vector<Building*> underConstruction;
 	std::vector<Building*> queue;
 	std::map<BuildingType, Building*> builtBuildings;
@@ -10,21 +10,7 @@
 
 using NodeFilter = std::function<bool(const PathNode*)>;
 
-struct OpenEntry
-{
-	PathNode* node;
-	float f;
-};
-
-struct OpenEntryCompare
-{
-	bool operator()(OpenEntry& a, OpenEntry& b) const
-	{
-		return a.f > b.f; // min-heap by f
-	}
-};
-
-PathNode* ResolveGoalNode(PathNode* desired, float agentRadius)
+PathNode* ResolveGoalNode(const Grid& grid, PathNode* desired, float agentRadius)
 {
 	if (!desired)
 		return nullptr;
@@ -35,7 +21,7 @@ PathNode* ResolveGoalNode(PathNode* desired, float agentRadius)
 	PathNode* best = nullptr;
 	float bestDist = std::numeric_limits<float>::max();
 
-	for (PathNode* n : desired->neighbors)
+	for (PathNode* n : grid.Neighbors(desired))
 	{
 		if (n->IsObstacle())
 			continue;
@@ -57,7 +43,7 @@ PathNode* ResolveGoalNode(PathNode* desired, float agentRadius)
 #include "GameLoop.h"
 std::vector<PathNode*> AStar::FindPath(PathNode* startNode, PathNode* endNode, float& outDist, float agentRadius, const NodeFilter& canTraverse)
 {
-	PathNode* goalNode = ResolveGoalNode(endNode, agentRadius);
+	PathNode* goalNode = ResolveGoalNode(*grid, endNode, agentRadius);
 	if (goalNode == nullptr)
 	{
 		std::cout << "Path not found!" << std::endl;
@@ -66,14 +52,40 @@ std::vector<PathNode*> AStar::FindPath(PathNode* startNode, PathNode* endNode, f
 		return std::vector<PathNode*>();
 	}
 
-	std::unordered_map<PathNode*, NodeRecord> records;
+	lastForwardExpanded = 0;
+	lastBackwardExpanded = 0;
+	bool bidirectional = bidirectionalThreshold > 0 && startNode && Octile(startNode, goalNode) > bidirectionalThreshold;
 
-	std::priority_queue<OpenEntry, std::vector<OpenEntry>, OpenEntryCompare> openQueue;
-	std::unordered_set<PathNode*> closed;
+	return WithFilter(canTraverse, [&](const auto& filter)
+		{
+			if (bidirectional)
+			{
+				if (storage == RecordStorage::Flat)
+					return SearchBidirectional(flatRecords, reverseRecords, startNode, goalNode, outDist, agentRadius, filter);
+
+				NodeRecordMap forward;
+				NodeRecordMap backward;
+				return SearchBidirectional(forward, backward, startNode, goalNode, outDist, agentRadius, filter);
+			}
+
+			if (storage == RecordStorage::Flat)
+				return SearchPath(flatRecords, startNode, goalNode, outDist, agentRadius, filter);
+
+			NodeRecordMap records;
+			return SearchPath(records, startNode, goalNode, outDist, agentRadius, filter);
+		});
+}
+
+template<typename Records, typename Filter>
+std::vector<PathNode*> AStar::SearchPath(Records& records, PathNode* startNode, PathNode* goalNode, float& outDist, float agentRadius, const Filter& canTraverse)
+{
+	records.NewSearch(grid->GetRows() * grid->GetCols());
+	lastExpanded = 0;
 
+	OpenQueue openQueue;
 
 	// Initialize start node costs
-	NodeRecord& startRec = records[startNode];
+	NodeRecord& startRec = records.Get(startNode);
 	startRec.gCost = 0.0f;
 	startRec.hCost = Heuristic(startNode, goalNode);
 	startRec.fCost = startRec.gCost + startRec.hCost;
@@ -81,8 +93,171 @@ std::vector<PathNode*> AStar::FindPath(PathNode* startNode, PathNode* endNode, f
 
 	openQueue.push({ startNode, startRec.fCost });
 
+	if (Expand(records, openQueue, goalNode, agentRadius, canTraverse, std::numeric_limits<int>::max(), lastExpanded) == SearchStatus::Found)
+	{
+		outDist = records.At(goalNode).gCost;
+		return ReconstructPath(records, goalNode);
+	}
+
+	GameLoop::Instance().AddDebugEntity(goalNode->position, Renderer::Lime, 10);
+
+	outDist = -1;
+	return std::vector<PathNode*>();
+}
+
+template<typename Records, typename Filter>
+std::vector<PathNode*> AStar::SearchBidirectional(Records& forward, Records& backward, PathNode* startNode, PathNode* goalNode, float& outDist, float agentRadius, const Filter& canTraverse)
+{
+	size_t nodeCount = grid->GetRows() * grid->GetCols();
+	forward.NewSearch(nodeCount);
+	backward.NewSearch(nodeCount);
+	lastExpanded = 0;
+	outDist = -1;
+
+	OpenQueue forwardQueue;
+	OpenQueue backwardQueue;
+
+	// The backward search walks forward steps in reverse, its heuristic estimates the path from the start
+	NodeRecord& startRec = forward.Get(startNode);
+	startRec.gCost = 0.0f;
+	startRec.hCost = ConsistentHeuristic(startNode, goalNode);
+	startRec.fCost = startRec.hCost;
+	forwardQueue.push({ startNode, startRec.fCost });
+
+	NodeRecord& goalRec = backward.Get(goalNode);
+	goalRec.gCost = 0.0f;
+	goalRec.hCost = ConsistentHeuristic(startNode, goalNode);
+	goalRec.fCost = goalRec.hCost;
+	backwardQueue.push({ goalNode, goalRec.fCost });
+
+	// Lowest f of each open list, the bound the other direction rejects nodes with
+	float forwardLowest = startRec.fCost;
+	float backwardLowest = goalRec.fCost;
+
+	float best = std::numeric_limits<float>::infinity();
+	PathNode* meeting = startNode == goalNode ? startNode : nullptr;
+	if (meeting)
+		best = 0.0f;
+
+	auto closed = [&](PathNode* node) { return forward.IsClosed(node) || backward.IsClosed(node); };
+
+	while (!forwardQueue.empty() && !backwardQueue.empty())
+	{
+		// Expand the direction with the smaller open list, it is the cheaper one to grow
+		bool isForward = forwardQueue.size() <= backwardQueue.size();
+		Records& own = isForward ? forward : backward;
+		Records& other = isForward ? backward : forward;
+		OpenQueue& queue = isForward ? forwardQueue : backwardQueue;
+
+		OpenEntry entry = queue.top();
+		queue.pop();
+
+		PathNode* current = entry.node;
+
+		// Ignore stale queue entries and nodes either direction already closed
+		if (closed(current) || own.Get(current).fCost != entry.f)
+		{
+			if (!queue.empty())
+				(isForward ? forwardLowest : backwardLowest) = queue.top().f;
+			continue;
+		}
+
+		NodeRecord& rec = own.Get(current);
+		own.Close(current);
+
+		// Rejected: no path through current can be shorter than the best one met so far
+		float otherLowest = isForward ? backwardLowest : forwardLowest;
+		bool rejected = rec.fCost >= best ||
+			rec.gCost + otherLowest - (isForward ? ConsistentHeuristic(startNode, current) : ConsistentHeuristic(current, goalNode)) >= best;
+
+		if (!rejected)
+		{
+			lastExpanded++;
+			(isForward ? lastForwardExpanded : lastBackwardExpanded)++;
+
+			for (PathNode* neighbor : grid->Neighbors(current))
+			{
+				if (closed(neighbor))
+					continue;
+
+				float stepCost;
+				if (isForward)
+				{
+					if ((!canTraverse(neighbor) && neighbor != goalNode) || neighbor->clearance < agentRadius)
+						continue;
+					stepCost = StepCost(current, neighbor, canTraverse);
+				}
+				else
+				{
+					// The start itself is never checked by the forward search
+					if (neighbor != startNode && (!canTraverse(neighbor) || neighbor->clearance < agentRadius))
+						continue;
+					stepCost = StepCost(neighbor, current, canTraverse);
+				}
+
+				if (stepCost == std::numeric_limits<float>::infinity())
+					continue;
+
+				float tentativeG = rec.gCost + stepCost;
+
+				NodeRecord& neighborRec = own.Get(neighbor);
+				if (tentativeG >= neighborRec.gCost)
+					continue;
+
+				neighborRec.parent = current;
+				neighborRec.gCost = tentativeG;
+				neighborRec.hCost = isForward ? ConsistentHeuristic(neighbor, goalNode) : ConsistentHeuristic(startNode, neighbor);
+				neighborRec.fCost = tentativeG + neighborRec.hCost;
+
+				// The two searches met, the path through neighbor is a candidate
+				if (other.Has(neighbor) && tentativeG + other.At(neighbor).gCost < best)
+				{
+					best = tentativeG + other.At(neighbor).gCost;
+					meeting = neighbor;
+				}
+
+				// A node that would be rejected when popped is not worth a place in the open list
+				if (neighborRec.fCost < best)
+					queue.push({ neighbor, neighborRec.fCost });
+			}
+		}
+
+		if (!queue.empty())
+			(isForward ? forwardLowest : backwardLowest) = queue.top().f;
+	}
+
+	bidirectionalSearches++;
+	forwardExpandedTotal += lastForwardExpanded;
+	backwardExpandedTotal += lastBackwardExpanded;
+
+	if (meeting == nullptr)
+	{
+		GameLoop::Instance().AddDebugEntity(goalNode->position, Renderer::Lime, 10);
+		return std::vector<PathNode*>();
+	}
+
+	// Goal back to the meeting node through the backward parents, then on to the start through the forward ones
+	std::vector<PathNode*> path = ReconstructPath(backward, meeting);
+	std::reverse(path.begin(), path.end());
+	path.pop_back();
+
+	std::vector<PathNode*> towardsStart = ReconstructPath(forward, meeting);
+	path.insert(path.end(), towardsStart.begin(), towardsStart.end());
+
+	outDist = best;
+	return path;
+}
+
+template<typename Records, typename Filter>
+AStar::SearchStatus AStar::Expand(Records& records, OpenQueue& openQueue, PathNode* goalNode, float agentRadius, const Filter& canTraverse, int maxExpansions, int& expanded)
+{
+	int budget = maxExpansions;
+
 	while (!openQueue.empty())
 	{
+		if (budget <= 0)
+			return SearchStatus::Running;
+
 		OpenEntry entry = openQueue.top();
 		openQueue.pop();
 
@@ -90,52 +265,53 @@ std::vector<PathNode*> AStar::FindPath(PathNode* startNode, PathNode* endNode, f
 
 
 		// Ignore stale queue entries
-		if (records[current].fCost != entry.f)
+		if (records.Get(current).fCost != entry.f)
 			continue;
 
 		// Found goal
 		if (current == goalNode)
-		{
-			outDist = records.at(goalNode).gCost;
-			return ReconstructPath(records, goalNode);
-		}
+			return SearchStatus::Found;
+
+		records.Close(current);
+		expanded++;
+		budget--;
 
-		closed.insert(current);
+		// Expand, reading the grid layers so the neighbors themselves are not loaded
+		int currentId = grid->IdOf(current);
+		int cols = grid->GetCols();
 
-		// Expand
-		for (PathNode* neighbor : current->neighbors)
+		for (PathNode* neighbor : grid->Neighbors(current))
 		{
-			if (closed.find(neighbor) != closed.end())
+			if (records.IsClosed(neighbor))
 				continue;
 
-			if (!canTraverse(neighbor) && neighbor != goalNode)
+			int id = grid->IdOf(neighbor);
+
+			if (!Accepts(canTraverse, id) && neighbor != goalNode)
 				continue;
 
-			if (neighbor->clearance < agentRadius)
+			if (grid->GetClearance(id) < agentRadius)
 				continue;
 
-			float dx = current->position.x - neighbor->position.x;
-			float dy = current->position.y - neighbor->position.y;
-			float edgeCost = (dx == 0 || dy == 0) ? 1.0f : 1.41421356f;
-			bool diagonal = (dx == 0 || dy == 0) ? false : true;
+			int offset = id - currentId;
+			bool diagonal = offset != 1 && offset != -1 && offset != cols && offset != -cols;
+			float edgeCost = diagonal ? 1.41421356f : 1.0f;
 
-			float terrainPenalty = 1 / SurfaceSpeed(neighbor->type);
+			float terrainPenalty = 1 / SurfaceSpeed(grid->GetTerrain(id));
 
 			if (diagonal)
 			{
-				PathNode* sideA = grid->GetNodeAt(Vec2(current->position.x - dx, current->position.y));
-				PathNode* sideB = grid->GetNodeAt(Vec2(current->position.x, current->position.y - dy));
+				// The cells in the row of current and the column of neighbor, and the other way around
+				int sideA = currentId - currentId % cols + id % cols;
+				int sideB = id - id % cols + currentId % cols;
 
-				if ((sideA && !canTraverse(sideA)) ||
-					(sideB && !canTraverse(sideB)))
-				{
+				if (!Accepts(canTraverse, sideA) || !Accepts(canTraverse, sideB))
 					continue;
-				}
 			}
 
-			float tentativeG = records[current].gCost + edgeCost * terrainPenalty;
+			float tentativeG = records.Get(current).gCost + edgeCost * terrainPenalty;
 
-			NodeRecord& rec = records[neighbor];
+			NodeRecord& rec = records.Get(neighbor);
 
 			// If we've seen this node with an equal or better gCost, skip
 			if (tentativeG >= rec.gCost)
@@ -150,21 +326,106 @@ std::vector<PathNode*> AStar::FindPath(PathNode* startNode, PathNode* endNode, f
 		}
 	}
 
-	GameLoop::Instance().AddDebugEntity(goalNode->position, Renderer::Lime, 10);
+	return SearchStatus::Failed;
+}
 
-	outDist = -1;
-	return std::vector<PathNode*>();
+void AStar::BeginSearch(SlicedSearch& search, PathNode* startNode, PathNode* endNode, float agentRadius, const NodeFilter& canTraverse)
+{
+	search.startNode = startNode;
+	search.goalNode = ResolveGoalNode(*grid, endNode, agentRadius);
+	search.agentRadius = agentRadius;
+	search.canTraverse = canTraverse;
+	search.expanded = 0;
+	search.openQueue = OpenQueue();
+
+	if (search.goalNode == nullptr || startNode == nullptr)
+	{
+		search.status = SearchStatus::Failed;
+		return;
+	}
+
+	search.records.NewSearch(grid->GetRows() * grid->GetCols());
+
+	NodeRecord& startRec = search.records.Get(startNode);
+	startRec.gCost = 0.0f;
+	startRec.hCost = Heuristic(startNode, search.goalNode);
+	startRec.fCost = startRec.gCost + startRec.hCost;
+	startRec.parent = nullptr;
+
+	search.openQueue.push({ startNode, startRec.fCost });
+	search.status = SearchStatus::Running;
+}
+
+int AStar::StepSearch(SlicedSearch& search, int maxExpansions)
+{
+	if (search.status != SearchStatus::Running)
+		return 0;
+
+	int expanded = 0;
+	search.status = WithFilter(search.canTraverse, [&](const auto& filter)
+		{
+			return Expand(search.records, search.openQueue, search.goalNode, search.agentRadius, filter, maxExpansions, expanded);
+		});
+	search.expanded += expanded;
+	return expanded;
+}
+
+std::vector<PathNode*> AStar::GetSearchPath(const SlicedSearch& search, float& outDist)
+{
+	if (search.status != SearchStatus::Found)
+	{
+		outDist = -1;
+		return std::vector<PathNode*>();
+	}
+
+	outDist = search.records.At(search.goalNode).gCost;
+	return ReconstructPath(search.records, search.goalNode);
 }
 
 std::vector<PathNode*> AStar::FindClosestPath(PathNode* startNode, const std::vector<PathNode*>& possibleEndNodes, float& outDist, float agentRadius, const NodeFilter& canTraverse)
 {
-	std::unordered_map<PathNode*, NodeRecord> records;
+	return WithFilter(canTraverse, [&](const auto& filter)
+		{
+			if (closestSearch == ClosestSearch::MultiSource)
+			{
+				if (storage == RecordStorage::Flat)
+					return SearchClosestPathReverse(flatRecords, startNode, possibleEndNodes, outDist, agentRadius, filter);
+
+				NodeRecordMap records;
+				return SearchClosestPathReverse(records, startNode, possibleEndNodes, outDist, agentRadius, filter);
+			}
+
+			if (storage == RecordStorage::Flat)
+				return SearchClosestPath(flatRecords, startNode, possibleEndNodes, outDist, agentRadius, filter);
+
+			NodeRecordMap records;
+			return SearchClosestPath(records, startNode, possibleEndNodes, outDist, agentRadius, filter);
+		});
+}
+
+std::vector<AStar::ClosestTarget> AStar::FindClosestTargets(PathNode* startNode, const std::vector<PathNode*>& possibleEndNodes, size_t count, float agentRadius, const NodeFilter& canTraverse)
+{
+	return WithFilter(canTraverse, [&](const auto& filter)
+		{
+			if (storage == RecordStorage::Flat)
+				return SearchClosestTargets(flatRecords, startNode, possibleEndNodes, count, agentRadius, filter);
+
+			NodeRecordMap records;
+			return SearchClosestTargets(records, startNode, possibleEndNodes, count, agentRadius, filter);
+		});
+}
+
+template<typename Records, typename Filter>
+std::vector<PathNode*> AStar::SearchClosestPath(Records& records, PathNode* startNode, const std::vector<PathNode*>& possibleEndNodes, float& outDist, float agentRadius, const Filter& canTraverse)
+{
+	records.NewSearch(grid->GetRows() * grid->GetCols());
+	lastExpanded = 0;
+	MarkTargets(possibleEndNodes);
 
 	std::priority_queue<OpenEntry, std::vector<OpenEntry>, OpenEntryCompare> openQueue;
-	std::unordered_set<PathNode*> closed;
 
 	// Initialize start node costs
-	NodeRecord& startRec = records[startNode];
+	NodeRecord& startRec = records.Get(startNode);
 	startRec.gCost = 0.0f;
 	startRec.hCost = BestHeuristic(startNode, possibleEndNodes);
 	startRec.fCost = startRec.gCost + startRec.hCost;
@@ -180,60 +441,55 @@ std::vector<PathNode*> AStar::FindClosestPath(PathNode* startNode, const std::ve
 		PathNode* current = entry.node;
 
 		// Ignore stale queue entries
-		if (records[current].fCost != entry.f)
+		if (records.Get(current).fCost != entry.f)
 			continue;
 
-		auto isDestination = [&](const PathNode* n)
-			{
-				for (PathNode* t : possibleEndNodes)
-					if (n == t)
-						return true;
-				return false;
-			};
-
 		// Found goal
-		if (isDestination(current))
+		if (IsTarget(current))
 		{
-			outDist = records.at(current).gCost;
+			outDist = records.At(current).gCost;
 			return ReconstructPath(records, current);
 		}
 
-		closed.insert(current);
+		records.Close(current);
+		lastExpanded++;
 
-		// Expand
-		for (PathNode* neighbor : current->neighbors)
+		// Expand, reading the grid layers so the neighbors themselves are not loaded
+		int currentId = grid->IdOf(current);
+		int cols = grid->GetCols();
+
+		for (PathNode* neighbor : grid->Neighbors(current))
 		{
-			if (closed.find(neighbor) != closed.end())
+			if (records.IsClosed(neighbor))
 				continue;
 
-			if (!canTraverse(neighbor))
+			int id = grid->IdOf(neighbor);
+
+			if (!Accepts(canTraverse, id))
 				continue;
 
-			if (neighbor->clearance < agentRadius)
+			if (grid->GetClearance(id) < agentRadius)
 				continue;
 
-			float dx = current->position.x - neighbor->position.x;
-			float dy = current->position.y - neighbor->position.y;
-			float edgeCost = (dx == 0 || dy == 0) ? 1.0f : 1.41421356f;
-			bool diagonal = (dx == 0 || dy == 0) ? false : true;
+			int offset = id - currentId;
+			bool diagonal = offset != 1 && offset != -1 && offset != cols && offset != -cols;
+			float edgeCost = diagonal ? 1.41421356f : 1.0f;
 
-			float terrainPenalty = 1 / SurfaceSpeed(neighbor->type);
+			float terrainPenalty = 1 / SurfaceSpeed(grid->GetTerrain(id));
 
 			if (diagonal)
 			{
-				PathNode* sideA = grid->GetNodeAt(Vec2(current->position.x - dx, current->position.y));
-				PathNode* sideB = grid->GetNodeAt(Vec2(current->position.x, current->position.y - dy));
+				// The cells in the row of current and the column of neighbor, and the other way around
+				int sideA = currentId - currentId % cols + id % cols;
+				int sideB = id - id % cols + currentId % cols;
 
-				if ((sideA && !canTraverse(sideA)) ||
-					(sideB && !canTraverse(sideB)))
-				{
+				if (!Accepts(canTraverse, sideA) || !Accepts(canTraverse, sideB))
 					continue;
-				}
 			}
 
-			float tentativeG = records[current].gCost + edgeCost * terrainPenalty;
+			float tentativeG = records.Get(current).gCost + edgeCost * terrainPenalty;
 
-			NodeRecord& rec = records[neighbor];
+			NodeRecord& rec = records.Get(neighbor);
 
 			// If we've seen this node with an equal or better gCost, skip
 			if (tentativeG >= rec.gCost)
@@ -252,19 +508,302 @@ std::vector<PathNode*> AStar::FindClosestPath(PathNode* startNode, const std::ve
 	return std::vector<PathNode*>();
 }
 
-float AStar::BestHeuristic(PathNode* a, std::vector<PathNode*> possibleb)
+template<typename Records, typename Filter>
+std::vector<std::vector<PathNode*>> AStar::SearchPathsReverse(Records& records, const std::vector<PathNode*>& startNodes, PathNode* goalNode, std::vector<float>& outDists, float agentRadius, const Filter& canTraverse)
 {
-	float smallest = std::numeric_limits<float>::max();
-	for (PathNode* b : possibleb)
+	records.NewSearch(grid->GetRows() * grid->GetCols());
+	lastExpanded = 0;
+	MarkTargets(startNodes);
+
+	std::vector<std::vector<PathNode*>> paths(startNodes.size());
+	outDists.assign(startNodes.size(), -1);
+
+	// Distinct start nodes still to settle, the search ends as soon as the last one is closed
+	std::vector<PathNode*> starts;
+	for (PathNode* start : startNodes)
+		if (start && std::find(starts.begin(), starts.end(), start) == starts.end())
+			starts.push_back(start);
+	size_t remaining = starts.size();
+
+	// The heuristic estimates the path still missing by the octile distance from the box around the start nodes,
+	// it never overestimates the distance to any of them and costs the same for any amount of starts
+	int cols = grid->GetCols();
+	int minRow = std::numeric_limits<int>::max();
+	int maxRow = std::numeric_limits<int>::min();
+	int minCol = std::numeric_limits<int>::max();
+	int maxCol = std::numeric_limits<int>::min();
+	for (PathNode* start : starts)
 	{
-		float h = Heuristic(a, b);
-		if (h < smallest)
-			smallest = h;
+		minRow = std::min(minRow, start->id / cols);
+		maxRow = std::max(maxRow, start->id / cols);
+		minCol = std::min(minCol, start->id % cols);
+		maxCol = std::max(maxCol, start->id % cols);
 	}
-	return smallest;
+
+	auto estimate = [&](PathNode* node)
+		{
+			int row = node->id / cols;
+			int col = node->id % cols;
+			float dy = (float)std::max({ 0, minRow - row, row - maxRow });
+			float dx = (float)std::max({ 0, minCol - col, col - maxCol });
+			return std::max(dx, dy) + 0.41421356f * std::min(dx, dy);
+		};
+
+	OpenQueue openQueue;
+
+	NodeRecord& goalRec = records.Get(goalNode);
+	goalRec.gCost = 0.0f;
+	goalRec.hCost = estimate(goalNode);
+	goalRec.fCost = goalRec.hCost;
+	goalRec.parent = nullptr;
+	openQueue.push({ goalNode, goalRec.fCost });
+
+	while (!openQueue.empty() && remaining > 0)
+	{
+		OpenEntry entry = openQueue.top();
+		openQueue.pop();
+
+		PathNode* current = entry.node;
+
+		if (records.IsClosed(current) || records.Get(current).fCost != entry.f)
+			continue;
+
+		records.Close(current);
+
+		if (IsTarget(current))
+		{
+			remaining--;
+
+			// Start nodes are never checked by the forward search, but nothing may walk on through one the filter rejects
+			if (current != goalNode && (!canTraverse(current) || current->clearance < agentRadius))
+				continue;
+		}
+
+		lastExpanded++;
+
+		// Expand to the nodes a forward step into current could come from
+		for (PathNode* neighbor : grid->Neighbors(current))
+		{
+			if (records.IsClosed(neighbor))
+				continue;
+
+			if (!IsTarget(neighbor) && (!canTraverse(neighbor) || neighbor->clearance < agentRadius))
+				continue;
+
+			float stepCost = StepCost(neighbor, current, canTraverse);
+			if (stepCost == std::numeric_limits<float>::infinity())
+				continue;
+
+			float tentativeG = records.Get(current).gCost + stepCost;
+
+			NodeRecord& rec = records.Get(neighbor);
+			if (tentativeG >= rec.gCost)
+				continue;
+
+			rec.parent = current;
+			rec.gCost = tentativeG;
+			rec.hCost = estimate(neighbor);
+			rec.fCost = rec.gCost + rec.hCost;
+
+			openQueue.push({ neighbor, rec.fCost });
+		}
+	}
+
+	// Parents point towards the goal, so every path is read from its start and turned around
+	for (size_t i = 0; i < startNodes.size(); i++)
+	{
+		PathNode* start = startNodes[i];
+		if (!start || !records.IsClosed(start))
+			continue;
+
+		outDists[i] = records.At(start).gCost;
+		paths[i] = ReconstructPath(records, start);
+		std::reverse(paths[i].begin(), paths[i].end());
+	}
+
+	return paths;
 }
 
-float AStar::Heuristic(PathNode* a, PathNode* b)
+template<typename Records, typename Filter>
+std::vector<PathNode*> AStar::SearchClosestPathReverse(Records& records, PathNode* startNode, const std::vector<PathNode*>& possibleEndNodes, float& outDist, float agentRadius, const Filter& canTraverse)
+{
+	records.NewSearch(grid->GetRows() * grid->GetCols());
+	lastExpanded = 0;
+	MarkTargets(possibleEndNodes);
+
+	outDist = -1;
+	if (startNode == nullptr)
+		return std::vector<PathNode*>();
+
+	if (IsTarget(startNode))
+	{
+		outDist = 0;
+		return std::vector<PathNode*>{ startNode };
+	}
+
+	OpenQueue openQueue;
+
+	// Every end node the forward search could enter starts the search, all heading for the single start node
+	// The heuristic estimates the path still missing, which runs from the start to the node
+	for (PathNode* target : possibleEndNodes)
+	{
+		if (!target || !canTraverse(target) || target->clearance < agentRadius)
+			continue;
+
+		NodeRecord& rec = records.Get(target);
+		if (rec.gCost == 0.0f)
+			continue;
+
+		rec.gCost = 0.0f;
+		rec.hCost = Heuristic(startNode, target);
+		rec.fCost = rec.hCost;
+		rec.parent = nullptr;
+
+		openQueue.push({ target, rec.fCost });
+	}
+
+	while (!openQueue.empty())
+	{
+		OpenEntry entry = openQueue.top();
+		openQueue.pop();
+
+		PathNode* current = entry.node;
+
+		// Ignore stale queue entries
+		if (records.IsClosed(current) || records.Get(current).fCost != entry.f)
+			continue;
+
+		// Parents point towards the end node the start was reached from
+		if (current == startNode)
+		{
+			outDist = records.At(current).gCost;
+			std::vector<PathNode*> path = ReconstructPath(records, current);
+			std::reverse(path.begin(), path.end());
+			return path;
+		}
+
+		records.Close(current);
+		lastExpanded++;
+
+		// Expand to the nodes a forward step into current could come from
+		for (PathNode* neighbor : grid->Neighbors(current))
+		{
+			if (records.IsClosed(neighbor))
+				continue;
+
+			// The start itself is never checked by the forward search
+			if (neighbor != startNode && (!canTraverse(neighbor) || neighbor->clearance < agentRadius))
+				continue;
+
+			float stepCost = StepCost(neighbor, current, canTraverse);
+			if (stepCost == std::numeric_limits<float>::infinity())
+				continue;
+
+			float tentativeG = records.Get(current).gCost + stepCost;
+
+			NodeRecord& rec = records.Get(neighbor);
+			if (tentativeG >= rec.gCost)
+				continue;
+
+			rec.parent = current;
+			rec.gCost = tentativeG;
+			rec.hCost = Heuristic(startNode, neighbor);
+			rec.fCost = rec.gCost + rec.hCost;
+
+			openQueue.push({ neighbor, rec.fCost });
+		}
+	}
+
+	return std::vector<PathNode*>();
+}
+
+template<typename Records, typename Filter>
+std::vector<AStar::ClosestTarget> AStar::SearchClosestTargets(Records& records, PathNode* startNode, const std::vector<PathNode*>& possibleEndNodes, size_t count, float agentRadius, const Filter& canTraverse)
+{
+	records.NewSearch(grid->GetRows() * grid->GetCols());
+	lastExpanded = 0;
+	MarkTargets(possibleEndNodes);
+
+	std::vector<ClosestTarget> found;
+	if (startNode == nullptr || count == 0)
+		return found;
+
+	OpenQueue openQueue;
+
+	NodeRecord& startRec = records.Get(startNode);
+	startRec.gCost = 0.0f;
+	startRec.fCost = 0.0f;
+	startRec.parent = nullptr;
+	openQueue.push({ startNode, 0.0f });
+
+	// Without a heuristic nodes are closed in order of their distance, so end nodes are found closest first
+	while (!openQueue.empty() && found.size() < count)
+	{
+		OpenEntry entry = openQueue.top();
+		openQueue.pop();
+
+		PathNode* current = entry.node;
+
+		if (records.IsClosed(current) || records.Get(current).fCost != entry.f)
+			continue;
+
+		if (IsTarget(current))
+			found.push_back({ current, records.At(current).gCost });
+
+		records.Close(current);
+		lastExpanded++;
+
+		for (PathNode* neighbor : grid->Neighbors(current))
+		{
+			if (records.IsClosed(neighbor))
+				continue;
+
+			if (!canTraverse(neighbor) || neighbor->clearance < agentRadius)
+				continue;
+
+			float stepCost = StepCost(current, neighbor, canTraverse);
+			if (stepCost == std::numeric_limits<float>::infinity())
+				continue;
+
+			float tentativeG = records.Get(current).gCost + stepCost;
+
+			NodeRecord& rec = records.Get(neighbor);
+			if (tentativeG >= rec.gCost)
+				continue;
+
+			rec.parent = current;
+			rec.gCost = tentativeG;
+			rec.fCost = tentativeG;
+
+			openQueue.push({ neighbor, rec.fCost });
+		}
+	}
+
+	return found;
+}
+
+template<typename Filter>
+float AStar::StepCost(PathNode* from, PathNode* to, const Filter& canTraverse)
+{
+	int cols = grid->GetCols();
+	int fromId = grid->IdOf(from);
+	int toId = grid->IdOf(to);
+	bool diagonal = fromId % cols != toId % cols && fromId / cols != toId / cols;
+
+	if (diagonal)
+	{
+		int sideA = fromId - fromId % cols + toId % cols;
+		int sideB = toId - toId % cols + fromId % cols;
+
+		if (!Accepts(canTraverse, sideA) || !Accepts(canTraverse, sideB))
+			return std::numeric_limits<float>::infinity();
+	}
+
+	float edgeCost = diagonal ? 1.41421356f : 1.0f;
+	return edgeCost / SurfaceSpeed(grid->GetTerrain(toId));
+}
+
+float AStar::Octile(PathNode* a, PathNode* b)
 {
 	float tileSize = grid->GetCellSize();
 
@@ -278,6 +817,64 @@ float AStar::Heuristic(PathNode* a, PathNode* b)
 	return D * (std::max(dx, dy)) + (D2 - D) * std::min(dx, dy);
 }
 
+float AStar::ConsistentHeuristic(PathNode* a, PathNode* b)
+{
+	float octile = grid->OctileCells(a, b);
+	if (landmarks)
+		return std::max(octile, landmarks->LowerBound(a, b));
+	return octile;
+}
+
+void AStar::MarkTargets(const std::vector<PathNode*>& targets)
+{
+	size_t nodeCount = grid->GetRows() * grid->GetCols();
+	if (targetMarks.size() < nodeCount)
+		targetMarks.resize(nodeCount, 0);
+
+	if (targetGeneration == std::numeric_limits<uint32_t>::max())
+	{
+		std::fill(targetMarks.begin(), targetMarks.end(), 0);
+		targetGeneration = 0;
+	}
+	targetGeneration++;
+
+	for (PathNode* target : targets)
+		if (target)
+			targetMarks[target->id] = targetGeneration;
+}
+
+float AStar::BestHeuristic(PathNode* a, const std::vector<PathNode*>& possibleb)
+{
+	float smallest = std::numeric_limits<float>::max();
+	for (PathNode* b : possibleb)
+	{
+		float h = Heuristic(a, b);
+		if (h < smallest)
+			smallest = h;
+	}
+	return smallest;
+}
+
+float AStar::Heuristic(PathNode* a, PathNode* b)
+{
+	float octile = Octile(a, b);
+	if (landmarks)
+		return std::max(octile, landmarks->LowerBound(a, b));
+	return octile;
+}
+
+void AStar::MeasureLandmarks(int count)
+{
+	ownLandmarks = std::make_unique<Landmarks>(grid, count);
+	landmarks = ownLandmarks.get();
+}
+
+void AStar::OnNodeChanged(const PathNode* node)
+{
+	if (ownLandmarks)
+		ownLandmarks->OnNodeChanged(node);
+}
+
 std::vector<PathNode*> AStar::RequestPath(PathNode* startNode, PathNode* endNode, float& outDist, float agentRadius, const NodeFilter& canTraverse)
 {
 	return FindPath(startNode, endNode, outDist, agentRadius, canTraverse);
@@ -287,3 +884,23 @@ std::vector<PathNode*> AStar::RequestClosestPath(PathNode* startNode, const std:
 {
 	return FindClosestPath(startNode, possibleEndNodes, outDist, agentRadius, canTraverse);
 }
+
+std::vector<std::vector<PathNode*>> AStar::RequestPaths(const std::vector<PathNode*>& startNodes, PathNode* endNode, std::vector<float>& outDists, float agentRadius, const NodeFilter& canTraverse)
+{
+	PathNode* goalNode = ResolveGoalNode(*grid, endNode, agentRadius);
+	if (goalNode == nullptr)
+	{
+		outDists.assign(startNodes.size(), -1);
+		lastExpanded = 0;
+		return std::vector<std::vector<PathNode*>>(startNodes.size());
+	}
+
+	return WithFilter(canTraverse, [&](const auto& filter)
+		{
+			if (storage == RecordStorage::Flat)
+				return SearchPathsReverse(flatRecords, startNodes, goalNode, outDists, agentRadius, filter);
+
+			NodeRecordMap records;
+			return SearchPathsReverse(records, startNodes, goalNode, outDists, agentRadius, filter);
+		});
+}
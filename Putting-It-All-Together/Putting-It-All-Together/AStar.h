@@ -1,35 +1,221 @@
 #pragma once
 #include "Pathfinder.h"
 #include "Grid.h"
+#include "Landmarks.h"
+#include "TraversalFilters.h"
 #include <functional>
+#include <memory>
+#include <queue>
 
 using NodeFilter = std::function<bool(const PathNode*)>;
 
+// Get the node a path to desired should end at
+// --------------------------
+// grid - the grid desired is a node of
+// desired - reference to the requested end node
+// agentRadius - radius of the agent that will walk the path
+// --------------------------
+// returns desired if the agent fits on it, otherwise the closest neighbor it fits on (may be nullptr)
+PathNode* ResolveGoalNode(const Grid& grid, PathNode* desired, float agentRadius);
+
 class AStar : public Pathfinder
 {
 public:
-	AStar(Grid* grid) : grid(grid) { }
+	// Container used for the per-node search records
+	enum class RecordStorage
+	{
+		HashMap, // unordered_map/unordered_set allocated for every search
+		Flat     // reusable array indexed by PathNode::id
+	};
+
+	// Progress of a search
+	enum class SearchStatus
+	{
+		Running,
+		Found,
+		Failed
+	};
+
+	// How RequestClosestPath looks for the closest of several end nodes
+	enum class ClosestSearch
+	{
+		PerTarget,  // forwards from the start, every pushed node estimated towards every end node
+		MultiSource // backwards from all end nodes at once towards the start, as cheap as a single search
+	};
+
+	// An end node found by FindClosestTargets
+	struct ClosestTarget
+	{
+		PathNode* node;
+		float dist; // length of the path from the start
+	};
+
+	using OpenQueue = std::priority_queue<OpenEntry, std::vector<OpenEntry>, OpenEntryCompare>;
+
+	// A search spread over several calls of StepSearch, keeps its records and open list between calls
+	struct SlicedSearch
+	{
+		PathNode* startNode = nullptr;
+		PathNode* goalNode = nullptr; // resolved goal, nullptr if the agent fits nowhere near the requested one
+		float agentRadius = 0;
+		NodeFilter canTraverse;
+
+		NodeRecordArray records;
+		OpenQueue openQueue;
+
+		SearchStatus status = SearchStatus::Failed;
+		int expanded = 0;
+	};
+
+	AStar(Grid* grid, RecordStorage storage = RecordStorage::Flat) : grid(grid), storage(storage) { }
 
 	// Overrides base RequestPath
 	std::vector<PathNode*> RequestPath(PathNode* startNode, PathNode* endNode, float& outDist, float agentRadius, const NodeFilter& canTraverse) override;
 	std::vector<PathNode*> RequestClosestPath(PathNode* startNode, const std::vector<PathNode*>& possibleEndNodes, float& outDist, float agentRadius, const NodeFilter& canTraverse) override;
 
-	// Buffer between RequestPath and calculations
+	// Overrides base RequestPaths, one search backwards from the end node that stops once every start node is settled
+	// The search heads for the box around the start nodes, so it pays off most for agents leaving from the same area
+	std::vector<std::vector<PathNode*>> RequestPaths(const std::vector<PathNode*>& startNodes, PathNode* endNode, std::vector<float>& outDists, float agentRadius, const NodeFilter& canTraverse) override;
+
+	// Overrides base OnNodeChanged, repairs the landmark tables measured by MeasureLandmarks
+	void OnNodeChanged(const PathNode* node) override;
+
+	// Buffer between RequestPath and calculations, runs the search compiled for the filter canTraverse holds (see TraversalFilters.h)
 	std::vector<PathNode*> FindPath(PathNode* startNode, PathNode* endNode, float& outDist, float agentRadius, const NodeFilter& canTraverse);
 	std::vector<PathNode*> FindClosestPath(PathNode* startNode, const std::vector<PathNode*>& possibleEndNodes, float& outDist, float agentRadius, const NodeFilter& canTraverse);
 
-	float BestHeuristic(PathNode* a, std::vector<PathNode*> possibleb);
+	// Get the closest end nodes from startNode with a single Dijkstra search, for handing out several targets at once
+	// --------------------------
+	// possibleEndNodes - the candidate end nodes, duplicates are returned once
+	// count - the most end nodes to return, the search stops as soon as this many are found
+	// --------------------------
+	// returns the reachable end nodes ordered from the closest, at most count of them
+	std::vector<ClosestTarget> FindClosestTargets(PathNode* startNode, const std::vector<PathNode*>& possibleEndNodes, size_t count, float agentRadius, const NodeFilter& canTraverse);
+
+	// Start a search that is advanced by StepSearch, the records of search are reused
+	// --------------------------
+	// search - the search to (re)start
+	void BeginSearch(SlicedSearch& search, PathNode* startNode, PathNode* endNode, float agentRadius, const NodeFilter& canTraverse);
+
+	// Expand at most maxExpansions nodes of a search started by BeginSearch
+	// --------------------------
+	// returns the amount of nodes expanded
+	int StepSearch(SlicedSearch& search, int maxExpansions);
+
+	// Get the path of a search that finished with SearchStatus::Found
+	// --------------------------
+	// outDist - output parameter to receive the distance of the path, -1 if there is none
+	std::vector<PathNode*> GetSearchPath(const SlicedSearch& search, float& outDist);
+
+	float BestHeuristic(PathNode* a, const std::vector<PathNode*>& possibleb);
 
 	// Get the heuristic between a and b
 	// --------------------------
-	// a - reference to the first node
-	// b - reference to the second node
+	// a - reference to the node the path starts at
+	// b - reference to the node the path ends at
 	// --------------------------
-	// returns the heuristic between a and b
+	// returns the estimated length of the path from a to b, the octile distance raised by the landmark bound if set
 	float Heuristic(PathNode* a, PathNode* b);
 
+	// Use the lower bounds of landmarks next to the octile distance, nullptr for the octile distance only
+	// The tables must measure the grid this AStar searches
+	void SetLandmarks(const Landmarks* table) { landmarks = table; }
+	const Landmarks* GetLandmarks() const { return landmarks; }
+
+	// Use landmark tables of this AStar's own, measured on its grid and repaired by OnNodeChanged,
+	// for a grid no shared tables follow like the copies of PathRequestQueue's workers
+	void MeasureLandmarks(int count);
+
+	void SetRecordStorage(RecordStorage newStorage) { storage = newStorage; }
+	RecordStorage GetRecordStorage() const { return storage; }
+
+	void SetClosestSearch(ClosestSearch newClosestSearch) { closestSearch = newClosestSearch; }
+	ClosestSearch GetClosestSearch() const { return closestSearch; }
+
+	// Search from both ends at once when the octile distance between start and goal is above threshold cells, 0 never does
+	void SetBidirectionalThreshold(float threshold) { bidirectionalThreshold = threshold; }
+	float GetBidirectionalThreshold() const { return bidirectionalThreshold; }
+
+	// Get the amount of nodes the latest bidirectional search expanded from the start and from the goal, 0 if it was not bidirectional
+	int GetLastForwardExpanded() const { return lastForwardExpanded; }
+	int GetLastBackwardExpanded() const { return lastBackwardExpanded; }
+
+	// Get the amount of bidirectional searches since the AStar was created, and their expansions per direction
+	long long GetBidirectionalSearches() const { return bidirectionalSearches; }
+	long long GetForwardExpandedTotal() const { return forwardExpandedTotal; }
+	long long GetBackwardExpandedTotal() const { return backwardExpandedTotal; }
+
 	// Overrides base GetName
 	std::string GetName() const override { return "A-star Search"; }
 private:
+	// The searches below are compiled for every filter type WithFilter hands them, and for both record storages
+
+	// Expand nodes of a search in progress until the goal is popped, the open list runs out or maxExpansions is spent
+	template<typename Records, typename Filter>
+	SearchStatus Expand(Records& records, OpenQueue& openQueue, PathNode* goalNode, float agentRadius, const Filter& canTraverse, int maxExpansions, int& expanded);
+
+	template<typename Records, typename Filter>
+	std::vector<PathNode*> SearchPath(Records& records, PathNode* startNode, PathNode* goalNode, float& outDist, float agentRadius, const Filter& canTraverse);
+
+	// New Bidirectional A* (NBA*): both searches close nodes into one shared set and reject the nodes
+	// whose bounds show they cannot improve the best path met so far, it is optimal once either open list runs out
+	template<typename Records, typename Filter>
+	std::vector<PathNode*> SearchBidirectional(Records& forward, Records& backward, PathNode* startNode, PathNode* goalNode, float& outDist, float agentRadius, const Filter& canTraverse);
+
+	template<typename Records, typename Filter>
+	std::vector<std::vector<PathNode*>> SearchPathsReverse(Records& records, const std::vector<PathNode*>& startNodes, PathNode* goalNode, std::vector<float>& outDists, float agentRadius, const Filter& canTraverse);
+
+	template<typename Records, typename Filter>
+	std::vector<PathNode*> SearchClosestPath(Records& records, PathNode* startNode, const std::vector<PathNode*>& possibleEndNodes, float& outDist, float agentRadius, const Filter& canTraverse);
+
+	template<typename Records, typename Filter>
+	std::vector<PathNode*> SearchClosestPathReverse(Records& records, PathNode* startNode, const std::vector<PathNode*>& possibleEndNodes, float& outDist, float agentRadius, const Filter& canTraverse);
+
+	template<typename Records, typename Filter>
+	std::vector<ClosestTarget> SearchClosestTargets(Records& records, PathNode* startNode, const std::vector<PathNode*>& possibleEndNodes, size_t count, float agentRadius, const Filter& canTraverse);
+
+	// Get the cost of stepping from a node to its neighbor, infinite if the step cuts a corner canTraverse rejects
+	// Whether the neighbor itself may be entered is left to the caller
+	template<typename Filter>
+	float StepCost(PathNode* from, PathNode* to, const Filter& canTraverse);
+
+	// Check the node with an id against a filter
+	// The filters of TraversalFilters.h are answered from the grid layers and the id, without loading the node
+	bool Accepts(const TerrainFilter& canTraverse, int id) const { return !grid->IsObstacle(id); }
+	bool Accepts(const MaskFilter& canTraverse, int id) const { return canTraverse.usable[id] != 0; }
+	template<typename Filter>
+	bool Accepts(const Filter& canTraverse, int id) const { return canTraverse(grid->GetNode(id)); }
+
+	// Get the octile distance between a and b in cells
+	float Octile(PathNode* a, PathNode* b);
+
+	// Get a heuristic that never overestimates a single step, measured in cells from the node ids
+	// Heuristic divides positions by the integer cell size and comes out a little high, which NBA* cannot take:
+	// it rejects nodes on the heuristic bounds and would lose the shortest path
+	float ConsistentHeuristic(PathNode* a, PathNode* b);
+
+	// Flag the end nodes of a multi-goal search, replacing the previous flags
+	void MarkTargets(const std::vector<PathNode*>& targets);
+	bool IsTarget(const PathNode* node) const { return targetMarks[node->id] == targetGeneration; }
+
 	Grid* grid;
+	RecordStorage storage;
+	ClosestSearch closestSearch = ClosestSearch::MultiSource;
+	const Landmarks* landmarks = nullptr;
+	std::unique_ptr<Landmarks> ownLandmarks; // see MeasureLandmarks
+	float bidirectionalThreshold = 0;
+
+	int lastForwardExpanded = 0;
+	int lastBackwardExpanded = 0;
+	long long bidirectionalSearches = 0;
+	long long forwardExpandedTotal = 0;
+	long long backwardExpandedTotal = 0;
+
+	// End node flags indexed by PathNode::id, a node is flagged when its mark equals targetGeneration
+	std::vector<uint32_t> targetMarks;
+	uint32_t targetGeneration = 0;
+
+	// Reused by every search when storage is Flat, the backward half of bidirectional searches uses reverseRecords
+	NodeRecordArray flatRecords;
+	NodeRecordArray reverseRecords;
 };
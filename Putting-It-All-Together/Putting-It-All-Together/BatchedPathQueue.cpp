@@ -0,0 +1,119 @@
+#include "BatchedPathQueue.h"
+#include "GameLoop.h"
+#include "GameAI.h"
+#include "AIBrain.h"
+#include <algorithm>
+
+void BatchedPathQueue::Submit(GameAI* ai, PathNode* startNode, PathNode* endNode, float agentRadius, AIBrain* belief, uint32_t cacheEpoch)
+{
+	if (!ai || !startNode || !endNode)
+		return;
+
+	Cancel(ai);
+
+	Request request;
+	request.ai = ai;
+	request.startNode = startNode;
+	request.endNode = endNode;
+	request.agentRadius = agentRadius;
+	request.belief = belief;
+	request.cacheEpoch = cacheEpoch;
+	request.beliefVersion = belief ? belief->GetBeliefVersion() : 0;
+	requests.push_back(request);
+}
+
+bool BatchedPathQueue::IsPending(const GameAI* ai, const PathNode* endNode) const
+{
+	for (const Request& request : requests)
+		if (request.ai == ai)
+			return request.endNode == endNode;
+	return false;
+}
+
+void BatchedPathQueue::Cancel(const GameAI* ai)
+{
+	closestTargets.erase(ai);
+
+	auto it = std::find_if(requests.begin(), requests.end(), [ai](const Request& request) { return request.ai == ai; });
+	if (it != requests.end())
+		requests.erase(it);
+}
+
+void BatchedPathQueue::Update()
+{
+	GameLoop& game = GameLoop::Instance();
+
+	searchesLastTick = 0;
+	deliveredLastTick = 0;
+
+	// Agents receiving their path may submit again, those requests wait for the next tick
+	std::vector<Request> batch;
+	batch.swap(requests);
+
+	// Requests that can share a search end up next to each other
+	std::stable_sort(batch.begin(), batch.end(), [](const Request& a, const Request& b)
+		{
+			if (a.endNode != b.endNode)
+				return a.endNode < b.endNode;
+			if (a.belief != b.belief)
+				return a.belief < b.belief;
+			return a.agentRadius < b.agentRadius;
+		});
+
+	size_t first = 0;
+	while (first < batch.size())
+	{
+		size_t last = first + 1;
+		while (last < batch.size() && batch[last].endNode == batch[first].endNode &&
+			batch[last].belief == batch[first].belief && batch[last].agentRadius == batch[first].agentRadius)
+			last++;
+
+		const Request& group = batch[first];
+
+		std::vector<PathNode*> starts;
+		for (size_t i = first; i < last; i++)
+			starts.push_back(batch[i].startNode);
+
+		NodeFilter filter;
+		if (group.belief)
+			filter = group.belief->UsableFilter();
+		else
+			filter = TerrainFilter();
+
+		std::vector<float> dists;
+		std::vector<std::vector<PathNode*>> paths;
+		if ((int)starts.size() >= minBatchSize)
+		{
+			paths = pathfinder->RequestPaths(starts, group.endNode, dists, group.agentRadius, filter);
+			searchesLastTick++;
+		}
+		else
+		{
+			paths.resize(starts.size());
+			dists.resize(starts.size());
+			for (size_t i = 0; i < starts.size(); i++)
+				paths[i] = pathfinder->RequestPath(starts[i], group.endNode, dists[i], group.agentRadius, filter);
+			searchesLastTick += (int)starts.size();
+		}
+
+		for (size_t i = first; i < last; i++)
+		{
+			const Request& request = batch[i];
+			std::vector<PathNode*>& path = paths[i - first];
+
+			if (game.pathCache)
+				game.pathCache->Store(request.startNode, request.endNode, request.agentRadius, request.belief, path, dists[i - first], request.cacheEpoch, request.beliefVersion);
+
+			request.ai->ReceivePath(std::move(path), request.belief == nullptr);
+			deliveredLastTick++;
+		}
+
+		first = last;
+	}
+}
+
+std::string BatchedPathQueue::GetStatus() const
+{
+	return "Path requests: " + std::to_string(requests.size()) + " pending, " + std::to_string(deliveredLastTick) + " delivered by " +
+		std::to_string(searchesLastTick) + " searches this tick";
+}
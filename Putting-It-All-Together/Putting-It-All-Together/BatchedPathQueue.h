@@ -0,0 +1,58 @@
+#pragma once
+#include "PathRequestService.h"
+#include "Pathfinder.h"
+#include <vector>
+
+// Path searches collected during a tick and answered together on the next one
+// Requests for the same goal, agent radius and belief share one Pathfinder::RequestPaths call,
+// so the workers a brain sends to the same building on one tick cost a single search.
+// Small groups are searched one agent at a time, a focused search per agent is cheaper than one reaching all of them
+class BatchedPathQueue : public PathRequestService
+{
+public:
+	// Constructor
+	// --------------------------
+	// pathfinder - the pathfinder the batches are handed to, not owned by the queue
+	// minBatchSize - the fewest requests for one goal that share a search
+	BatchedPathQueue(Pathfinder* pathfinder, int minBatchSize) : pathfinder(pathfinder), minBatchSize(minBatchSize) { }
+
+	// Overrides base Submit
+	void Submit(GameAI* ai, PathNode* startNode, PathNode* endNode, float agentRadius, AIBrain* belief, uint32_t cacheEpoch) override;
+
+	// Overrides base IsPending
+	bool IsPending(const GameAI* ai, const PathNode* endNode) const override;
+
+	// Overrides base Cancel
+	void Cancel(const GameAI* ai) override;
+
+	// Overrides base Update, searches every batch and hands the paths to their agents
+	void Update() override;
+
+	// Overrides base GetStatus
+	std::string GetStatus() const override;
+
+	int GetPendingCount() const { return (int)requests.size(); }
+
+	void SetMinBatchSize(int size) { minBatchSize = size; }
+	int GetMinBatchSize() const { return minBatchSize; }
+
+private:
+	struct Request
+	{
+		GameAI* ai = nullptr;
+		PathNode* startNode = nullptr;
+		PathNode* endNode = nullptr;
+		float agentRadius = 0;
+		AIBrain* belief = nullptr;
+		uint32_t cacheEpoch = 0;
+		uint32_t beliefVersion = 0; // of belief at submission, with cacheEpoch decides if the result may be cached
+	};
+
+	Pathfinder* pathfinder;
+	int minBatchSize;
+
+	std::vector<Request> requests; // at most one per agent
+
+	int searchesLastTick = 0;
+	int deliveredLastTick = 0;
+};
@@ -4,6 +4,7 @@
 #include "GameAI.h"
 #include "Logger.h"
 #include "GameLoop.h"
+#include "PathSmoothing.h"
 
 Behaviour::Behaviour(GameAI* parentAI)
 {
@@ -233,6 +234,42 @@ Behaviour::Info Behaviour::Persue(float deltaTime, float predictionTime)
 	return Persue(deltaTime, ai->GetMovingTarget(), predictionTime);
 }
 
+void Behaviour::RefineNextSegment()
+{
+	if (pathIndex < 0 || pathIndex >= refinedFrom || pathIndex + 1 >= (int)path.size())
+		return;
+
+	GameLoop& game = GameLoop::Instance();
+	PathNode* from = path[pathIndex + 1];
+	PathNode* to = path[pathIndex];
+
+	if (game.GetGrid().AreNeighbors(from, to))
+	{
+		refinedFrom = pathIndex;
+		return;
+	}
+
+	NodeFilter filter = pathFilter;
+	if (!filter)
+		filter = TerrainFilter();
+
+	std::vector<PathNode*> segment = game.pathfinder->RefineSegment(from, to, ai->GetRadius(), filter);
+	if (segment.size() < 2)
+	{
+		path.clear();
+		pathIndex = -1;
+		return;
+	}
+
+	if (game.COMPACT_PATHS)
+		CompactPath(game.GetGrid(), segment, ai->GetRadius(), filter);
+
+	// segment runs from to back to from, the cells between them go between the two path entries
+	path.insert(path.begin() + pathIndex + 1, segment.begin() + 1, segment.end() - 1);
+	refinedFrom = pathIndex;
+	pathIndex += (int)segment.size() - 2;
+}
+
 Behaviour::Info Behaviour::FollowPath(float deltaTime)
 {
 	GameAI* ai = dynamic_cast<GameAI*>(this->ai);
@@ -278,7 +315,16 @@ Behaviour::Info Behaviour::FollowPath(float deltaTime)
 	if (DistanceBetween(ai->GetPosition(), path[pathIndex]->position) < 10)
 	{
 		if (pathIndex > 0)
+		{
 			pathIndex--;
+			RefineNextSegment();
+
+			if (path.empty())
+			{
+				ai->SetState(GameAI::State::STATE_IDLE, "path blocked");
+				return Info{ Vec2(0,0), 0.0f };
+			}
+		}
 		/*if (pathIndex < 0)
 		{
 			ai->SetState(GameAI::State::STATE_IDLE, "arrived");
@@ -1,12 +1,14 @@
 #pragma once
 #include <iostream> 
 #include <string>
+#include <limits>
 #include "Constants.h"
 #include "Vec2.h"
 #include "Renderer.h"
 #include "Movable.h"
 #include "GameAI.h"
 #include "PathNode.h"
+#include "Pathfinder.h"
 
 class GameAI;
 
@@ -49,7 +51,19 @@ public:
     bool AtTarget();
     bool GetDebugTarget(Vec2& out) { (void)out; return false; }
 
-    void SetPath(std::vector<PathNode*> path) { this->path = path; pathIndex = path.size() - 1; }
+    // Set the path to follow, ordered from the destination back to the start
+    // --------------------------
+    // path - the nodes to walk, nodes further ahead may be waypoints that are refined when reached, moved from
+    // filter - the filter the path was planned with, used to refine waypoints
+    // refinedFrom - the path is walkable from the start up to this index without refining, see RefinedFrom,
+    // by default every waypoint that is not adjacent to the one before it is refined
+    void SetPath(std::vector<PathNode*> path, NodeFilter filter = nullptr, int refinedFrom = std::numeric_limits<int>::max())
+    {
+        this->path = std::move(path);
+        pathIndex = (int)this->path.size() - 1;
+        pathFilter = std::move(filter);
+        this->refinedFrom = refinedFrom;
+    }
 
     PathNode* GetDestinationNode()
     {
@@ -58,13 +72,19 @@ public:
         return path.back();
 	}
 
-    std::vector<PathNode*> GetPath() { return path; }
+    const std::vector<PathNode*>& GetPath() const { return path; }
 
 private:
     void UpdateLoggerWithDiscrepancies(GameAI::State state);
 
+    // Ask the pathfinder for the cells up to the next waypoint if it is not adjacent and not refined yet
+    // The cells are compacted like the rest of the path when GameLoop::COMPACT_PATHS is on
+    void RefineNextSegment();
+
     std::vector<PathNode*> path;
     int pathIndex = -1;
+    NodeFilter pathFilter;
+    int refinedFrom = 0; // the path entries from here to the start were refined, compacted ones are not adjacent
 
     GameAI* ai = nullptr;
     GameAI::State previousState = GameAI::State::STATE_IDLE;
@@ -0,0 +1,241 @@
+#include "DStarLite.h"
+#include "AStar.h"
+#include <limits>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const float INF = std::numeric_limits<float>::infinity();
+}
+
+void DStarLite::Initialize(PathNode* startNode, PathNode* endNode, float agentRadius, const NodeFilter& canTraverse)
+{
+	cols = grid->GetCols();
+	size_t nodeCount = grid->GetRows() * cols;
+
+	requestedGoal = endNode;
+	goal = ResolveGoalNode(*grid, endNode, agentRadius);
+	start = startNode;
+	lastStart = startNode;
+	radius = agentRadius;
+	filter = canTraverse;
+	km = 0;
+	totalExpanded = 0;
+
+	g.assign(nodeCount, INF);
+	rhs.assign(nodeCount, INF);
+	queuedKey.assign(nodeCount, Key(INF, INF));
+	queued.assign(nodeCount, 0);
+	open = decltype(open)();
+
+	if (goal == nullptr || start == nullptr)
+		return;
+
+	rhs[goal->id] = 0;
+	Push(goal->id);
+}
+
+void DStarLite::MoveStart(PathNode* startNode)
+{
+	if (startNode == nullptr || startNode == start)
+		return;
+
+	start = startNode;
+
+	// Keys already in the queue were computed from the old start, km keeps them comparable
+	if (goal != nullptr)
+		km += grid->OctileCells(lastStart, start);
+	lastStart = start;
+}
+
+void DStarLite::NodeChanged(const PathNode* node)
+{
+	if (goal == nullptr || node == nullptr)
+		return;
+
+	// The goal is moved when the agent stops or starts fitting on the requested one, the costs all lead to the old goal
+	if (node == requestedGoal || grid->AreNeighbors(node, requestedGoal))
+	{
+		if (ResolveGoalNode(*grid, requestedGoal, radius) != goal)
+		{
+			Initialize(start, requestedGoal, radius, NodeFilter(filter));
+			return;
+		}
+	}
+
+	// Entering node and the diagonal steps cutting past it all start at one of its neighbors
+	UpdateVertex(node->id);
+	for (PathNode* neighbor : grid->Around(node))
+		UpdateVertex(neighbor->id);
+}
+
+int DStarLite::ComputeShortestPath()
+{
+	if (goal == nullptr || start == nullptr)
+		return 0;
+
+	int expanded = 0;
+
+	while (!open.empty())
+	{
+		QueueEntry top = open.top();
+
+		// Ignore stale queue entries
+		if (!queued[top.id] || queuedKey[top.id] != top.key)
+		{
+			open.pop();
+			continue;
+		}
+
+		// Done once nothing cheaper than the start is queued and the start itself is consistent. The first
+		// halves are compared with a tolerance, a node on the start's best path sums its g and heuristic in
+		// another order and can land a rounding error above the start, which would leave it unrepaired
+		Key startKey = CalculateKey(start->id);
+		bool cheaper = top.key.first < startKey.first - 1e-3f
+			|| (top.key.first <= startKey.first + 1e-3f && top.key.second < startKey.second);
+		if (!cheaper && rhs[start->id] == g[start->id])
+			break;
+
+		open.pop();
+		queued[top.id] = 0;
+
+		Key newKey = CalculateKey(top.id);
+		if (top.key < newKey)
+		{
+			Push(top.id);
+			continue;
+		}
+
+		expanded++;
+		PathNode* node = NodeOf(top.id);
+
+		if (g[top.id] > rhs[top.id])
+		{
+			g[top.id] = rhs[top.id];
+		}
+		else
+		{
+			g[top.id] = INF;
+			UpdateVertex(top.id);
+		}
+
+		for (PathNode* neighbor : grid->Neighbors(node))
+			UpdateVertex(neighbor->id);
+	}
+
+	totalExpanded += expanded;
+	return expanded;
+}
+
+std::vector<PathNode*> DStarLite::GetPath(float& outDist) const
+{
+	std::vector<PathNode*> path;
+
+	if (goal == nullptr || start == nullptr || g[start->id] == INF)
+	{
+		outDist = -1;
+		return path;
+	}
+
+	// Walk downhill from the start, every step to the neighbor with the cheapest remaining cost
+	PathNode* current = start;
+	path.push_back(current);
+
+	size_t maxSteps = g.size();
+	while (current != goal && path.size() <= maxSteps)
+	{
+		PathNode* best = nullptr;
+		float bestCost = INF;
+		for (PathNode* neighbor : grid->Neighbors(current))
+		{
+			float cost = Cost(current, neighbor) + g[neighbor->id];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				best = neighbor;
+			}
+		}
+
+		if (best == nullptr)
+		{
+			outDist = -1;
+			return std::vector<PathNode*>();
+		}
+
+		current = best;
+		path.push_back(current);
+	}
+
+	if (current != goal)
+	{
+		outDist = -1;
+		return std::vector<PathNode*>();
+	}
+
+	std::reverse(path.begin(), path.end());
+
+	outDist = g[start->id];
+	return path;
+}
+
+float DStarLite::Cost(const PathNode* from, const PathNode* to) const
+{
+	// Same rules as AStar, the goal may be entered even if the filter rejects it
+	if (to != goal && !filter(to))
+		return INF;
+
+	if (to->clearance < radius)
+		return INF;
+
+	int row = from->id / cols;
+	int col = from->id % cols;
+	int toRow = to->id / cols;
+	int toCol = to->id % cols;
+
+	bool diagonal = row != toRow && col != toCol;
+	if (diagonal)
+	{
+		if (!filter(grid->GetNode(row, toCol)) || !filter(grid->GetNode(toRow, col)))
+			return INF;
+	}
+
+	float edgeCost = diagonal ? 1.41421356f : 1.0f;
+	return edgeCost / SurfaceSpeed(to->type);
+}
+
+DStarLite::Key DStarLite::CalculateKey(int id) const
+{
+	float best = std::min(g[id], rhs[id]);
+	return Key(best + grid->OctileCells(start, NodeOf(id)) + km, best);
+}
+
+void DStarLite::UpdateVertex(int id)
+{
+	if (id != goal->id)
+	{
+		PathNode* node = NodeOf(id);
+
+		float best = INF;
+		for (PathNode* neighbor : grid->Neighbors(node))
+		{
+			float cost = Cost(node, neighbor);
+			if (cost != INF)
+				best = std::min(best, cost + g[neighbor->id]);
+		}
+		rhs[id] = best;
+	}
+
+	if (g[id] != rhs[id])
+		Push(id);
+	else
+		queued[id] = 0;
+}
+
+void DStarLite::Push(int id)
+{
+	Key key = CalculateKey(id);
+	queued[id] = 1;
+	queuedKey[id] = key;
+	open.push({ key, id });
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "Pathfinder.h"
+#include "Grid.h"
+#include <queue>
+#include <utility>
+
+// Incremental search towards one goal (D* Lite)
+// The search runs backwards from the goal and keeps its costs between calls, so when the agent moves
+// or nodes start answering the filter differently only the costs that depend on them are repaired
+class DStarLite
+{
+public:
+	DStarLite(Grid* grid) : grid(grid) { }
+
+	// Start over with a new goal
+	// --------------------------
+	// startNode - the node the agent stands on
+	// endNode - the node to walk to, moved to a neighbor if it is too narrow for the agent
+	// canTraverse - filter for the nodes that may be walked through, may answer differently later if NodeChanged is called
+	void Initialize(PathNode* startNode, PathNode* endNode, float agentRadius, const NodeFilter& canTraverse);
+
+	// Move the start of the search to where the agent stands now
+	void MoveStart(PathNode* startNode);
+
+	// Tell the search that the filter or terrain of node changed
+	void NodeChanged(const PathNode* node);
+
+	// Repair the costs until the start is consistent
+	// --------------------------
+	// returns the amount of nodes expanded
+	int ComputeShortestPath();
+
+	// Get the path from the start to the goal after ComputeShortestPath
+	// --------------------------
+	// outDist - output parameter to receive the distance of the path, -1 if there is no path
+	// --------------------------
+	// returns the path ordered from the goal to the start like Pathfinder::RequestPath
+	std::vector<PathNode*> GetPath(float& outDist) const;
+
+	// Get the goal requested in Initialize
+	PathNode* GetRequestedGoal() const { return requestedGoal; }
+	PathNode* GetStart() const { return start; }
+
+	// Get the amount of nodes expanded since Initialize
+	int GetTotalExpanded() const { return totalExpanded; }
+
+private:
+	using Key = std::pair<float, float>;
+
+	struct QueueEntry
+	{
+		Key key;
+		int id;
+
+		bool operator>(const QueueEntry& other) const { return key > other.key; }
+	};
+
+	// Get the cost of stepping from one node to a neighbor, infinite if the step is not allowed
+	float Cost(const PathNode* from, const PathNode* to) const;
+
+	Key CalculateKey(int id) const;
+	void UpdateVertex(int id);
+	void Push(int id);
+
+	PathNode* NodeOf(int id) const { return grid->GetNode(id); }
+
+	Grid* grid;
+	int cols = 0;
+
+	PathNode* requestedGoal = nullptr;
+	PathNode* goal = nullptr;
+	PathNode* start = nullptr;
+	PathNode* lastStart = nullptr;
+	float radius = 0;
+	NodeFilter filter;
+	float km = 0;
+
+	std::vector<float> g;
+	std::vector<float> rhs;
+	std::vector<Key> queuedKey;
+	std::vector<uint8_t> queued;
+	std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> open;
+
+	int totalExpanded = 0;
+};
@@ -0,0 +1,138 @@
+#include "FlowField.h"
+#include "AStar.h"
+#include "AIBrain.h"
+#include <queue>
+#include <limits>
+#include <algorithm>
+
+void FlowField::Build(Grid* grid, PathNode* goalNode, float agentRadius, const NodeFilter& canTraverse)
+{
+	this->grid = grid;
+	goal = ResolveGoalNode(*grid, goalNode, agentRadius);
+	settled = 0;
+
+	int rows = grid->GetRows();
+	int cols = grid->GetCols();
+
+	cost.assign(rows * cols, std::numeric_limits<float>::max());
+	next.assign(rows * cols, -1);
+
+	if (goal == nullptr)
+		return;
+
+	std::priority_queue<OpenEntry, std::vector<OpenEntry>, OpenEntryCompare> openQueue;
+
+	cost[goal->id] = 0.0f;
+	next[goal->id] = goal->id;
+	openQueue.push({ goal, 0.0f });
+
+	// Search backwards from the goal, relaxing the step from every neighbor onto the settled node
+	while (!openQueue.empty())
+	{
+		OpenEntry entry = openQueue.top();
+		openQueue.pop();
+
+		PathNode* current = entry.node;
+
+		// Ignore stale queue entries
+		if (cost[current->id] != entry.f)
+			continue;
+
+		settled++;
+
+		// Nodes the agent may not walk into can still start a path, but no path passes through them
+		if (current != goal && (!canTraverse(current) || current->clearance < agentRadius))
+			continue;
+
+		int row = current->id / cols;
+		int col = current->id % cols;
+
+		float terrainPenalty = 1 / SurfaceSpeed(current->type);
+
+		for (PathNode* neighbor : grid->Neighbors(current))
+		{
+			int nRow = neighbor->id / cols;
+			int nCol = neighbor->id % cols;
+			bool diagonal = nRow != row && nCol != col;
+
+			// Same corner rule as AStar, both sides of a diagonal step must be traversable
+			if (diagonal && (!canTraverse(grid->GetNode(nRow, col)) || !canTraverse(grid->GetNode(row, nCol))))
+				continue;
+
+			float edgeCost = diagonal ? 1.41421356f : 1.0f;
+			float tentative = cost[current->id] + edgeCost * terrainPenalty;
+
+			if (tentative >= cost[neighbor->id])
+				continue;
+
+			cost[neighbor->id] = tentative;
+			next[neighbor->id] = current->id;
+			openQueue.push({ neighbor, tentative });
+		}
+	}
+}
+
+std::vector<PathNode*> FlowField::ExtractPath(PathNode* startNode, float& outDist) const
+{
+	std::vector<PathNode*> path;
+
+	if (startNode == nullptr || goal == nullptr || next[startNode->id] == -1)
+	{
+		outDist = -1;
+		return path;
+	}
+
+	for (int id = startNode->id; ; id = next[id])
+	{
+		path.push_back(grid->GetNode(id));
+		if (id == goal->id)
+			break;
+	}
+
+	std::reverse(path.begin(), path.end());
+
+	outDist = cost[startNode->id];
+	return path;
+}
+
+float FlowField::GetCost(const PathNode* node) const
+{
+	if (node == nullptr || goal == nullptr || next[node->id] == -1)
+		return -1;
+
+	return cost[node->id];
+}
+
+const FlowField& FlowFieldCache::GetField(PathNode* goal, const AIBrain* owner, float agentRadius, const NodeFilter& canTraverse)
+{
+	lookups++;
+
+	Key key(goal, owner, agentRadius);
+	auto it = fields.find(key);
+
+	if (it == fields.end())
+	{
+		if (fields.size() >= MAX_FIELDS)
+		{
+			auto oldest = std::min_element(fields.begin(), fields.end(),
+				[](const auto& a, const auto& b) { return a.second.lastUsed < b.second.lastUsed; });
+			fields.erase(oldest);
+		}
+
+		it = fields.emplace(key, Entry()).first;
+		it->second.beliefVersion = owner->GetBeliefVersion() - 1;
+	}
+
+	Entry& entry = it->second;
+	entry.lastUsed = ++useCounter;
+
+	if (entry.beliefVersion != owner->GetBeliefVersion() || entry.terrainVersion != terrainVersion)
+	{
+		entry.field.Build(grid, goal, agentRadius, canTraverse);
+		entry.beliefVersion = owner->GetBeliefVersion();
+		entry.terrainVersion = terrainVersion;
+		builds++;
+	}
+
+	return entry.field;
+}
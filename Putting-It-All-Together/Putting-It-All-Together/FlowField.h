@@ -0,0 +1,89 @@
+#pragma once
+#include "Pathfinder.h"
+#include "Grid.h"
+#include <map>
+#include <tuple>
+
+class AIBrain;
+
+// Integration field towards a single goal
+// Every cell that can reach the goal stores the cost of walking there and the next cell to step to,
+// so any amount of agents can read their path off the field without running a search
+class FlowField
+{
+public:
+	// Build the field with the same movement rules as AStar
+	// --------------------------
+	// goal - the node to walk to, moved to a neighbor if it is too narrow for the agent
+	// canTraverse - filter for the nodes that may be walked through
+	void Build(Grid* grid, PathNode* goal, float agentRadius, const NodeFilter& canTraverse);
+
+	// Get the path from startNode to the goal of the field
+	// --------------------------
+	// outDist - output parameter to receive the distance of the path, -1 if there is no path
+	// --------------------------
+	// returns the path ordered from the goal to startNode like Pathfinder::RequestPath, empty if the goal can't be reached
+	std::vector<PathNode*> ExtractPath(PathNode* startNode, float& outDist) const;
+
+	// Get the cost of walking from node to the goal of the field
+	// --------------------------
+	// returns -1 if the goal can't be reached from node
+	float GetCost(const PathNode* node) const;
+
+	PathNode* GetGoal() const { return goal; }
+
+	// Get the amount of nodes settled while building the field
+	int GetSettled() const { return settled; }
+
+private:
+	Grid* grid = nullptr;
+	PathNode* goal = nullptr;
+	std::vector<float> cost; // cost of walking from a cell to the goal
+	std::vector<int> next;   // id of the cell to step to, -1 if the goal can't be reached
+	int settled = 0;
+};
+
+// Flow fields shared by every agent of a brain that walks to the same destination
+// A field is rebuilt when the brain's belief of the map or the terrain changed since it was built
+class FlowFieldCache
+{
+public:
+	FlowFieldCache(Grid* grid) : grid(grid) { }
+
+	// Get the field towards goal as seen by owner
+	// --------------------------
+	// owner - the brain whose CanUseNode canTraverse asks
+	// canTraverse - filter for the nodes that may be walked through
+	// --------------------------
+	// returns the cached field, rebuilt first if it is stale
+	const FlowField& GetField(PathNode* goal, const AIBrain* owner, float agentRadius, const NodeFilter& canTraverse);
+
+	// Called by the grid when the terrain of a node changes, every field is rebuilt on its next use
+	void OnNodeChanged(const PathNode* node) { terrainVersion++; }
+
+	int GetLookups() const { return lookups; }
+	int GetBuilds() const { return builds; }
+
+private:
+	struct Entry
+	{
+		FlowField field;
+		uint32_t beliefVersion = 0;
+		uint32_t terrainVersion = 0;
+		uint64_t lastUsed = 0;
+	};
+
+	using Key = std::tuple<const PathNode*, const AIBrain*, float>;
+
+	// The amount of fields kept before the least recently used is dropped
+	static constexpr size_t MAX_FIELDS = 16;
+
+	Grid* grid;
+	std::map<Key, Entry> fields;
+
+	uint32_t terrainVersion = 0;
+	uint64_t useCounter = 0;
+
+	int lookups = 0;
+	int builds = 0;
+};
@@ -4,6 +4,8 @@
 #include "Behaviour.h"
 #include "AIBrain.h"
 #include "PathNode.h"
+#include "DStarLite.h"
+#include "PathSmoothing.h"
 
 
 GameAI::GameAI(Vec2 pos) :
@@ -29,6 +31,8 @@ GameAI::~GameAI()
 {
 	if (behaviour)
 		delete behaviour;
+	if (replanner)
+		delete replanner;
 }
 
 void GameAI::SetState(State state, std::string meta)
@@ -80,14 +84,16 @@ bool GameAI::CanGoTo(PathNode* destination, float& dist)
 		return false;
 
 	GameLoop& game = GameLoop::Instance();
-	Pathfinder* pathfinder = game.pathfinder;
 	PathNode* currNode = game.GetGrid().GetNodeAt(position);
 	float pathDist = 0;
 	std::vector<PathNode*> path;
 
-	auto filter = [this](const PathNode* node) { return connectedBrain->CanUseNode(node); };
+	if (!connectedBrain->GetReachability()->MayReach(currNode, destination, radius))
+		return false;
+
+	NodeFilter filter = connectedBrain->UsableFilter();
 
-	path = pathfinder->RequestPath(currNode, destination, pathDist, radius, filter);
+	path = game.pathCache->RequestPath(currNode, destination, pathDist, radius, filter, connectedBrain);
 	dist = pathDist;
 
 	if (path.empty())
@@ -104,31 +110,101 @@ void GameAI::GoTo(PathNode* destination, bool &isPathValid, bool ignoreFog)
 		return;
 
 	GameLoop& game = GameLoop::Instance();
-	Pathfinder* pathfinder = game.pathfinder;
 	PathNode* currNode = game.GetGrid().GetNodeAt(position);
 	float pathDist = 0;
 	std::vector<PathNode*> path;
 
-	if (!ignoreFog && connectedBrain)
+	NodeFilter filter = PathFilter(ignoreFog);
+	AIBrain* belief = ignoreFog ? nullptr : connectedBrain; // the terrain-only filter is shared by every agent
+
+	// A destination in another component can never be reached, no search needed to tell
+	Reachability* reachability = belief ? belief->GetReachability() : game.reachability;
+	if (reachability && !reachability->MayReach(currNode, destination, radius))
+	{
+		isPathValid = false;
+		return;
+	}
+
+	// Buildings are walked to by many agents, read the path off the brain's shared flow field instead of searching
+	// When requests are batched the agents heading to a building on the same tick already share a search
+	if (belief && belief->GetBuild()->IsBuildingNode(destination) && game.PATH_REQUEST_MODE != GameLoop::PathRequestMode::Batched)
+	{
+		// Built buildings keep their own field, which task assignment reads distances from as well
+		const FlowField* field = belief->GetBuild()->GetDistanceField(destination, radius);
+		if (!field)
+			field = &game.flowFields->GetField(destination, belief, radius, filter);
+		path = field->ExtractPath(currNode, pathDist);
+	}
+	else if (belief && game.PATH_REQUEST_MODE == GameLoop::PathRequestMode::Incremental)
+	{
+		path = Replan(currNode, destination, pathDist);
+	}
+	else if (game.pathRequests)
 	{
-		auto filter = [this](const PathNode* node) { return connectedBrain->CanUseNode(node); };
-		path = pathfinder->RequestPath(currNode, destination, pathDist, radius, filter);
+		if (!game.pathCache->Find(currNode, destination, radius, belief, path, pathDist))
+		{
+			// Searched by the request service, the path arrives through ReceivePath on a later tick
+			if (!game.pathRequests->IsPending(this, destination))
+				game.pathRequests->Submit(this, currNode, destination, radius, belief, game.pathCache->GetEpoch());
+			isPathValid = true;
+			return;
+		}
 	}
 	else
 	{
-		auto filter = [this](const PathNode* node) { return !node->IsObstacle(); };
-		path = pathfinder->RequestPath(currNode, destination, pathDist, radius, filter);
+		path = game.pathCache->RequestPath(currNode, destination, pathDist, radius, filter, belief);
 	}
 
+	isPathValid = ReceivePath(std::move(path), ignoreFog);
+}
+
+bool GameAI::ReceivePath(std::vector<PathNode*> path, bool ignoreFog)
+{
 	if (path.empty())
+		return false;
+
+	GameLoop& game = GameLoop::Instance();
+	NodeFilter filter = PathFilter(ignoreFog);
+
+	// Waypoints before refinedFrom are refined while the agent walks, compacting keeps them where they are
+	int refinedFrom = RefinedFrom(game.GetGrid(), path);
+	if (game.COMPACT_PATHS)
+		CompactPath(game.GetGrid(), path, radius, filter);
+
+	SetState(State::STATE_FOLLOW_PATH, "goto");
+	behaviour->SetPath(std::move(path), std::move(filter), refinedFrom);
+	return true;
+}
+
+std::vector<PathNode*> GameAI::Replan(PathNode* startNode, PathNode* destination, float& outDist)
+{
+	const std::vector<const PathNode*>& changes = connectedBrain->GetNodeChanges();
+
+	if (!replanner)
+		replanner = new DStarLite(&GameLoop::Instance().GetGrid());
+
+	if (replanner->GetRequestedGoal() != destination)
 	{
-		isPathValid = false;
-		return;
+		replanner->Initialize(startNode, destination, radius, PathFilter(false));
 	}
+	else
+	{
+		replanner->MoveStart(startNode);
+		for (size_t i = replannerChangesSeen; i < changes.size(); i++)
+			replanner->NodeChanged(changes[i]);
+	}
+	replannerChangesSeen = changes.size();
 
-	SetState(State::STATE_FOLLOW_PATH, "goto");
-	behaviour->SetPath(path);
-	isPathValid = true;
+	replanner->ComputeShortestPath();
+	return replanner->GetPath(outDist);
+}
+
+NodeFilter GameAI::PathFilter(bool ignoreFog)
+{
+	if (!ignoreFog && connectedBrain)
+		return connectedBrain->UsableFilter();
+
+	return TerrainFilter();
 }
 
 //void GameAI::GoToClosest(PathNode::ResourceType destinationType, bool& isPathValid)
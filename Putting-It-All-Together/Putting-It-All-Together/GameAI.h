@@ -8,10 +8,12 @@
 #include "Movable.h"
 #include "Logger.h"
 #include "Grid.h"
+#include "Pathfinder.h"
 
 
 class Behaviour;
 class AIBrain;
+class DStarLite;
 
 class GameAI : public Movable
 {
@@ -42,6 +44,14 @@ public:
 
 	void GoTo(PathNode* destination, bool& isPathValid, bool ignoreFog = false);
 
+	// Start following a path found by GoTo or delivered by the PathRequestQueue
+	// --------------------------
+	// path - the path ordered like Pathfinder::RequestPath, compacted and moved into the behaviour
+	// ignoreFog - if the path was searched without the brain's belief
+	// --------------------------
+	// returns false if the path is empty
+	bool ReceivePath(std::vector<PathNode*> path, bool ignoreFog);
+
 	//void GoToClosest(PathNode::ResourceType destinationType, bool& isPathValid);
 
 	//void GoToClosest(std::vector<PathNode::ResourceType> destinationTypes, bool& isPathValid);
@@ -59,6 +69,12 @@ public:
 	void ConnectBrain(AIBrain* brain) { connectedBrain = brain; }
 
 private:
+	// Get the filter paths of this agent are searched with
+	NodeFilter PathFilter(bool ignoreFog);
+
+	// Get the path to destination from the agent's DStarLite, repaired with the belief changes since the last call
+	std::vector<PathNode*> Replan(PathNode* startNode, PathNode* destination, float& outDist);
+
 	Vec2 targetPos;
 	Movable* targetMovable = nullptr;
 
@@ -69,6 +85,9 @@ private:
 
 	Behaviour* behaviour;
 
+	DStarLite* replanner = nullptr;
+	size_t replannerChangesSeen = 0; // entries of AIBrain::GetNodeChanges the replanner has been told about
+
 	float BEHAVIOUR_WEIGHT = 1;
 	float SEPARATION_WEIGHT = 0; // recommended value: 2.0
 	float AGENTAVOIDANCE_WEIGHT = 0.0f; // recommended value: 2.0
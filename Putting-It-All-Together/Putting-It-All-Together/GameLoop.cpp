@@ -5,38 +5,47 @@
 #include "GameLoop.h"
 #include "Constants.h"
 #include "AStar.h"
+#include "JumpPointSearch.h"
+#include "HierarchicalPathfinder.h"
+#include "ThetaStar.h"
+#include "PathBenchmark.h"
 #include <sstream>
 #include <filesystem>
 #include "AIBrainManagers.h"
 #include "Movable.h"
+#include "MapFile.h"
 
 
-static std::string LoadDataFile(const std::string& filename)
-{
-	std::string result;
-	std::ifstream file(filename);
-	if (!file) return result;
-
-	char c;
-	while (file.get(c))
-	{
-		if (c == ' ' || c == '\n') continue;
-		result += c;
-	}
-
-	file.close();
-
-	return result;
-}
-
-static std::string LoadMap()
+static Grid LoadGrid()
 { 
 	std::string dataPath = "Map";
-	std::string mapPath = "map.txt";
+	std::string textPath = dataPath + "/map.txt";
+	std::string binaryPath = dataPath + "/map.bin";
+	const int mapCols = 100;
 	// Ensure directory exists (create if missing) 
 	std::error_code ec; std::filesystem::create_directories(dataPath, ec); // create if needed
-	std::string fileName = dataPath + "/" + mapPath;
-	return LoadDataFile(fileName);
+
+	// The text map is the one edited by hand, convert it again whenever it is newer than the binary map
+	bool textExists = std::filesystem::exists(textPath, ec);
+	bool binaryCurrent = std::filesystem::exists(binaryPath, ec) &&
+		(!textExists || std::filesystem::last_write_time(binaryPath, ec) >= std::filesystem::last_write_time(textPath, ec));
+	if (!binaryCurrent && textExists)
+		binaryCurrent = MapFile::ConvertText(textPath, binaryPath, mapCols);
+
+	for (int attempt = 0; attempt < 2 && binaryCurrent; attempt++)
+	{
+		{
+			MappedFile file(binaryPath);
+			MapView map;
+			if (MapFile::Read(file, map))
+				return Grid(WORLD_WIDTH, WORLD_HEIGHT, map);
+		}
+
+		// A binary map of another version, cut short or corrupt is written again from the text map, once unmapped
+		binaryCurrent = attempt == 0 && textExists && MapFile::ConvertText(textPath, binaryPath, mapCols);
+	}
+
+	return Grid(WORLD_WIDTH, WORLD_HEIGHT, mapCols, MapFile::ReadText(textPath));
 }
 
 void GameLoop::RefreshScreen()
@@ -50,17 +59,52 @@ void GameLoop::RefreshScreen()
 	}
 }
 
-GameLoop::GameLoop() : grid(WORLD_WIDTH, WORLD_HEIGHT, 100, LoadMap()), random(Seed(1))
+GameLoop::GameLoop() : grid(LoadGrid()), random(Seed(1))
 {
 	Movable::baseRadius = grid.cellSize / 5;
 
-	pathfinder = new AStar(&grid);
+	gameThread = std::this_thread::get_id();
+
+	if (LANDMARK_COUNT > 0)
+		landmarks = new Landmarks(&grid, LANDMARK_COUNT);
+
+	reachability = new Reachability(&grid, TerrainFilter());
+
+	pathfinder = CreatePathfinder(&grid);
+	pathCache = new PathCache(pathfinder);
+	flowFields = new FlowFieldCache(&grid);
+
+	if (PATH_REQUEST_MODE == PathRequestMode::Threaded)
+		pathRequests = new PathRequestQueue(&grid, [this](Grid* searchGrid) { return CreatePathfinder(searchGrid); }, PATH_DELIVERIES_PER_FRAME);
+	else if (PATH_REQUEST_MODE == PathRequestMode::TimeSliced)
+		pathRequests = new SlicedPathQueue(&grid, PATH_EXPANSIONS_PER_FRAME);
+	else if (PATH_REQUEST_MODE == PathRequestMode::Batched)
+		pathRequests = new BatchedPathQueue(pathfinder, PATH_BATCH_MIN_AGENTS);
 
 	// create renderer and start window
 	renderer = new Renderer(WINDOW_WIDTH, WINDOW_HEIGHT);
 	renderer->Start();
 }
 
+Pathfinder* GameLoop::CreatePathfinder(Grid* searchGrid)
+{
+	if (PATHFINDER_TYPE == PathfinderType::JumpPoint)
+		return new JumpPointSearch(searchGrid);
+	if (PATHFINDER_TYPE == PathfinderType::Hierarchical)
+		return new HierarchicalPathfinder(searchGrid);
+	if (PATHFINDER_TYPE == PathfinderType::ThetaStar)
+		return new ThetaStar(searchGrid);
+
+	// The shared landmark tables follow the live grid, a worker's copy of the grid gets tables of its own
+	AStar* astar = new AStar(searchGrid);
+	if (landmarks && searchGrid == &grid)
+		astar->SetLandmarks(landmarks);
+	else if (LANDMARK_COUNT > 0)
+		astar->MeasureLandmarks(LANDMARK_COUNT);
+	astar->SetBidirectionalThreshold(BIDIRECTIONAL_THRESHOLD);
+	return astar;
+}
+
 GameLoop::~GameLoop()
 {
 	if (renderer)
@@ -78,7 +122,24 @@ void GameLoop::DeleteAll()
 		delete player;
 	player = nullptr;
 
+	// Stop the workers before anything they deliver to is deleted
+	delete pathRequests;
+	pathRequests = nullptr;
+
 	delete pathfinder;
+	pathfinder = nullptr;
+
+	delete pathCache;
+	pathCache = nullptr;
+
+	delete flowFields;
+	flowFields = nullptr;
+
+	delete landmarks;
+	landmarks = nullptr;
+
+	delete reachability;
+	reachability = nullptr;
 
 	if (brain)
 		delete brain;
@@ -115,7 +176,7 @@ void GameLoop::InitializeGame()
 	{
 		for (int c = 0; c < grid.GetCols(); c++)
 		{
-			PathNode& pathNode = grid.GetNodes()[r][c];
+			PathNode& pathNode = *grid.GetNode(r, c);
 			float xPos = pathNode.position.x - pathNode.size;
 			float yPos = pathNode.position.y - pathNode.size;
 			float height = pathNode.size * 2;
@@ -151,11 +212,10 @@ void GameLoop::InitializeGame()
 			int c = random.NextFloat01() * grid.GetCols();
 			int r = random.NextFloat01() * grid.GetRows();
 
-			PathNode& node = grid.GetNodes()[r][c];
+			PathNode& node = *grid.GetNode(r, c);
 			if (node.resource == PathNode::ResourceType::None && !node.IsObstacle() && !brain->NodeToKnown(&node).discovered)
 			{
-				node.resource = PathNode::ResourceType::Iron;
-				node.resourceAmount = 1;
+				grid.SetNode(&node, PathNode::ResourceType::Iron, 1);
 				setIron = true;
 			}
 		}
@@ -259,12 +319,18 @@ void GameLoop::UpdateGameLoop(float delta, double timePassed)
 
 	ExecuteDeathRow();
 
+	if (pathRequests)
+		pathRequests->Update();
+
 	HandlePlayerInput(delta);
 
 	if (brain)
 		brain->Think(delta);
 
-	for (Movable* m : GetMovables())
+	std::vector<Movable*> movables = GetMovables();
+	grid.RebuildMovableIndex(movables);
+
+	for (Movable* m : movables)
 	{
 		m->Update(delta);
 	}
@@ -348,6 +414,17 @@ void GameLoop::UpdateRenderer()
 			str5
 		};
 
+		if (DEBUG_MODE && pathCache)
+			overlay.push_back("Path cache: " + std::to_string(pathCache->GetHits()) + " hits, " + std::to_string(pathCache->GetMisses()) + " misses");
+		if (DEBUG_MODE && pathRequests)
+			overlay.push_back(pathRequests->GetStatus());
+
+		AStar* astar = dynamic_cast<AStar*>(pathfinder);
+		if (DEBUG_MODE && astar && astar->GetBidirectionalSearches() > 0)
+			overlay.push_back("Bidirectional A*: " + std::to_string(astar->GetBidirectionalSearches()) + " searches, " +
+				std::to_string(astar->GetForwardExpandedTotal()) + " expanded from the start, " +
+				std::to_string(astar->GetBackwardExpandedTotal()) + " from the goal");
+
 		renderer->SetOverlayLines(debugOverlay, overlay);
 	}
 
@@ -466,6 +543,13 @@ void GameLoop::KeyPressed()
 		Logger::Instance().Log(std::string("Placing Resources: ") + (placingResource ? "ON\n" : "OFF\n"));
 	}
 
+	if (renderer->IsKeyDown(SDL_SCANCODE_B))
+	{
+		keyPressCooldown = 0.2f;
+		Logger::Instance().Log("Running pathfinding benchmarks\n");
+		PathBenchmark::RunAll(grid);
+	}
+
 	if (renderer->IsKeyDown(SDL_SCANCODE_1))
 	{
 		if (currentPlacingType + 1 >= PathNode::TypeEnd)
@@ -599,6 +683,9 @@ void GameLoop::ExecuteDeathRow()
 
 			persistentEnts.push_back(te);
 
+			if (pathRequests)
+				pathRequests->Cancel(ai);
+
 			delete ai;
 			aiList.erase(it);
 		}
@@ -608,17 +695,26 @@ void GameLoop::ExecuteDeathRow()
 
 void GameLoop::AddDebugEntity(Vec2 pos, uint32_t color, int radius, bool filled)
 {
+	if (std::this_thread::get_id() != gameThread)
+		return;
+
 	Renderer::Entity te = Renderer::Entity::MakeCircle(pos.x, pos.y, radius, color, filled);
 	debugEnts.push_back(te);
 }
 
 void GameLoop::AddDebugEntity(Renderer::Entity e)
 {
+	if (std::this_thread::get_id() != gameThread)
+		return;
+
 	debugEnts.push_back(e);
 }
 
 void GameLoop::AddDebugLine(Vec2 a, Vec2 b, uint32_t color, float thickness)
 {
+	if (std::this_thread::get_id() != gameThread)
+		return;
+
 	Renderer::Entity e = Renderer::Entity::MakeLine(a.x, a.y, b.x, b.y, thickness, color);
 	debugEnts.push_back(e);
 }
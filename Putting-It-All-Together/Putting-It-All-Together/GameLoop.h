@@ -10,14 +10,41 @@
 #include "Player.h"
 #include "Grid.h"
 #include "Pathfinder.h"
+#include "FlowField.h"
+#include "Landmarks.h"
+#include "Reachability.h"
+#include "PathCache.h"
+#include "PathRequestQueue.h"
+#include "SlicedPathQueue.h"
+#include "BatchedPathQueue.h"
 #include "AIBrain.h"
 #include "random.h"
 
 #include <SDL3/SDL.h>
+#include <thread>
 
 class GameLoop
 {
 public:
+	// Pathfinders the game can be constructed with
+	enum class PathfinderType
+	{
+		AStar,
+		JumpPoint,
+		Hierarchical,
+		ThetaStar // any-angle paths with few waypoints
+	};
+
+	// Ways GameAI::GoTo gets paths that are not cached
+	enum class PathRequestMode
+	{
+		Immediate,  // searched inside GoTo
+		Threaded,   // searched by PathRequestQueue worker threads
+		TimeSliced, // searched by SlicedPathQueue, a budget of nodes per tick
+		Incremental, // repaired by a DStarLite per agent as the brain's belief or the terrain changes
+		Batched      // collected by BatchedPathQueue, one search per goal for all agents heading there on a tick
+	};
+
 	static GameLoop& Instance()
 	{
 		static GameLoop instance_;
@@ -50,8 +77,22 @@ public:
 
 	bool DEBUG_MODE = false;
 	bool USE_FOG_OF_WAR = true;
-
-	Pathfinder* pathfinder;
+	PathfinderType PATHFINDER_TYPE = PathfinderType::AStar;
+	PathRequestMode PATH_REQUEST_MODE = PathRequestMode::Threaded;
+	int PATH_DELIVERIES_PER_FRAME = 16;   // Threaded
+	int PATH_EXPANSIONS_PER_FRAME = 4000; // TimeSliced
+	int PATH_BATCH_MIN_AGENTS = 6;        // Batched, fewer agents heading to one goal are searched one by one
+	int LANDMARK_COUNT = 8; // landmarks of the ALT heuristic used by AStar, 0 keeps the octile heuristic
+	float BIDIRECTIONAL_THRESHOLD = 50; // octile cells between start and goal above which AStar searches from both ends, 0 never
+	                                    // PathBenchmark::Bidirectional: trips to the Storage break even at 50, other pairs stay faster forward
+	bool COMPACT_PATHS = true; // agents follow paths with the nodes on straight lines dropped, see CompactPath
+
+	Pathfinder* pathfinder = nullptr;
+	PathCache* pathCache = nullptr;
+	PathRequestService* pathRequests = nullptr;
+	FlowFieldCache* flowFields = nullptr;
+	Landmarks* landmarks = nullptr;
+	Reachability* reachability = nullptr; // components of the terrain, for paths that ignore fog of war
 	Renderer* renderer;
 
 	void ScheduleDeath(GameAI* ai) { deathRow.push_back(ai); }
@@ -72,6 +113,12 @@ private:
 	void HandlePlayerInput(float delta);
 	void ExecuteDeathRow();
 
+	// Create a pathfinder of PATHFINDER_TYPE searching grid
+	Pathfinder* CreatePathfinder(Grid* grid);
+
+	// Debug drawing from other threads is dropped
+	std::thread::id gameThread;
+
 	float keyPressCooldown = 0.0f;
 	PathNode::Type currentPlacingType = PathNode::Rock;
 	PathNode::ResourceType currentPlacingResourceType = PathNode::None;
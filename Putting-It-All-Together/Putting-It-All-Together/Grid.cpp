@@ -1,6 +1,84 @@
 #include "Grid.h"
 #include "GameLoop.h"
+#include "MapFile.h"
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <thread>
+
+namespace
+{
+	const float FAR = std::numeric_limits<float>::infinity();
+
+	// Boxes of at least this many cells get their clearance computed on several threads
+	const int PARALLEL_CELLS = 1 << 18;
+
+	// One dimensional squared distance transform (Felzenszwalb & Huttenlocher): d[q] = min over p of (q - p)^2 + f[p]
+	// Builds the lower envelope of the parabolas rooted at the samples left to right, then reads it off in one sweep
+	// --------------------------
+	// f - n samples, infinite ones root no parabola
+	// d - n outputs, infinite if every sample is
+	// v, z - scratch of n and n + 1 entries
+	void DistanceTransform(const float* f, float* d, int n, int* v, double* z)
+	{
+		int k = -1;
+		for (int q = 0; q < n; q++)
+		{
+			if (f[q] == FAR)
+				continue;
+
+			// Drop the parabolas the new one hides completely
+			double s = -std::numeric_limits<double>::infinity();
+			while (k >= 0)
+			{
+				s = ((f[q] + (double)q * q) - (f[v[k]] + (double)v[k] * v[k])) / (2.0 * (q - v[k]));
+				if (s > z[k])
+					break;
+				k--;
+			}
+			if (k < 0)
+				s = -std::numeric_limits<double>::infinity();
+
+			k++;
+			v[k] = q;
+			z[k] = s;
+			z[k + 1] = std::numeric_limits<double>::infinity();
+		}
+
+		if (k < 0)
+		{
+			std::fill(d, d + n, FAR);
+			return;
+		}
+
+		int j = 0;
+		for (int q = 0; q < n; q++)
+		{
+			while (z[j + 1] < q)
+				j++;
+			float dq = (float)(q - v[j]);
+			d[q] = dq * dq + f[v[j]];
+		}
+	}
+
+	// Run body(begin, end) over the items [0, count), split between the hardware threads if parallel
+	template<typename Body>
+	void ParallelFor(int count, bool parallel, Body body)
+	{
+		int threads = parallel ? (int)std::min(std::thread::hardware_concurrency(), 8u) : 1;
+		if (threads <= 1 || count < threads)
+		{
+			body(0, count);
+			return;
+		}
+
+		std::vector<std::thread> workers;
+		for (int t = 0; t < threads; t++)
+			workers.emplace_back(body, count * t / threads, count * (t + 1) / threads);
+		for (std::thread& worker : workers)
+			worker.join();
+	}
+}
 
 Grid::Grid(int width, int height, int inputCellSize, Vec2 gridSize)
 {
@@ -30,34 +108,83 @@ Grid::Grid(int width, int height, int inputCellSize, Vec2 gridSize)
 
 	if (rows <= 0 || cols <= 0 || cellSize <= 0) return;
 
-	nodes.assign(rows, std::vector<PathNode>(cols));
-	movableLocations.resize(cols * rows);
+	nodes.assign(rows * cols, PathNode());
+	movableStarts.assign(cols * rows + 1, 0);
 
 	for (int r = 0; r < rows; r++)
 	{
 		for (int c = 0; c < cols; c++)
 		{
-			nodes[r][c].position = GetCellCenter(r, c);
-			nodes[r][c].id = nodeIds++;
-			nodes[r][c].size = cellSize / 2;
+			PathNode& node = nodes[Index(c, r)];
+			node.position = GetCellCenter(r, c);
+			node.id = nodeIds++;
+			node.size = cellSize / 2;
 		}
 	}
 
-	SetNeighbors(rows, cols);
+	// Agents are smaller than a cell
+	maxAgentRadius = cellSize;
+
+	BuildLayers();
+	IndexResources();
+	SetNeighbors();
 	SetClearance();
 }
 
 Grid::Grid(int width, int height, int colAmount, std::string map)
 {
-	cols = colAmount;
-	rows = map.size() / colAmount;
+	int mapRows = map.size() / colAmount;
 	if (map.size() % colAmount != 0)
-		rows++;
+		mapRows++;
 
+	//std::reverse(map.begin(), map.end());
+
+	FitCells(width, height, mapRows, colAmount);
+	if (rows <= 0 || cols <= 0 || cellSize <= 0) return;
+
+	size_t cellCount = (size_t)rows * cols;
+	terrain.assign(cellCount, (uint8_t)PathNode::Nothing);
+	resourceTypes.assign(cellCount, (int8_t)PathNode::None);
+	resourceAmounts.assign(cellCount, 0.0f);
+
+	for (size_t id = 0; id < cellCount && id < map.size(); id++)
+	{
+		PathNode::Type type;
+		PathNode::ResourceType resource;
+		MapFile::ParseTextCell(map[id], type, resource);
+
+		terrain[id] = (uint8_t)type;
+		resourceTypes[id] = (int8_t)resource;
+		if (resource != PathNode::None)
+			resourceAmounts[id] = MapFile::TEXT_RESOURCE_AMOUNT;
+	}
+
+	BuildNodes();
+}
+
+Grid::Grid(int width, int height, const MapView& map)
+{
+	FitCells(width, height, map.rows, map.cols);
+	if (rows <= 0 || cols <= 0 || cellSize <= 0) return;
+
+	// The layers are the bytes of the map, only the amounts have to be spread out
+	size_t cellCount = (size_t)rows * cols;
+	terrain.assign(map.terrain, map.terrain + cellCount);
+	resourceTypes.assign((const int8_t*)map.resources, (const int8_t*)map.resources + cellCount);
+	resourceAmounts.resize(cellCount);
+
+	for (size_t id = 0; id < cellCount; id++)
+		resourceAmounts[id] = resourceTypes[id] != (int8_t)PathNode::None ? map.resourceAmount : 0.0f;
+
+	BuildNodes();
+}
+
+void Grid::FitCells(int width, int height, int rowAmount, int colAmount)
+{
 	this->width = width;
 	this->height = height;
-
-	//std::reverse(map.begin(), map.end());
+	rows = rowAmount;
+	cols = colAmount;
 
 	cellSize = std::min<float>((float)height / (float)rows, (float)width / (float)cols);
 
@@ -68,120 +195,165 @@ Grid::Grid(int width, int height, int colAmount, std::string map)
 	float offsetY = (height - actualGridHeight) * 0.5f;
 
 	offsetVector = { offsetX, offsetY };
+}
 
-	int nodeIds = 0;
-
-	if (rows <= 0 || cols <= 0 || cellSize <= 0) return;
-
-	nodes.assign(rows, std::vector<PathNode>(cols));
-	movableLocations.resize(cols * rows);
+void Grid::BuildNodes()
+{
+	nodes.assign(rows * cols, PathNode());
+	movableStarts.assign(cols * rows + 1, 0);
+	clearance.assign(nodes.size(), 0.0f);
 
 	for (int r = 0; r < rows; r++)
 	{
 		for (int c = 0; c < cols; c++)
 		{
-			nodes[r][c].position = GetCellCenter(r, c);
-			nodes[r][c].id = nodeIds++;
-			nodes[r][c].size = cellSize / 2;
-
-			int currIdx = Index(c, r);
-			if (currIdx < map.size())
-			{
-				if (map[currIdx] == 'M')
-				{
-					nodes[r][c].type = PathNode::Grass;
-				}
-				else if (map[currIdx] == 'T')
-				{
-					nodes[r][c].type = PathNode::Grass;
-					nodes[r][c].resource = PathNode::Wood;
-					nodes[r][c].resourceAmount = 5.0f;
-				}
-				else if (map[currIdx] == 'V')
-				{
-					nodes[r][c].type = PathNode::Water;
-				}
-				else if (map[currIdx] == 'G')
-				{
-					nodes[r][c].type = PathNode::Swamp;
-				}
-				else if (map[currIdx] == 'B')
-				{
-					nodes[r][c].type = PathNode::Rock;
-				}
-			}
+			int id = Index(c, r);
+			PathNode& node = nodes[id];
+			node.position = GetCellCenter(r, c);
+			node.id = id;
+			node.size = cellSize / 2;
+			node.type = GetTerrain(id);
+			node.resource = GetResource(id);
+			node.resourceAmount = resourceAmounts[id];
 		}
 	}
 
-	SetNeighbors(rows, cols);
+	// Agents are smaller than a cell
+	maxAgentRadius = cellSize;
+
+	IndexResources();
+	SetNeighbors();
 	SetClearance();
 }
 
-void Grid::SetClearance()
+void Grid::BuildLayers()
 {
-	std::queue<PathNode*> q;
+	terrain.resize(nodes.size());
+	clearance.resize(nodes.size());
+	resourceTypes.resize(nodes.size());
+	resourceAmounts.resize(nodes.size());
 
-	for (int r = 0; r < rows; r++)
+	for (size_t id = 0; id < nodes.size(); id++)
 	{
-		for (int c = 0; c < cols; c++)
-		{
-			PathNode& node = nodes[r][c];
+		terrain[id] = (uint8_t)nodes[id].type;
+		clearance[id] = nodes[id].clearance;
+		resourceTypes[id] = (int8_t)nodes[id].resource;
+		resourceAmounts[id] = nodes[id].resourceAmount;
+	}
+}
 
-			bool isEdge = (r == 0 || r == rows - 1 || c == 0 || c == cols - 1);
+void Grid::IndexResources()
+{
+	resourceIndex.Reset(rows, cols, cellSize, offsetVector);
 
-			if (node.IsObstacle())
-			{
-				node.clearance = 0.0f;
-				q.push(&node);
-			}
-			else if (isEdge)
+	for (size_t id = 0; id < resourceTypes.size(); id++)
+		if (resourceAmounts[id] > 0)
+			resourceIndex.Set((int)id, GetResource((int)id));
+}
+
+void Grid::SetClearance()
+{
+	BoxClearance(0, 0, rows - 1, cols - 1, clearance);
+
+	for (size_t id = 0; id < nodes.size(); id++)
+		nodes[id].clearance = clearance[id];
+}
+
+void Grid::BoxClearance(int top, int left, int bottom, int right, std::vector<float>& out) const
+{
+	int height = bottom - top + 1;
+	int width = right - left + 1;
+	bool parallel = height * width >= PARALLEL_CELLS;
+
+	out.assign(height * width, FAR);
+
+	// Columns: squared distance to the nearest obstacle in the same column
+	ParallelFor(width, parallel, [&](int begin, int end)
+		{
+			std::vector<float> f(height);
+			std::vector<float> d(height);
+			std::vector<int> v(height);
+			std::vector<double> z(height + 1);
+
+			for (int c = begin; c < end; c++)
 			{
-				node.clearance = cellSize;
-				q.push(&node);
+				for (int r = 0; r < height; r++)
+					f[r] = IsObstacle(Index(left + c, top + r)) ? 0.0f : FAR;
+
+				DistanceTransform(f.data(), d.data(), height, v.data(), z.data());
+
+				for (int r = 0; r < height; r++)
+					out[r * width + c] = d[r];
 			}
-			else
+		});
+
+	// Rows: the column distances combine into the squared distance to the nearest obstacle anywhere in the box
+	ParallelFor(height, parallel, [&](int begin, int end)
+		{
+			std::vector<float> d(width);
+			std::vector<int> v(width);
+			std::vector<double> z(width + 1);
+
+			for (int r = begin; r < end; r++)
 			{
-				node.clearance = std::numeric_limits<float>::infinity();
+				float* line = &out[r * width];
+				DistanceTransform(line, d.data(), width, v.data(), z.data());
+
+				int row = top + r;
+				for (int c = 0; c < width; c++)
+				{
+					int col = left + c;
+
+					// The map border counts as a wall of obstacles just outside the grid
+					int border = std::min(std::min(row + 1, rows - row), std::min(col + 1, cols - col));
+					float distance = std::min(std::sqrt(d[c]), (float)border);
+
+					// subtract half cell size so radius doesn't overlap
+					line[c] = std::max(distance * cellSize - cellSize * 0.5f, 0.0f);
+				}
 			}
-		}
-	}
+		});
+}
 
-	while (!q.empty())
-	{
-		PathNode* current = q.front();
-		q.pop();
+void Grid::UpdateClearance(int id)
+{
+	// Clearance below maxAgentRadius comes from an obstacle less than reach cells away,
+	// so only the cells that close to the changed node can change below it
+	int reach = (int)std::ceil(maxAgentRadius / cellSize + 0.5f);
 
-		for (PathNode* n : current->neighbors)
-		{
-			if (!n)
-				continue;
+	int row = id / cols;
+	int col = id % cols;
 
-			float step;
-			if (abs(n->position.x - current->position.x) + abs(n->position.y - current->position.y) == 2)
-				step = cellSize * 1.41421356f;
-			else
-				step = cellSize;
+	int windowTop = std::max(row - reach, 0);
+	int windowBottom = std::min(row + reach, rows - 1);
+	int windowLeft = std::max(col - reach, 0);
+	int windowRight = std::min(col + reach, cols - 1);
 
-			float newClearance = current->clearance + step;
+	// The obstacles within reach of every window cell
+	int top = std::max(windowTop - reach, 0);
+	int bottom = std::min(windowBottom + reach, rows - 1);
+	int left = std::max(windowLeft - reach, 0);
+	int right = std::min(windowRight + reach, cols - 1);
 
-			if (newClearance < n->clearance)
-			{
-				n->clearance = newClearance;
-				q.push(n);
-			}
-		}
-	}
-	for (int r = 0; r < rows; r++)
+	std::vector<float> box;
+	BoxClearance(top, left, bottom, right, box);
+
+	int width = right - left + 1;
+	for (int r = windowTop; r <= windowBottom; r++)
 	{
-		for (int c = 0; c < cols; c++)
+		for (int c = windowLeft; c <= windowRight; c++)
 		{
-			PathNode& node = nodes[r][c];
+			int cell = Index(c, r);
+			float value = box[(r - top) * width + (c - left)];
 
-			// subtract half cell size so radius doesn't overlap
-			node.clearance -= cellSize * 0.5f;
+			if (value == clearance[cell])
+				continue;
+
+			clearance[cell] = value;
+			nodes[cell].clearance = value;
 
-			if (node.clearance < 0.0f)
-				node.clearance = 0.0f;
+			if (cell != id)
+				clearanceChanges.push_back(cell);
 		}
 	}
 }
@@ -208,10 +380,40 @@ void Grid::SetNode(PathNode* node, PathNode::Type type)
 
 	int index = Index(col, row);
 
-	PathNode* baseNode = &nodes.at(row).at(col);
-
-	node->type = type;
+	SetTerrain(node, type);
 	GameLoop::Instance().renderer->MarkNodeDirty(index);
+
+	if (GameLoop::Instance().landmarks)
+		GameLoop::Instance().landmarks->OnNodeChanged(node);
+	if (GameLoop::Instance().reachability)
+		GameLoop::Instance().reachability->OnNodeChanged(node);
+	if (GameLoop::Instance().pathfinder)
+		GameLoop::Instance().pathfinder->OnNodeChanged(node);
+	if (GameLoop::Instance().pathCache)
+		GameLoop::Instance().pathCache->BumpEpoch();
+	if (GameLoop::Instance().flowFields)
+		GameLoop::Instance().flowFields->OnNodeChanged(node);
+	if (GameLoop::Instance().brain)
+	{
+		GameLoop::Instance().brain->GetReachability()->OnNodeChanged(node);
+		GameLoop::Instance().brain->OnTerrainChanged(node);
+	}
+	if (GameLoop::Instance().pathRequests)
+		GameLoop::Instance().pathRequests->OnNodeChanged(node);
+
+	// Services that read clearance also hear about the nodes around whose clearance changed
+	for (int id : clearanceChanges)
+	{
+		if (GameLoop::Instance().reachability)
+			GameLoop::Instance().reachability->OnNodeChanged(&nodes[id]);
+		if (GameLoop::Instance().brain)
+		{
+			GameLoop::Instance().brain->GetReachability()->OnNodeChanged(&nodes[id]);
+			GameLoop::Instance().brain->OnTerrainChanged(&nodes[id]);
+		}
+		if (GameLoop::Instance().pathfinder)
+			GameLoop::Instance().pathfinder->OnNodeChanged(&nodes[id]);
+	}
 }
 
 void Grid::SetNode(PathNode* node, PathNode::ResourceType type, float resourceAmount)
@@ -224,14 +426,38 @@ void Grid::SetNode(PathNode* node, PathNode::ResourceType type, float resourceAm
 
 	WorldToGrid(node->position, row, col);
 
-	PathNode* baseNode = &nodes.at(row).at(col);
-
 	int index = Index(col, row);
 
+	SetResource(node, type, resourceAmount);
+
+	GameLoop::Instance().renderer->MarkNodeDirty(index);
+}
+
+void Grid::SetTerrain(PathNode* node, PathNode::Type type)
+{
+	bool wasObstacle = IsObstacle(node->id);
+
+	node->type = type;
+	terrain[node->id] = (uint8_t)type;
+
+	clearanceChanges.clear();
+
+	// Neighbors and clearance only depend on where the obstacles are
+	if (wasObstacle == IsObstacle(node->id))
+		return;
+
+	SetNeighborMask(*node);
+	UpdateClearance(node->id);
+}
+
+void Grid::SetResource(PathNode* node, PathNode::ResourceType type, float resourceAmount)
+{
 	node->resource = type;
 	node->resourceAmount = resourceAmount;
+	resourceTypes[node->id] = (int8_t)type;
+	resourceAmounts[node->id] = resourceAmount;
 
-	GameLoop::Instance().renderer->MarkNodeDirty(index);
+	resourceIndex.Set(node->id, resourceAmount > 0 ? type : PathNode::None);
 }
 
 PathNode* Grid::GetNodeAt(Vec2 pos)
@@ -242,7 +468,7 @@ PathNode* Grid::GetNodeAt(Vec2 pos)
 	if (!WorldToGrid(pos, row, col))
 		return nullptr;
 
-	return &nodes.at(row).at(col);
+	return &nodes[Index(col, row)];
 }
 
 bool Grid::HasLineOfSight(const Vec2& from, const Vec2& to, float agentRadius) const
@@ -251,6 +477,19 @@ bool Grid::HasLineOfSight(const Vec2& from, const Vec2& to, float agentRadius) c
 	if (!WorldToGrid(from, r0, c0) || !WorldToGrid(to, r1, c1))
 		return false;
 
+	return LineOfSight(r0, c0, r1, c1, agentRadius, nullptr);
+}
+
+bool Grid::HasLineOfSight(const PathNode* from, const PathNode* to, float agentRadius, const std::function<bool(const PathNode*)>& canTraverse) const
+{
+	if (from == nullptr || to == nullptr)
+		return false;
+
+	return LineOfSight(from->id / cols, from->id % cols, to->id / cols, to->id % cols, agentRadius, &canTraverse);
+}
+
+bool Grid::LineOfSight(int r0, int c0, int r1, int c1, float agentRadius, const std::function<bool(const PathNode*)>* canTraverse) const
+{
 	float x0 = c0 + 0.5f;
 	float y0 = r0 + 0.5f;
 	float x1 = c1 + 0.5f;
@@ -292,10 +531,13 @@ bool Grid::HasLineOfSight(const Vec2& from, const Vec2& to, float agentRadius) c
 
 		if (!first)
 		{
-			const PathNode& node = nodes[y][x];
+			int id = Index(x, y);
 
 			// Treat insufficient clearance as blocked
-			if (node.IsObstacle() || node.clearance < agentRadius)
+			if (IsObstacle(id) || clearance[id] < agentRadius)
+				return false;
+
+			if (canTraverse && !(*canTraverse)(&nodes[id]))
 				return false;
 		}
 
@@ -326,11 +568,14 @@ bool Grid::HasLineOfSight(const Vec2& from, const Vec2& to, float agentRadius) c
 				sideX2 < 0 || sideX2 >= cols || sideY2 < 0 || sideY2 >= rows)
 				return false;
 
-			const PathNode& nodeA = nodes[sideY][sideX];
-			const PathNode& nodeB = nodes[sideY2][sideX2];
+			int idA = Index(sideX, sideY);
+			int idB = Index(sideX2, sideY2);
 
-			if (nodeA.IsObstacle() || nodeA.clearance < agentRadius ||
-				nodeB.IsObstacle() || nodeB.clearance < agentRadius)
+			if (IsObstacle(idA) || clearance[idA] < agentRadius ||
+				IsObstacle(idB) || clearance[idB] < agentRadius)
+				return false;
+
+			if (canTraverse && (!(*canTraverse)(&nodes[idA]) || !(*canTraverse)(&nodes[idB])))
 				return false;
 
 			// Now safe to advance diagonally
@@ -344,43 +589,69 @@ bool Grid::HasLineOfSight(const Vec2& from, const Vec2& to, float agentRadius) c
 	return true;
 }
 
-void Grid::SetNeighbors(int rows, int cols)
+void Grid::SetNeighbors()
 {
-	// Set neighbors for each node
-	for (int r = 0; r < rows; r++)
+	// Order of the neighbors will be: 
+	// top left -> top middle -> top right -> 
+	// -> middle left -> skip self -> middler right ->
+	// -> bottom left -> bottom middle -> bottom right
+	int direction = 0;
+	for (int dr = -1; dr <= 1; dr++)
 	{
-		for (int c = 0; c < cols; c++)
+		for (int dc = -1; dc <= 1; dc++)
 		{
-			PathNode& node = nodes[r][c];
-			node.neighbors.clear();
+			if (dr == 0 && dc == 0) continue; // Skip self
 
-			// Obstacles have no neighbors
-			if (node.IsObstacle()) continue;
+			neighborOffsets[direction++] = dr * cols + dc;
+		}
+	}
 
-			// Order of the neighbors will be: 
-			// top left -> top middle -> top right -> 
-			// -> middle left -> skip self -> middler right ->
-			// -> bottom left -> bottom middle -> bottom right
-			for (int dr = -1; dr <= 1; dr++)
-			{
-				for (int dc = -1; dc <= 1; dc++)
-				{
-					if (dr == 0 && dc == 0) continue; // Skip self
+	// Set neighbors for each node
+	for (PathNode& node : nodes)
+		SetNeighborMask(node);
+}
 
-					int neighborRow = r + dr;
-					int neighborCol = c + dc;
+void Grid::SetNeighborMask(PathNode& node)
+{
+	// Obstacles have no neighbors
+	node.neighborMask = IsObstacle(node.id) ? 0 : BoundsMask(node.id);
+}
 
-					// Check bounds
-					if (neighborRow < 0 || neighborRow >= rows || neighborCol < 0 || neighborCol >= cols)
-						continue;
+uint8_t Grid::BoundsMask(int id) const
+{
+	int r = id / cols;
+	int c = id % cols;
 
-					PathNode& neighbor = nodes[neighborRow][neighborCol];
+	uint8_t mask = 0;
+	int direction = 0;
+	for (int dr = -1; dr <= 1; dr++)
+	{
+		for (int dc = -1; dc <= 1; dc++)
+		{
+			if (dr == 0 && dc == 0) continue; // Skip self
 
-					node.neighbors.push_back(&neighbor);
-				}
-			}
+			int neighborRow = r + dr;
+			int neighborCol = c + dc;
+
+			// Check bounds
+			if (neighborRow >= 0 && neighborRow < rows && neighborCol >= 0 && neighborCol < cols)
+				mask |= 1 << direction;
+
+			direction++;
 		}
 	}
+
+	return mask;
+}
+
+bool Grid::AreNeighbors(const PathNode* a, const PathNode* b) const
+{
+	int offset = b->id - a->id;
+	for (int direction = 0; direction < 8; direction++)
+		if ((a->neighborMask & (1 << direction)) && neighborOffsets[direction] == offset)
+			return true;
+
+	return false;
 }
 
 std::vector<float> Grid::GetGlobalGridPosition()
@@ -396,7 +667,7 @@ std::vector<float> Grid::GetGlobalGridPosition()
 	return std::vector<float>{left, bottom, right, top};
 }
 
-Vec2 Grid::GetCellCenter(int row, int col)
+Vec2 Grid::GetCellCenter(int row, int col) const
 {
 	float x = offsetVector.x + (col + 0.5f) * cellSize;
 	float y = offsetVector.y + (row + 0.5f) * cellSize;
@@ -406,24 +677,23 @@ Vec2 Grid::GetCellCenter(int row, int col)
 
 void Grid::QueryEnt(const Vec2& pos, float radius, std::vector<Movable*>& out)
 {
-	int minX = (int)((pos.x - offsetVector.x - radius) / cellSize);
-	int maxX = (int)((pos.x - offsetVector.x + radius) / cellSize);
-	int minY = (int)((pos.y - offsetVector.y - radius) / cellSize);
-	int maxY = (int)((pos.y - offsetVector.y + radius) / cellSize);
+	int minX = std::max((int)((pos.x - offsetVector.x - radius) / cellSize), 0);
+	int maxX = std::min((int)((pos.x - offsetVector.x + radius) / cellSize), cols - 1);
+	int minY = std::max((int)((pos.y - offsetVector.y - radius) / cellSize), 0);
+	int maxY = std::min((int)((pos.y - offsetVector.y + radius) / cellSize), rows - 1);
+	if (minX > maxX || minY > maxY)
+		return;
 
+	// The cells of a row are next to each other in the index, so each row of the box is one range of movables
+	size_t count = 0;
 	for (int cy = minY; cy <= maxY; ++cy)
-		for (int cx = minX; cx <= maxX; ++cx)
-		{
-			if (cx < 0 || cy < 0 || cx >= cols || cy >= rows)
-				continue;
+		count += movableStarts[Index(maxX, cy) + 1] - movableStarts[Index(minX, cy)];
+	out.reserve(out.size() + count);
 
-			for (Movable* m : movableLocations[Index(cx, cy)])
-				out.push_back(m);
-		}
+	for (int cy = minY; cy <= maxY; ++cy)
+		out.insert(out.end(), movableIndex.begin() + movableStarts[Index(minX, cy)], movableIndex.begin() + movableStarts[Index(maxX, cy) + 1]);
 }
 
-// Query special nodes of a certain type within a radius
-// given an unspecified type, it will return all nodes
 void Grid::QueryNodes(const Vec2& pos, float radius, std::vector<PathNode*>& out, PathNode::ResourceType type)
 {
 	int minX = (int)((pos.x - offsetVector.x - radius) / cellSize);
@@ -431,49 +701,50 @@ void Grid::QueryNodes(const Vec2& pos, float radius, std::vector<PathNode*>& out
 	int minY = (int)((pos.y - offsetVector.y - radius) / cellSize);
 	int maxY = (int)((pos.y - offsetVector.y + radius) / cellSize);
 
+	if (type != PathNode::ResourceType::None)
+	{
+		std::vector<int> ids;
+		resourceIndex.QueryCells(std::max(minY, 0), std::max(minX, 0), std::min(maxY, rows - 1), std::min(maxX, cols - 1), type, ids);
+		for (int id : ids)
+			out.push_back(&nodes[id]);
+		return;
+	}
+
 	for (int cy = minY; cy <= maxY; ++cy)
 		for (int cx = minX; cx <= maxX; ++cx)
 		{
 			if (cx < 0 || cy < 0 || cx >= cols || cy >= rows)
 				continue;
 
-			PathNode* loc = &nodes.at(cy).at(cx);
-
-			if (loc == nullptr) 
-				continue;
-
-			if ((loc->resource != type) && type != PathNode::ResourceType::None)
-				continue;
-
-			out.push_back(loc);
+			out.push_back(&nodes[Index(cx, cy)]);
 		}
 }
 
 void Grid::UpdateMovable(Movable* m)
 {
-	int newX, newY;
-	WorldToGrid(m->GetPosition(), newY, newX);
+	int row, col;
+	WorldToGrid(m->GetPosition(), row, col);
+
+	// Movables pushed past the edge are kept in the nearest cell
+	m->cellX = std::clamp(col, 0, cols - 1);
+	m->cellY = std::clamp(row, 0, rows - 1);
+}
 
-	// First-time insert
-	if (m->cellX == -1)
+void Grid::RebuildMovableIndex(const std::vector<Movable*>& movables)
+{
+	// Counting sort by cell: count the movables of each cell, turn the counts into start offsets, then place them
+	movableStarts.assign(rows * cols + 1, 0);
+	for (Movable* m : movables)
 	{
-		movableLocations[Index(newX, newY)].push_back(m);
-		m->cellX = newX;
-		m->cellY = newY;
-		return;
+		UpdateMovable(m);
+		movableStarts[Index(m->cellX, m->cellY) + 1]++;
 	}
 
-	// Same cell -> nothing to do
-	if (m->cellX == newX && m->cellY == newY)
-		return;
-
-	// Remove from old cell
-	auto& oldCell = movableLocations[Index(m->cellX, m->cellY)];
-	oldCell.erase(std::remove(oldCell.begin(), oldCell.end(), m));
-
-	// Add to new cell
-	movableLocations[Index(newX, newY)].push_back(m);
+	for (size_t i = 1; i < movableStarts.size(); i++)
+		movableStarts[i] += movableStarts[i - 1];
 
-	m->cellX = newX;
-	m->cellY = newY;
+	movableFill.assign(movableStarts.begin(), movableStarts.end() - 1);
+	movableIndex.resize(movables.size());
+	for (Movable* m : movables)
+		movableIndex[movableFill[Index(m->cellX, m->cellY)]++] = m;
 }
\ No newline at end of file
@@ -1,9 +1,57 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <functional>
+#include <algorithm>
+#include <cstdlib>
 #include "PathNode.h"
 #include "Vec2.h"
 #include "Movable.h"
+#include "ResourceIndex.h"
+
+struct MapView;
+
+// The neighbors of a node, worked out from its id instead of kept in the node
+// Iterates like a list of PathNode*, in the order of Grid::SetNeighbors
+class NeighborRange
+{
+public:
+	class Iterator
+	{
+	public:
+		Iterator(PathNode* center, const int* offsets, uint8_t mask) : center(center), offsets(offsets), mask(mask) { Skip(); }
+
+		PathNode* operator*() const { return center + offsets[direction]; }
+		Iterator& operator++() { mask &= mask - 1; direction++; Skip(); return *this; }
+		bool operator!=(const Iterator& other) const { return mask != other.mask; }
+		bool operator==(const Iterator& other) const { return mask == other.mask; }
+
+	private:
+		// Move direction to the lowest one left in the mask
+		void Skip()
+		{
+			if (mask == 0)
+				return;
+			while (!(mask & (1 << direction)))
+				direction++;
+		}
+
+		PathNode* center;
+		const int* offsets;
+		uint8_t mask; // directions not visited yet
+		int direction = 0;
+	};
+
+	NeighborRange(PathNode* center, const int* offsets, uint8_t mask) : center(center), offsets(offsets), mask(mask) { }
+
+	Iterator begin() const { return Iterator(center, offsets, mask); }
+	Iterator end() const { return Iterator(center, offsets, 0); }
+
+private:
+	PathNode* center;
+	const int* offsets;
+	uint8_t mask;
+};
 
 class Grid
 {
@@ -14,8 +62,25 @@ public:
 	// height - how high the grid is
 	// cellsize - the diameter of each cell
 	Grid(int width, int height, int cellSize, Vec2 gridSize = {0, 0});
+
+	// Constructor for Grid that reads a text map, see MapFile::ParseTextCell for the cells
+	// --------------------------
+	// width - how wide the grid is
+	// height - how high the grid is
+	// colAmount - the amount of columns of the map, the rows follow from its length
+	// map - the cells of the map row by row, without spaces or line breaks
 	Grid(int width, int height, int colAmount, std::string map);
 
+	// Constructor for Grid that copies its layers straight from a binary map, see MapFile::Read
+	// --------------------------
+	// width - how wide the grid is
+	// height - how high the grid is
+	// map - the layers of the map, only read during the constructor
+	Grid(int width, int height, const MapView& map);
+
+	// Copy constructor, neighbors are worked out from ids so the copied nodes lead into the copy
+	Grid(const Grid& other) = default;
+
 	~Grid()
 	{
 		//for (auto& specialNode : nodeLocations)
@@ -52,15 +117,85 @@ public:
 
 	// Get the nodes in the grid
 	// --------------------------
-	// returns vector of the rows containing all the nodes in the grid
-	std::vector<std::vector<PathNode>>& GetNodes() { return nodes; }
+	// returns every node of the grid in one array, indexed by PathNode::id which is Index(col, row)
+	std::vector<PathNode>& GetNodes() { return nodes; }
+
+	// Get the node with an id
+	PathNode* GetNode(int id) { return &nodes[id]; }
+
+	// Get the node at a row and column
+	PathNode* GetNode(int row, int col) { return &nodes[Index(col, row)]; }
+
+	// Get the nodes adjacent to a node of this grid, none for obstacles
+	// --------------------------
+	// returns a range of PathNode* to iterate
+	NeighborRange Neighbors(const PathNode* node) const { return NeighborRange(const_cast<PathNode*>(node), neighborOffsets, node->neighborMask); }
+
+	// Get every node adjacent to a node of this grid, obstacle or not
+	// For code reacting to a changed node, which still has to reach the nodes around a new obstacle
+	NeighborRange Around(const PathNode* node) const { return NeighborRange(const_cast<PathNode*>(node), neighborOffsets, BoundsMask(node->id)); }
+
+	// Check if b is one of the neighbors of a
+	bool AreNeighbors(const PathNode* a, const PathNode* b) const;
+
+	// Get the octile distance between two nodes of this grid measured in cells, from their ids
+	// The heuristic of the searches that need it to never overestimate a single step
+	float OctileCells(const PathNode* a, const PathNode* b) const
+	{
+		float dx = (float)std::abs(a->id % cols - b->id % cols);
+		float dy = (float)std::abs(a->id / cols - b->id / cols);
+
+		return std::max(dx, dy) + (1.41421356f - 1.0f) * std::min(dx, dy);
+	}
+
+	// Get the id of a node of this grid from where it is stored, without reading the node
+	int IdOf(const PathNode* node) const { return (int)(node - nodes.data()); }
 
+	// Layers of the grid, one entry per node indexed by PathNode::id
+	// Loops that only look at the terrain read these instead of pulling whole PathNodes into the cache,
+	// the PathNode fields are a copy kept in step by SetNode, SetTerrain, SetResource and SetClearance
+	// --------------------------
+	// id - the id of the node
+	PathNode::Type GetTerrain(int id) const { return (PathNode::Type)(int8_t)terrain[id]; }
+	bool IsObstacle(int id) const { return GetTerrain(id) == PathNode::Rock || GetTerrain(id) == PathNode::Water; }
+	float GetClearance(int id) const { return clearance[id]; }
+	PathNode::ResourceType GetResource(int id) const { return (PathNode::ResourceType)resourceTypes[id]; }
+	float GetResourceAmount(int id) const { return resourceAmounts[id]; }
+	Vec2 GetPosition(int id) const { return GetCellCenter(id / cols, id % cols); }
+
+	// Get the world position of the top left corner of the grid
+	Vec2 GetOrigin() const { return offsetVector; }
+
+	// Get the nodes with resources left by resource type, kept in step by SetResource
+	const ResourceIndex& GetResourceIndex() const { return resourceIndex; }
+
+	// Set the clearance of every node, see BoxClearance
 	void SetClearance();
 
+	// Get the movables in the cells a circle overlaps, as they were at the last RebuildMovableIndex
+	// --------------------------
+	// pos - the center of the circle
+	// radius - the radius of the circle
+	// out - the movables are added to the end of it
 	void QueryEnt(const Vec2& pos, float radius, std::vector<Movable*>& out);
+
+	// Get the nodes in the cells a circle overlaps
+	// --------------------------
+	// pos - the center of the circle
+	// radius - the radius of the circle
+	// out - the nodes are added to the end of it, in id order
+	// type - only the nodes of this resource type with resources left, read from the resource index. None for every node
 	void QueryNodes(const Vec2& pos, float radius, std::vector<PathNode*>& out, PathNode::ResourceType type = PathNode::ResourceType::None);
+
+	// Set the cell of a movable from its position, the index QueryEnt reads only moves it at the next RebuildMovableIndex
 	void UpdateMovable(Movable* m);
 
+	// Sort the movables into the index QueryEnt reads, by the cell they are in now
+	// Rebuilt from scratch once a frame, so movables that moved, were added or were deleted never need to be updated one by one
+	// --------------------------
+	// movables - every movable QueryEnt should find
+	void RebuildMovableIndex(const std::vector<Movable*>& movables);
+
 	inline int Index(int x, int y) const
 	{
 		return y * cols + x;
@@ -80,25 +215,93 @@ public:
 
 	void SetNode(PathNode* node, PathNode::ResourceType type, float resourceAmount = 0);
 
+	// Change the terrain or resource of a node without telling the game services, for grids the game does not own
+	// A node that becomes or stops being an obstacle gets its neighbors and the clearance around it updated, see UpdateClearance
+	void SetTerrain(PathNode* node, PathNode::Type type);
+	void SetResource(PathNode* node, PathNode::ResourceType type, float resourceAmount);
+
+	// Get the nodes besides the changed one whose clearance the latest SetTerrain changed
+	const std::vector<int>& GetClearanceChanges() const { return clearanceChanges; }
+
 	PathNode* GetNodeAt(Vec2 pos);
 
 	bool HasLineOfSight(const Vec2& from, const Vec2& to, float agentRadius) const;
 
+	// Check if an agent can walk in a straight line from the center of one node to the center of another
+	// --------------------------
+	// canTraverse - additionally has to accept every cell the line crosses after from
+	// --------------------------
+	// returns true if no crossed cell is an obstacle, too narrow for the agent or rejected by canTraverse
+	bool HasLineOfSight(const PathNode* from, const PathNode* to, float agentRadius, const std::function<bool(const PathNode*)>& canTraverse) const;
+
 	float cellSize = 20;
 
+	// Radius of the largest agent searching this grid, SetTerrain only recomputes the clearance this close to the changed node
+	// Clearance further away can only change above this radius, where no agent tells the old and new values apart
+	float maxAgentRadius = 0;
+
 private:
 	int width;
 	int height;
 	int rows;
 	int cols;
-	std::vector<std::vector<PathNode>> nodes;
-	std::vector<std::vector<Movable*>> movableLocations;
+	std::vector<PathNode> nodes;
+	int neighborOffsets[8] = {}; // id difference to the neighbor in each direction of PathNode::neighborMask
+
+	std::vector<uint8_t> terrain; // PathNode::Type
+	std::vector<float> clearance;
+	std::vector<int8_t> resourceTypes; // PathNode::ResourceType
+	std::vector<float> resourceAmounts;
+	ResourceIndex resourceIndex; // the nodes of resourceTypes with resourceAmounts above zero
+
+	std::vector<int> clearanceChanges; // see GetClearanceChanges
+	// Movables sorted by cell, the ones in the cell with an id are movableIndex[movableStarts[id]] up to movableIndex[movableStarts[id + 1]]
+	std::vector<Movable*> movableIndex;
+	std::vector<int> movableStarts;
+	std::vector<int> movableFill; // next free place of each cell while rebuilding
+
+	// Walk the cells crossed by the line between the centers of two cells, see HasLineOfSight
+	bool LineOfSight(int r0, int c0, int r1, int c1, float agentRadius, const std::function<bool(const PathNode*)>* canTraverse) const;
+
+	// Copy the terrain, clearance and resources of the nodes into the layers
+	void BuildLayers();
+
+	// Fill the resource index from the resource layers
+	void IndexResources();
+
+	// Set the size of the grid and the cells so the map fits it, centered
+	// --------------------------
+	// width - how wide the grid is
+	// height - how high the grid is
+	// rowAmount, colAmount - the size of the map in cells
+	void FitCells(int width, int height, int rowAmount, int colAmount);
+
+	// Create the nodes from the terrain and resource layers, then set their neighbors and clearance
+	void BuildNodes();
+
+	// Set the neighbor offsets for the size of the grid and the neighbors of every node
+	void SetNeighbors();
+
+	// Get the directions of PathNode::neighborMask that stay inside the grid from the node with an id
+	uint8_t BoundsMask(int id) const;
+
+	// Set which neighbors of a node exist, none for obstacles
+	void SetNeighborMask(PathNode& node);
+
+	// Get the clearance of the cells in a box of the grid from an exact Euclidean distance transform of its obstacles
+	// Clearance is the distance from the center of a cell to the nearest obstacle center or the map border, less half a cell
+	// Runs over the columns and then the rows of the box, each pass split between threads for large boxes
+	// --------------------------
+	// top, left, bottom, right - the rows and columns of the box, included
+	// out - clearance of the box cells row by row, too high for cells whose nearest obstacle is outside the box
+	void BoxClearance(int top, int left, int bottom, int right, std::vector<float>& out) const;
 
-	// Set all neighbors for all nodes
+	// Recompute the clearance of the cells around a node that became or stopped being an obstacle
+	// Cells within maxAgentRadius of the node are measured again from the obstacles around them,
+	// so a raise and a lower are handled the same way
 	// --------------------------
-	// rows - the amount of rows in the grid
-	// cols - the amount of columns in the grid
-	void SetNeighbors(int rows, int cols);
+	// id - the id of the changed node
+	void UpdateClearance(int id);
 
 	// Get the center of the node supposed to be located at row, column
 	// --------------------------
@@ -106,7 +309,7 @@ private:
 	// col - the column of the node
 	// --------------------------
 	// returns the center position of the node
-	Vec2 GetCellCenter(int row, int col);
+	Vec2 GetCellCenter(int row, int col) const;
 
 	Vec2 offsetVector;
 };
\ No newline at end of file
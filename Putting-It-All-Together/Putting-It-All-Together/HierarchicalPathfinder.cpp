@@ -0,0 +1,488 @@
+#include "HierarchicalPathfinder.h"
+#include "GameLoop.h"
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+
+// Openings at least this wide get an abstract node at both ends instead of one in the middle
+static const int LARGE_ENTRANCE = 6;
+
+// Agent radii are grouped in classes of this fraction of the cell size, each class has its own graph
+static const float RADIUS_CLASS_STEP = 0.25f;
+
+std::vector<PathNode*> HierarchicalPathfinder::RequestPath(PathNode* startNode, PathNode* endNode, float& outDist, float agentRadius, const NodeFilter& canTraverse)
+{
+	lastExpanded = 0;
+	localExpanded = 0;
+
+	PathNode* goalNode = ResolveGoalNode(*grid, endNode, agentRadius);
+	if (goalNode == nullptr)
+	{
+		GameLoop::Instance().AddDebugEntity(endNode->position, Renderer::Lime, 10);
+		outDist = -1;
+		return std::vector<PathNode*>();
+	}
+
+	AbstractGraph& graph = GetGraph(agentRadius);
+
+	int startCluster = ClusterOf(startNode);
+	int goalCluster = ClusterOf(goalNode);
+	const float INF = std::numeric_limits<float>::infinity();
+
+	// Connect the start to the abstract nodes of its cluster
+	std::vector<std::pair<PathNode*, float>> startLinks;
+	ClusterDijkstra(startCluster, startNode, goalNode, agentRadius, canTraverse, false);
+	for (int index : graph.clusterNodes[startCluster])
+	{
+		PathNode* n = graph.nodes[index].node;
+		if (localRecords.Has(n))
+			startLinks.push_back({ n, localRecords.At(n).gCost });
+	}
+
+	float direct = INF;
+	if (startCluster == goalCluster && localRecords.Has(goalNode))
+		direct = localRecords.At(goalNode).gCost;
+
+	// Connect the abstract nodes of the goal cluster to the goal
+	std::vector<std::pair<PathNode*, float>> goalLinks;
+	ClusterDijkstra(goalCluster, goalNode, startNode, agentRadius, canTraverse, true);
+	for (int index : graph.clusterNodes[goalCluster])
+	{
+		PathNode* n = graph.nodes[index].node;
+		if (localRecords.Has(n))
+			goalLinks.push_back({ n, localRecords.At(n).gCost });
+	}
+
+	auto goalLink = [&](const PathNode* n)
+		{
+			for (auto& link : goalLinks)
+				if (link.first == n)
+					return link.second;
+			return INF;
+		};
+
+	abstractRecords.NewSearch(rows * cols);
+
+	std::priority_queue<OpenEntry, std::vector<OpenEntry>, OpenEntryCompare> openQueue;
+
+	NodeRecord& startRec = abstractRecords.Get(startNode);
+	startRec.gCost = 0.0f;
+	startRec.hCost = grid->OctileCells(startNode, goalNode);
+	startRec.fCost = startRec.gCost + startRec.hCost;
+	startRec.parent = nullptr;
+
+	openQueue.push({ startNode, startRec.fCost });
+
+	auto relax = [&](PathNode* from, PathNode* to, float cost)
+		{
+			if (cost == INF || abstractRecords.IsClosed(to))
+				return;
+
+			float tentativeG = abstractRecords.Get(from).gCost + cost;
+
+			NodeRecord& rec = abstractRecords.Get(to);
+			if (tentativeG >= rec.gCost)
+				return;
+
+			rec.parent = from;
+			rec.gCost = tentativeG;
+			rec.hCost = grid->OctileCells(to, goalNode);
+			rec.fCost = rec.gCost + rec.hCost;
+
+			openQueue.push({ to, rec.fCost });
+		};
+
+	std::vector<PathNode*> waypoints;
+
+	while (!openQueue.empty())
+	{
+		OpenEntry entry = openQueue.top();
+		openQueue.pop();
+
+		PathNode* current = entry.node;
+
+		// Ignore stale queue entries
+		if (abstractRecords.Get(current).fCost != entry.f)
+			continue;
+
+		// Found goal
+		if (current == goalNode)
+		{
+			outDist = abstractRecords.At(goalNode).gCost;
+			waypoints = ReconstructPath(abstractRecords, goalNode);
+			break;
+		}
+
+		abstractRecords.Close(current);
+		lastExpanded++;
+
+		if (current == startNode)
+		{
+			for (auto& link : startLinks)
+				relax(current, link.first, link.second);
+			relax(current, goalNode, direct);
+		}
+
+		int index = graph.nodeOfCell[current->id];
+		if (index < 0 || !graph.nodes[index].active)
+			continue;
+
+		for (const AbstractEdge& edge : graph.nodes[index].edges)
+		{
+			PathNode* neighbor = graph.nodes[edge.to].node;
+			if (!canTraverse(neighbor) && neighbor != goalNode)
+				continue;
+
+			relax(current, neighbor, edge.cost);
+		}
+
+		if (graph.nodes[index].cluster == goalCluster)
+			relax(current, goalNode, goalLink(current));
+	}
+
+	std::vector<PathNode*> path;
+
+	// Only the way to the first waypoint is refined now, Behaviour asks for the rest when it gets there
+	if (waypoints.size() == 1)
+		path = waypoints;
+	else if (waypoints.size() > 1)
+	{
+		std::vector<PathNode*> refined = RefineSegment(waypoints[waypoints.size() - 1], waypoints[waypoints.size() - 2], agentRadius, canTraverse);
+		if (!refined.empty())
+		{
+			path.assign(waypoints.begin(), waypoints.end() - 2);
+			path.insert(path.end(), refined.begin(), refined.end());
+		}
+	}
+
+	// The abstract graph only knows the terrain, if the filter disagrees search the grid directly
+	if (path.empty())
+	{
+		path = localSearch.RequestPath(startNode, endNode, outDist, agentRadius, canTraverse);
+		localExpanded += localSearch.GetLastExpanded();
+	}
+
+	lastExpanded += localExpanded;
+	return path;
+}
+
+std::vector<PathNode*> HierarchicalPathfinder::RequestClosestPath(PathNode* startNode, const std::vector<PathNode*>& possibleEndNodes, float& outDist, float agentRadius, const NodeFilter& canTraverse)
+{
+	std::vector<PathNode*> path = localSearch.RequestClosestPath(startNode, possibleEndNodes, outDist, agentRadius, canTraverse);
+	lastExpanded = localSearch.GetLastExpanded();
+	return path;
+}
+
+std::vector<PathNode*> HierarchicalPathfinder::RefineSegment(PathNode* from, PathNode* to, float agentRadius, const NodeFilter& canTraverse)
+{
+	UpdateLayout();
+
+	// Waypoints are either in the same cluster or on both sides of a cluster border
+	int fromCluster = ClusterOf(from);
+	int toCluster = ClusterOf(to);
+
+	NodeFilter bounded = [&](const PathNode* node)
+		{
+			int cluster = ClusterOf(node);
+			return (cluster == fromCluster || cluster == toCluster) && canTraverse(node);
+		};
+
+	float dist = 0;
+	std::vector<PathNode*> segment = localSearch.FindPath(from, to, dist, agentRadius, bounded);
+	localExpanded += localSearch.GetLastExpanded();
+
+	return segment;
+}
+
+void HierarchicalPathfinder::OnNodeChanged(const PathNode* node)
+{
+	if (graphs.empty())
+		return;
+
+	int cluster = ClusterOf(node);
+	for (auto& graph : graphs)
+		graph.second.dirtyClusters.insert(cluster);
+}
+
+int HierarchicalPathfinder::GetAbstractNodeCount(float agentRadius)
+{
+	AbstractGraph& graph = GetGraph(agentRadius);
+
+	int count = 0;
+	for (const AbstractNode& node : graph.nodes)
+		if (node.active)
+			count++;
+
+	return count;
+}
+
+void HierarchicalPathfinder::UpdateLayout()
+{
+	if (rows == grid->GetRows() && cols == grid->GetCols())
+		return;
+
+	rows = grid->GetRows();
+	cols = grid->GetCols();
+	clusterRows = (rows + clusterSize - 1) / clusterSize;
+	clusterCols = (cols + clusterSize - 1) / clusterSize;
+	graphs.clear();
+}
+
+HierarchicalPathfinder::AbstractGraph& HierarchicalPathfinder::GetGraph(float agentRadius)
+{
+	UpdateLayout();
+
+	int radiusClass = RadiusClass(agentRadius);
+
+	auto it = graphs.find(radiusClass);
+	if (it == graphs.end())
+	{
+		AbstractGraph& graph = graphs[radiusClass];
+		graph.radius = radiusClass * RADIUS_CLASS_STEP * grid->cellSize;
+		graph.nodeOfCell.assign(rows * cols, -1);
+		graph.clusterNodes.resize(clusterRows * clusterCols);
+
+		std::set<int> all;
+		for (int i = 0; i < clusterRows * clusterCols; i++)
+			all.insert(i);
+
+		RebuildClusters(graph, all);
+		return graph;
+	}
+
+	AbstractGraph& graph = it->second;
+	if (graph.dirtyClusters.empty())
+		return graph;
+
+	// Entrances on the borders of a changed cluster belong to its neighbors as well
+	std::set<int> affected;
+	for (int cluster : graph.dirtyClusters)
+	{
+		int cr = cluster / clusterCols;
+		int cc = cluster % clusterCols;
+
+		affected.insert(cluster);
+		if (cr > 0) affected.insert(cluster - clusterCols);
+		if (cr < clusterRows - 1) affected.insert(cluster + clusterCols);
+		if (cc > 0) affected.insert(cluster - 1);
+		if (cc < clusterCols - 1) affected.insert(cluster + 1);
+	}
+	graph.dirtyClusters.clear();
+
+	RebuildClusters(graph, affected);
+	return graph;
+}
+
+void HierarchicalPathfinder::RebuildClusters(AbstractGraph& graph, const std::set<int>& clusters)
+{
+	// Drop the old abstract nodes, entrances shared with clusters that are not rebuilt come back unchanged
+	for (int cluster : clusters)
+	{
+		for (int index : graph.clusterNodes[cluster])
+		{
+			graph.nodes[index].active = false;
+			graph.nodes[index].edges.clear();
+		}
+		graph.clusterNodes[cluster].clear();
+	}
+
+	// Entrances and the edges leaving the cluster through them
+	const int directions[4][2] = { { 0, 1 }, { 1, 0 }, { 0, -1 }, { -1, 0 } };
+	std::vector<std::pair<PathNode*, PathNode*>> entrances;
+
+	for (int cluster : clusters)
+	{
+		int cr = cluster / clusterCols;
+		int cc = cluster % clusterCols;
+
+		for (auto& dir : directions)
+		{
+			int nr = cr + dir[0];
+			int nc = cc + dir[1];
+			if (nr < 0 || nr >= clusterRows || nc < 0 || nc >= clusterCols)
+				continue;
+
+			int other = nr * clusterCols + nc;
+			bool forward = dir[0] > 0 || dir[1] > 0;
+
+			entrances.clear();
+			if (forward)
+				FindEntrances(graph, cluster, other, entrances);
+			else
+				FindEntrances(graph, other, cluster, entrances);
+
+			for (auto& entrance : entrances)
+			{
+				PathNode* inside = forward ? entrance.first : entrance.second;
+				PathNode* outside = forward ? entrance.second : entrance.first;
+
+				int from = GetOrCreateNode(graph, inside);
+				int to = GetOrCreateNode(graph, outside);
+				graph.nodes[from].edges.push_back({ to, 1.0f / SurfaceSpeed(outside->type) });
+			}
+		}
+	}
+
+	// Cost of walking between the abstract nodes inside each cluster
+	NodeFilter terrain = TerrainFilter();
+
+	for (int cluster : clusters)
+	{
+		const std::vector<int>& members = graph.clusterNodes[cluster];
+		for (int from : members)
+		{
+			ClusterDijkstra(cluster, graph.nodes[from].node, nullptr, graph.radius, terrain, false);
+
+			for (int to : members)
+			{
+				PathNode* target = graph.nodes[to].node;
+				if (to != from && localRecords.Has(target))
+					graph.nodes[from].edges.push_back({ to, localRecords.At(target).gCost });
+			}
+		}
+		rebuiltClusters++;
+	}
+}
+
+void HierarchicalPathfinder::FindEntrances(const AbstractGraph& graph, int a, int b, std::vector<std::pair<PathNode*, PathNode*>>& out)
+{
+	int ar = a / clusterCols;
+	int ac = a % clusterCols;
+	bool right = (b / clusterCols) == ar;
+
+	// Cells along the border, index i walks down a vertical border or right along a horizontal one
+	int first = right ? ar * clusterSize : ac * clusterSize;
+	int last = right ? std::min(first + clusterSize, rows) - 1 : std::min(first + clusterSize, cols) - 1;
+	int lineA = right ? (ac + 1) * clusterSize - 1 : (ar + 1) * clusterSize - 1;
+
+	auto cellA = [&](int i) { return right ? NodeAt(i, lineA) : NodeAt(lineA, i); };
+	auto cellB = [&](int i) { return right ? NodeAt(i, lineA + 1) : NodeAt(lineA + 1, i); };
+	auto walkable = [&](const PathNode* node) { return !node->IsObstacle() && node->clearance >= graph.radius; };
+
+	int runStart = -1;
+	for (int i = first; i <= last + 1; i++)
+	{
+		bool open = i <= last && walkable(cellA(i)) && walkable(cellB(i));
+		if (open && runStart < 0)
+			runStart = i;
+
+		if (open || runStart < 0)
+			continue;
+
+		int runEnd = i - 1;
+		if (runEnd - runStart + 1 < LARGE_ENTRANCE)
+		{
+			int middle = (runStart + runEnd) / 2;
+			out.push_back({ cellA(middle), cellB(middle) });
+		}
+		else
+		{
+			out.push_back({ cellA(runStart), cellB(runStart) });
+			out.push_back({ cellA(runEnd), cellB(runEnd) });
+		}
+		runStart = -1;
+	}
+}
+
+int HierarchicalPathfinder::GetOrCreateNode(AbstractGraph& graph, PathNode* node)
+{
+	int& index = graph.nodeOfCell[node->id];
+	if (index < 0)
+	{
+		index = (int)graph.nodes.size();
+		graph.nodes.push_back(AbstractNode());
+		graph.nodes[index].node = node;
+		graph.nodes[index].cluster = ClusterOf(node);
+	}
+
+	AbstractNode& abstractNode = graph.nodes[index];
+	if (!abstractNode.active)
+	{
+		abstractNode.active = true;
+		graph.clusterNodes[abstractNode.cluster].push_back(index);
+	}
+
+	return index;
+}
+
+void HierarchicalPathfinder::ClusterDijkstra(int cluster, PathNode* source, const PathNode* exempt, float agentRadius, const NodeFilter& canTraverse, bool reverse)
+{
+	localRecords.NewSearch(rows * cols);
+
+	std::priority_queue<OpenEntry, std::vector<OpenEntry>, OpenEntryCompare> openQueue;
+
+	NodeRecord& sourceRec = localRecords.Get(source);
+	sourceRec.gCost = 0.0f;
+	sourceRec.fCost = 0.0f;
+	sourceRec.parent = nullptr;
+
+	openQueue.push({ source, 0.0f });
+
+	while (!openQueue.empty())
+	{
+		OpenEntry entry = openQueue.top();
+		openQueue.pop();
+
+		PathNode* current = entry.node;
+
+		// Ignore stale queue entries
+		if (localRecords.Get(current).fCost != entry.f)
+			continue;
+
+		localRecords.Close(current);
+		localExpanded++;
+
+		int row = current->id / cols;
+		int col = current->id % cols;
+
+		for (PathNode* neighbor : grid->Neighbors(current))
+		{
+			if (localRecords.IsClosed(neighbor))
+				continue;
+
+			if (ClusterOf(neighbor) != cluster)
+				continue;
+
+			if (!canTraverse(neighbor) && neighbor != exempt)
+				continue;
+
+			if (neighbor->clearance < agentRadius)
+				continue;
+
+			int nRow = neighbor->id / cols;
+			int nCol = neighbor->id % cols;
+			bool diagonal = nRow != row && nCol != col;
+
+			if (diagonal && (!canTraverse(NodeAt(row, nCol)) || !canTraverse(NodeAt(nRow, col))))
+				continue;
+
+			// Walking forward enters the neighbor, walking backwards enters the current node
+			PathNode* entered = reverse ? current : neighbor;
+			float edgeCost = diagonal ? 1.41421356f : 1.0f;
+			float tentativeG = localRecords.Get(current).gCost + edgeCost / SurfaceSpeed(entered->type);
+
+			NodeRecord& rec = localRecords.Get(neighbor);
+			if (tentativeG >= rec.gCost)
+				continue;
+
+			rec.parent = current;
+			rec.gCost = tentativeG;
+			rec.fCost = tentativeG;
+
+			openQueue.push({ neighbor, tentativeG });
+		}
+	}
+}
+
+int HierarchicalPathfinder::ClusterOf(const PathNode* node) const
+{
+	return ClusterOf(node->id / cols, node->id % cols);
+}
+
+int HierarchicalPathfinder::RadiusClass(float agentRadius) const
+{
+	float step = RADIUS_CLASS_STEP * grid->cellSize;
+	return std::max(1, (int)std::ceil(agentRadius / step));
+}
+
@@ -0,0 +1,110 @@
+#pragma once
+#include "Pathfinder.h"
+#include "AStar.h"
+#include "Grid.h"
+#include <map>
+#include <set>
+
+// Hierarchical pathfinding (HPA*)
+// The grid is cut into square clusters, the walkable openings between two clusters become abstract nodes
+// and the abstract nodes of a cluster are connected by the cost of walking between them inside the cluster.
+// Searches run on the abstract graph, only the stretch up to the first waypoint is refined to grid cells,
+// the rest is refined through RefineSegment while the agent walks the path
+class HierarchicalPathfinder : public Pathfinder
+{
+public:
+	// Constructor
+	// --------------------------
+	// grid - the grid to search
+	// clusterSize - the amount of cells along each side of a cluster
+	HierarchicalPathfinder(Grid* grid, int clusterSize = 10) : grid(grid), clusterSize(clusterSize), localSearch(grid) { }
+
+	// Overrides base RequestPath
+	std::vector<PathNode*> RequestPath(PathNode* startNode, PathNode* endNode, float& outDist, float agentRadius, const NodeFilter& canTraverse) override;
+
+	// Overrides base RequestClosestPath, multi-goal searches are handed to AStar
+	std::vector<PathNode*> RequestClosestPath(PathNode* startNode, const std::vector<PathNode*>& possibleEndNodes, float& outDist, float agentRadius, const NodeFilter& canTraverse) override;
+
+	// Overrides base RefineSegment
+	std::vector<PathNode*> RefineSegment(PathNode* from, PathNode* to, float agentRadius, const NodeFilter& canTraverse) override;
+
+	// Overrides base OnNodeChanged, the clusters around node are rebuilt before the next search
+	void OnNodeChanged(const PathNode* node) override;
+
+	// Overrides base GetName
+	std::string GetName() const override { return "Hierarchical A-star"; }
+
+	// Get the amount of abstract nodes used for agents of a radius, builds the graph if needed
+	int GetAbstractNodeCount(float agentRadius);
+
+	// Get the amount of clusters rebuilt since the pathfinder was created
+	int GetRebuiltClusters() const { return rebuiltClusters; }
+
+private:
+	struct AbstractEdge
+	{
+		int to;
+		float cost;
+	};
+
+	struct AbstractNode
+	{
+		PathNode* node = nullptr;
+		int cluster = -1;
+		bool active = false;
+		std::vector<AbstractEdge> edges;
+	};
+
+	// Abstract graph for one agent-radius class
+	struct AbstractGraph
+	{
+		float radius = 0;
+		std::vector<AbstractNode> nodes;
+		std::vector<int> nodeOfCell;              // abstract node per grid cell, -1 if none
+		std::vector<std::vector<int>> clusterNodes; // active abstract nodes per cluster
+		std::set<int> dirtyClusters;
+	};
+
+	// Reset the clusters and graphs if the grid dimensions changed
+	void UpdateLayout();
+
+	// Get the graph for the radius class agentRadius falls in, built and repaired
+	AbstractGraph& GetGraph(float agentRadius);
+
+	// Rebuild entrances and intra-cluster edges of the given clusters
+	void RebuildClusters(AbstractGraph& graph, const std::set<int>& clusters);
+
+	// Get the cell pairs (cell in a, cell in b) where an agent can cross from cluster a to cluster b
+	// b must be the cluster right of or below a
+	void FindEntrances(const AbstractGraph& graph, int a, int b, std::vector<std::pair<PathNode*, PathNode*>>& out);
+
+	int GetOrCreateNode(AbstractGraph& graph, PathNode* node);
+
+	// Run Dijkstra from source without leaving the cluster, results are left in localRecords
+	// --------------------------
+	// exempt - node that may be entered even if canTraverse rejects it
+	// reverse - follow the edges backwards, costs become the cost of walking to source
+	void ClusterDijkstra(int cluster, PathNode* source, const PathNode* exempt, float agentRadius, const NodeFilter& canTraverse, bool reverse);
+
+	PathNode* NodeAt(int row, int col) { return grid->GetNode(row, col); }
+
+	int ClusterOf(const PathNode* node) const;
+	int ClusterOf(int row, int col) const { return (row / clusterSize) * clusterCols + col / clusterSize; }
+	int RadiusClass(float agentRadius) const;
+
+	Grid* grid;
+	int clusterSize;
+	int clusterRows = 0;
+	int clusterCols = 0;
+	int rows = 0;
+	int cols = 0;
+
+	std::map<int, AbstractGraph> graphs;
+
+	AStar localSearch;
+	NodeRecordArray localRecords;
+	NodeRecordArray abstractRecords;
+
+	int rebuiltClusters = 0;
+	int localExpanded = 0;
+};
@@ -0,0 +1,302 @@
+#include "JumpPointSearch.h"
+#include "GameLoop.h"
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+
+std::vector<PathNode*> JumpPointSearch::RequestPath(PathNode* startNode, PathNode* endNode, float& outDist, float agentRadius, const NodeFilter& canTraverse)
+{
+	lastExpanded = 0;
+
+	PathNode* goalNode = ResolveGoalNode(*grid, endNode, agentRadius);
+	if (goalNode == nullptr)
+	{
+		GameLoop::Instance().AddDebugEntity(endNode->position, Renderer::Lime, 10);
+		outDist = -1;
+		return std::vector<PathNode*>();
+	}
+
+	rows = grid->GetRows();
+	cols = grid->GetCols();
+	goal = goalNode;
+	radius = agentRadius;
+	filter = &canTraverse;
+
+	size_t nodeCount = rows * cols;
+	if (cells.size() < nodeCount)
+		cells.resize(nodeCount);
+
+	if (++cellGeneration == 0)
+	{
+		std::fill(cells.begin(), cells.end(), CellState());
+		cellGeneration = 1;
+	}
+
+	records.NewSearch(nodeCount);
+
+	std::priority_queue<OpenEntry, std::vector<OpenEntry>, OpenEntryCompare> openQueue;
+
+	NodeRecord& startRec = records.Get(startNode);
+	startRec.gCost = 0.0f;
+	startRec.hCost = grid->OctileCells(startNode, goalNode);
+	startRec.fCost = startRec.gCost + startRec.hCost;
+	startRec.parent = nullptr;
+
+	openQueue.push({ startNode, startRec.fCost });
+
+	std::vector<std::pair<int, int>> directions;
+	directions.reserve(8);
+
+	auto push = [&](PathNode* from, PathNode* to, float cost)
+		{
+			float tentativeG = records.Get(from).gCost + cost;
+
+			NodeRecord& rec = records.Get(to);
+			if (tentativeG >= rec.gCost)
+				return;
+
+			rec.parent = from;
+			rec.gCost = tentativeG;
+			rec.hCost = grid->OctileCells(to, goalNode);
+			rec.fCost = rec.gCost + rec.hCost;
+
+			openQueue.push({ to, rec.fCost });
+		};
+
+	while (!openQueue.empty())
+	{
+		OpenEntry entry = openQueue.top();
+		openQueue.pop();
+
+		PathNode* current = entry.node;
+
+		// Ignore stale queue entries
+		if (records.Get(current).fCost != entry.f)
+			continue;
+
+		// Found goal
+		if (current == goalNode)
+		{
+			outDist = records.At(goalNode).gCost;
+			return FillPath(ReconstructPath(records, goalNode));
+		}
+
+		records.Close(current);
+		lastExpanded++;
+
+		int row = current->id / cols;
+		int col = current->id % cols;
+
+		// Next to swamp, narrow cells or the goal: expand every neighbor exactly like AStar
+		if (IsSpecial(row, col) || IsNearSpecial(row, col))
+		{
+			for (PathNode* neighbor : grid->Neighbors(current))
+			{
+				if (records.IsClosed(neighbor))
+					continue;
+
+				if (!canTraverse(neighbor) && neighbor != goalNode)
+					continue;
+
+				if (neighbor->clearance < agentRadius)
+					continue;
+
+				int nRow = neighbor->id / cols;
+				int nCol = neighbor->id % cols;
+				bool diagonal = nRow != row && nCol != col;
+
+				if (diagonal && (!canTraverse(NodeAt(row, nCol)) || !canTraverse(NodeAt(nRow, col))))
+					continue;
+
+				float edgeCost = diagonal ? 1.41421356f : 1.0f;
+				push(current, neighbor, edgeCost / SurfaceSpeed(neighbor->type));
+			}
+			continue;
+		}
+
+		directions.clear();
+
+		PathNode* parent = records.At(current).parent;
+		if (parent == nullptr)
+		{
+			for (int dr = -1; dr <= 1; dr++)
+				for (int dc = -1; dc <= 1; dc++)
+					if (dr != 0 || dc != 0)
+						directions.push_back({ dr, dc });
+		}
+		else
+		{
+			int pRow = parent->id / cols;
+			int pCol = parent->id % cols;
+			int dr = (row > pRow) - (row < pRow);
+			int dc = (col > pCol) - (col < pCol);
+			PrunedDirections(row, col, dr, dc, directions);
+		}
+
+		for (auto& dir : directions)
+		{
+			PathNode* jumpPoint = Jump(row, col, dir.first, dir.second);
+			if (jumpPoint == nullptr || records.IsClosed(jumpPoint))
+				continue;
+
+			int steps = std::max(std::abs(jumpPoint->id / cols - row), std::abs(jumpPoint->id % cols - col));
+			float stepCost = (dir.first != 0 && dir.second != 0) ? 1.41421356f : 1.0f;
+			push(current, jumpPoint, steps * stepCost);
+		}
+	}
+
+	GameLoop::Instance().AddDebugEntity(goalNode->position, Renderer::Lime, 10);
+
+	outDist = -1;
+	return std::vector<PathNode*>();
+}
+
+std::vector<PathNode*> JumpPointSearch::RequestClosestPath(PathNode* startNode, const std::vector<PathNode*>& possibleEndNodes, float& outDist, float agentRadius, const NodeFilter& canTraverse)
+{
+	std::vector<PathNode*> path = closestSearch.RequestClosestPath(startNode, possibleEndNodes, outDist, agentRadius, canTraverse);
+	lastExpanded = closestSearch.GetLastExpanded();
+	return path;
+}
+
+uint8_t JumpPointSearch::Classify(int row, int col)
+{
+	PathNode* node = NodeAt(row, col);
+	if (node == goal)
+		return Special;
+
+	if (!(*filter)(node))
+		return 0;
+
+	if (node->clearance < radius || node->type == PathNode::Swamp)
+		return Special;
+
+	return Open;
+}
+
+bool JumpPointSearch::IsNearSpecial(int row, int col)
+{
+	uint8_t& f = Flags(row, col);
+	if (f & NearChecked)
+		return f & NearSpecial;
+
+	bool near = false;
+	for (int dr = -1; dr <= 1 && !near; dr++)
+		for (int dc = -1; dc <= 1 && !near; dc++)
+			if ((dr != 0 || dc != 0) && IsSpecial(row + dr, col + dc))
+				near = true;
+
+	f |= NearChecked;
+	if (near)
+		f |= NearSpecial;
+
+	return near;
+}
+
+bool JumpPointSearch::CanStep(int row, int col, int dRow, int dCol)
+{
+	if (!IsOpen(row + dRow, col + dCol))
+		return false;
+
+	// Same corner rule as AStar, both sides of a diagonal step must be traversable
+	if (dRow != 0 && dCol != 0)
+		return IsOpen(row + dRow, col) && IsOpen(row, col + dCol);
+
+	return true;
+}
+
+PathNode* JumpPointSearch::Jump(int row, int col, int dRow, int dCol)
+{
+	while (true)
+	{
+		if (!CanStep(row, col, dRow, dCol))
+			return nullptr;
+
+		row += dRow;
+		col += dCol;
+
+		if (IsNearSpecial(row, col))
+			return NodeAt(row, col);
+
+		if (dRow != 0 && dCol != 0)
+		{
+			// Moving diagonally, stop if a straight jump from here finds something
+			if (Jump(row, col, dRow, 0) || Jump(row, col, 0, dCol))
+				return NodeAt(row, col);
+		}
+		else if (dCol != 0)
+		{
+			if ((IsOpen(row - 1, col) && !IsOpen(row - 1, col - dCol)) ||
+				(IsOpen(row + 1, col) && !IsOpen(row + 1, col - dCol)))
+				return NodeAt(row, col);
+		}
+		else
+		{
+			if ((IsOpen(row, col - 1) && !IsOpen(row - dRow, col - 1)) ||
+				(IsOpen(row, col + 1) && !IsOpen(row - dRow, col + 1)))
+				return NodeAt(row, col);
+		}
+	}
+}
+
+void JumpPointSearch::PrunedDirections(int row, int col, int dRow, int dCol, std::vector<std::pair<int, int>>& out)
+{
+	if (dRow != 0 && dCol != 0)
+	{
+		out.push_back({ dRow, 0 });
+		out.push_back({ 0, dCol });
+		out.push_back({ dRow, dCol });
+		return;
+	}
+
+	if (dCol != 0)
+	{
+		// Moving horizontally, the rows above and below may hold forced neighbors
+		out.push_back({ 0, dCol });
+		for (int side = -1; side <= 1; side += 2)
+		{
+			if (!IsOpen(row + side, col))
+				continue;
+			out.push_back({ side, 0 });
+			out.push_back({ side, dCol });
+		}
+		return;
+	}
+
+	out.push_back({ dRow, 0 });
+	for (int side = -1; side <= 1; side += 2)
+	{
+		if (!IsOpen(row, col + side))
+			continue;
+		out.push_back({ 0, side });
+		out.push_back({ dRow, side });
+	}
+}
+
+std::vector<PathNode*> JumpPointSearch::FillPath(const std::vector<PathNode*>& jumpPoints)
+{
+	std::vector<PathNode*> path;
+	if (jumpPoints.empty())
+		return path;
+
+	path.push_back(jumpPoints.front());
+	for (size_t i = 1; i < jumpPoints.size(); i++)
+	{
+		int row = jumpPoints[i - 1]->id / cols;
+		int col = jumpPoints[i - 1]->id % cols;
+		int toRow = jumpPoints[i]->id / cols;
+		int toCol = jumpPoints[i]->id % cols;
+
+		int dr = (toRow > row) - (toRow < row);
+		int dc = (toCol > col) - (toCol < col);
+
+		while (row != toRow || col != toCol)
+		{
+			row += dr;
+			col += dc;
+			path.push_back(NodeAt(row, col));
+		}
+	}
+
+	return path;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "Pathfinder.h"
+#include "AStar.h"
+#include "Grid.h"
+
+// Jump Point Search over the 8-connected grid
+// Jumping assumes every step costs the same, so swamp cells, cells too narrow for the agent and the goal
+// are treated as special: nodes next to them stop jumps and are expanded like regular A*
+class JumpPointSearch : public Pathfinder
+{
+public:
+	JumpPointSearch(Grid* grid) : grid(grid), closestSearch(grid) { }
+
+	// Overrides base RequestPath
+	std::vector<PathNode*> RequestPath(PathNode* startNode, PathNode* endNode, float& outDist, float agentRadius, const NodeFilter& canTraverse) override;
+
+	// Overrides base RequestClosestPath, multi-goal searches are handed to AStar
+	std::vector<PathNode*> RequestClosestPath(PathNode* startNode, const std::vector<PathNode*>& possibleEndNodes, float& outDist, float agentRadius, const NodeFilter& canTraverse) override;
+
+	// Overrides base GetName
+	std::string GetName() const override { return "Jump Point Search"; }
+
+private:
+	// Per-cell flags, filled lazily during a search
+	enum CellFlag : uint8_t
+	{
+		Open = 1 << 0,       // uniform cost cell the agent can stand on
+		Special = 1 << 1,    // swamp, too narrow for the agent or the goal
+		NearChecked = 1 << 2,
+		NearSpecial = 1 << 3 // a special cell is among the 8 neighbors
+	};
+
+	struct CellState
+	{
+		uint32_t stamp = 0;
+		uint8_t flags = 0;
+	};
+
+	uint8_t& Flags(int row, int col)
+	{
+		CellState& cell = cells[row * cols + col];
+		if (cell.stamp != cellGeneration)
+		{
+			cell.stamp = cellGeneration;
+			cell.flags = Classify(row, col);
+		}
+		return cell.flags;
+	}
+
+	bool InBounds(int row, int col) const { return row >= 0 && row < rows && col >= 0 && col < cols; }
+	bool IsOpen(int row, int col) { return InBounds(row, col) && (Flags(row, col) & Open); }
+	bool IsSpecial(int row, int col) { return InBounds(row, col) && (Flags(row, col) & Special); }
+	bool IsNearSpecial(int row, int col);
+
+	// Get the Open/Special flags of a cell for the running search
+	uint8_t Classify(int row, int col);
+
+	// Check if a single step in direction dRow, dCol is allowed from an open node, including the corner rule
+	bool CanStep(int row, int col, int dRow, int dCol);
+
+	// Walk from row, col in direction dRow, dCol until a jump point is found
+	// --------------------------
+	// returns the jump point or nullptr if the direction is a dead end
+	PathNode* Jump(int row, int col, int dRow, int dCol);
+
+	// Get the directions worth jumping in from a node reached from direction dRow, dCol
+	void PrunedDirections(int row, int col, int dRow, int dCol, std::vector<std::pair<int, int>>& out);
+
+	// Fill in the cells skipped between jump points, path is ordered from goal to start
+	std::vector<PathNode*> FillPath(const std::vector<PathNode*>& jumpPoints);
+
+	PathNode* NodeAt(int row, int col) { return grid->GetNode(row, col); }
+
+	Grid* grid;
+	AStar closestSearch;
+
+	NodeRecordArray records;
+
+	std::vector<CellState> cells;
+	uint32_t cellGeneration = 0;
+
+	// State of the running search
+	int rows = 0;
+	int cols = 0;
+	PathNode* goal = nullptr;
+	float radius = 0;
+	const NodeFilter* filter = nullptr;
+};
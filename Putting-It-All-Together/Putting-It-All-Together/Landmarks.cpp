@@ -0,0 +1,298 @@
+#include "Landmarks.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+namespace
+{
+	const float INF = std::numeric_limits<float>::infinity();
+}
+
+Landmarks::Landmarks(Grid* grid, int count) : grid(grid), cols(grid->GetCols())
+{
+	to.towards = true;
+
+	size_t nodeCount = grid->GetRows() * cols;
+
+	int seed = -1;
+	for (size_t id = 0; id < nodeCount && seed == -1; id++)
+		if (!NodeOf((int)id)->IsObstacle())
+			seed = (int)id;
+
+	if (seed == -1 || count <= 0)
+		return;
+
+	// Farthest-point selection: the first landmark is the node farthest from any passable node,
+	// every next one the node farthest from all landmarks picked so far
+	Table scratch;
+	scratch.dist.assign(nodeCount, INF);
+	scratch.parent.assign(nodeCount, -1);
+	Measure(scratch, 0, seed);
+
+	std::vector<float> closest(nodeCount, INF);
+	bool first = true;
+	while ((int)landmarkIds.size() < count)
+	{
+		int farthest = -1;
+		float farthestDist = 0;
+		for (size_t id = 0; id < nodeCount; id++)
+		{
+			if (scratch.dist[id] == INF)
+				continue;
+
+			float d = first ? scratch.dist[id] : closest[id];
+			if (d > farthestDist)
+			{
+				farthestDist = d;
+				farthest = (int)id;
+			}
+		}
+		first = false;
+
+		if (farthest == -1)
+			break;
+		landmarkIds.push_back(farthest);
+
+		std::fill(scratch.dist.begin(), scratch.dist.end(), INF);
+		std::fill(scratch.parent.begin(), scratch.parent.end(), -1);
+		Measure(scratch, 0, farthest);
+
+		for (size_t id = 0; id < nodeCount; id++)
+			closest[id] = std::min(closest[id], scratch.dist[id]);
+	}
+
+	Rebuild();
+}
+
+float Landmarks::LowerBound(const PathNode* a, const PathNode* b) const
+{
+	size_t count = landmarkIds.size();
+	if (count == 0)
+		return 0;
+
+	const float* fromA = &from.dist[a->id * count];
+	const float* fromB = &from.dist[b->id * count];
+	const float* toA = &to.dist[a->id * count];
+	const float* toB = &to.dist[b->id * count];
+
+	// A node the terrain cannot reach, like an obstacle goal, gives no bound
+	float best = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (fromA[i] != INF && fromB[i] != INF)
+			best = std::max(best, fromB[i] - fromA[i]);
+		if (toA[i] != INF && toB[i] != INF)
+			best = std::max(best, toA[i] - toB[i]);
+	}
+	return best;
+}
+
+void Landmarks::OnNodeChanged(const PathNode* node)
+{
+	if (node == nullptr || GetCount() == 0)
+		return;
+
+	// Nodes whose clearance changed are passed in too, the tables only depend on the terrain
+	lastSettled = 0;
+	if (measuredTypes[node->id] == node->type)
+		return;
+	measuredTypes[node->id] = node->type;
+
+	for (int i = 0; i < GetCount(); i++)
+	{
+		Repair(from, i, node);
+		Repair(to, i, node);
+	}
+}
+
+void Landmarks::Rebuild()
+{
+	size_t nodeCount = grid->GetRows() * cols;
+	size_t size = nodeCount * landmarkIds.size();
+
+	measuredTypes.resize(nodeCount);
+	for (size_t id = 0; id < nodeCount; id++)
+		measuredTypes[id] = NodeOf((int)id)->type;
+
+	lastSettled = 0;
+	for (Table* table : { &from, &to })
+	{
+		table->stride = landmarkIds.size();
+		table->dist.assign(size, INF);
+		table->parent.assign(size, -1);
+		for (int i = 0; i < GetCount(); i++)
+			Measure(*table, i, landmarkIds[i]);
+	}
+}
+
+float Landmarks::Step(const PathNode* current, const PathNode* neighbor, bool towards) const
+{
+	// The tables only ever step onto passable nodes, the landmark itself is where they start
+	if (neighbor->IsObstacle())
+		return INF;
+
+	int row = current->id / cols;
+	int col = current->id % cols;
+	int neighborRow = neighbor->id / cols;
+	int neighborCol = neighbor->id % cols;
+
+	bool diagonal = row != neighborRow && col != neighborCol;
+	if (diagonal)
+	{
+		if (grid->GetNode(row, neighborCol)->IsObstacle() || grid->GetNode(neighborRow, col)->IsObstacle())
+			return INF;
+	}
+
+	// Paths pay for the node they enter, searching backwards that is the node the step comes from
+	float edgeCost = diagonal ? 1.41421356f : 1.0f;
+	return edgeCost / SurfaceSpeed(towards ? current->type : neighbor->type);
+}
+
+void Landmarks::Measure(Table& table, int i, int landmark)
+{
+	size_t count = table.stride;
+
+	table.dist[landmark * count + i] = 0;
+	table.parent[landmark * count + i] = -1;
+
+	queue.clear();
+	queue.push_back({ 0, landmark });
+	Propagate(table, i);
+}
+
+void Landmarks::Repair(Table& table, int i, const PathNode* changed)
+{
+	size_t count = table.stride;
+	size_t nodeCount = grid->GetRows() * cols;
+	int landmark = landmarkIds[i];
+
+	if (invalidStamps.size() < nodeCount)
+		invalidStamps.resize(nodeCount, 0);
+	if (invalidGeneration == std::numeric_limits<uint32_t>::max())
+	{
+		std::fill(invalidStamps.begin(), invalidStamps.end(), 0);
+		invalidGeneration = 0;
+	}
+	invalidGeneration++;
+
+	auto parentOf = [&](int id) { return table.parent[id * count + i]; };
+	auto isInvalid = [&](int id) { return invalidStamps[id] == invalidGeneration; };
+
+	// Roots of the invalid subtrees: the changed node, and every neighbor whose shortest path steps
+	// out of it or cuts diagonally past it
+	std::vector<int> invalid;
+	auto invalidate = [&](int id)
+		{
+			if (id == landmark || isInvalid(id))
+				return;
+			invalidStamps[id] = invalidGeneration;
+			invalid.push_back(id);
+		};
+
+	invalidate(changed->id);
+	int changedRow = changed->id / cols;
+	int changedCol = changed->id % cols;
+	for (PathNode* neighbor : grid->Around(changed))
+	{
+		int parent = parentOf(neighbor->id);
+		if (parent == -1)
+			continue;
+
+		int row = neighbor->id / cols;
+		int col = neighbor->id % cols;
+		int parentRow = parent / cols;
+		int parentCol = parent % cols;
+		bool cutsPast = row != parentRow && col != parentCol &&
+			((row == changedRow && parentCol == changedCol) || (parentRow == changedRow && col == changedCol));
+
+		if (parent == changed->id || cutsPast)
+			invalidate(neighbor->id);
+	}
+
+	// Everything whose shortest path went through a root has to be measured again
+	for (size_t k = 0; k < invalid.size(); k++)
+	{
+		for (PathNode* neighbor : grid->Neighbors(NodeOf(invalid[k])))
+			if (parentOf(neighbor->id) == invalid[k])
+				invalidate(neighbor->id);
+	}
+
+	for (int id : invalid)
+	{
+		table.dist[id * count + i] = INF;
+		table.parent[id * count + i] = -1;
+	}
+
+	queue.clear();
+
+	// Invalid nodes start from their best neighbor that is still measured
+	for (int id : invalid)
+	{
+		PathNode* node = NodeOf(id);
+		float& dist = table.dist[id * count + i];
+		for (PathNode* neighbor : grid->Neighbors(node))
+		{
+			float neighborDist = table.dist[neighbor->id * count + i];
+			if (isInvalid(neighbor->id) || neighborDist == INF)
+				continue;
+
+			float d = neighborDist + Step(neighbor, node, table.towards);
+			if (d < dist)
+			{
+				dist = d;
+				table.parent[id * count + i] = neighbor->id;
+			}
+		}
+
+		if (dist != INF)
+			queue.push_back({ dist, id });
+	}
+
+	// Steps the changed node opened up may shorten paths of nodes that were not invalid,
+	// so its neighbors spread their distances again
+	for (PathNode* neighbor : grid->Around(changed))
+	{
+		float neighborDist = table.dist[neighbor->id * count + i];
+		if (!isInvalid(neighbor->id) && neighborDist != INF)
+			queue.push_back({ neighborDist, neighbor->id });
+	}
+
+	Propagate(table, i);
+}
+
+void Landmarks::Propagate(Table& table, int i)
+{
+	size_t count = table.stride;
+
+	std::make_heap(queue.begin(), queue.end(), std::greater<QueueEntry>());
+	while (!queue.empty())
+	{
+		std::pop_heap(queue.begin(), queue.end(), std::greater<QueueEntry>());
+		QueueEntry entry = queue.back();
+		queue.pop_back();
+
+		// Ignore stale queue entries
+		if (entry.dist > table.dist[entry.id * count + i])
+			continue;
+
+		lastSettled++;
+
+		PathNode* current = NodeOf(entry.id);
+		for (PathNode* neighbor : grid->Neighbors(current))
+		{
+			float step = Step(current, neighbor, table.towards);
+			if (step == INF)
+				continue;
+
+			float d = entry.dist + step;
+			float& neighborDist = table.dist[neighbor->id * count + i];
+			if (d < neighborDist)
+			{
+				neighborDist = d;
+				table.parent[neighbor->id * count + i] = entry.id;
+				queue.push_back({ d, neighbor->id });
+				std::push_heap(queue.begin(), queue.end(), std::greater<QueueEntry>());
+			}
+		}
+	}
+}
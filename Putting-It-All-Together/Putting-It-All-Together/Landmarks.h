@@ -0,0 +1,86 @@
+#pragma once
+#include "Grid.h"
+#include <vector>
+
+// Exact distances from and to a few landmark nodes, used as a lower bound on path lengths (ALT heuristic)
+// By the triangle inequality d(a,b) >= d(L,b) - d(L,a) and d(a,b) >= d(a,L) - d(b,L) for every landmark L,
+// which follows walls where the octile distance does not.
+// The distances are measured on the terrain alone, so the bound holds for any agent radius and any filter
+// that rejects at least the obstacles
+class Landmarks
+{
+public:
+	// Constructor
+	// --------------------------
+	// grid - the grid to measure
+	// count - the amount of landmarks, picked by farthest-point selection over the passable nodes
+	Landmarks(Grid* grid, int count);
+
+	// Get a lower bound on the length of the path from a to b, 0 if no landmark knows both nodes
+	float LowerBound(const PathNode* a, const PathNode* b) const;
+
+	// Called by the grid when the terrain of a node changes, repairs only the distances that went through node
+	// Does nothing if the terrain of node is the one the tables were measured on
+	void OnNodeChanged(const PathNode* node);
+
+	// Measure every table again from scratch, keeping the same landmarks
+	void Rebuild();
+
+	int GetCount() const { return (int)landmarkIds.size(); }
+	const std::vector<int>& GetLandmarkIds() const { return landmarkIds; }
+
+	// Get the distance from landmark i to node, infinite if unreachable
+	float DistanceFrom(int i, const PathNode* node) const { return from.dist[node->id * from.stride + i]; }
+
+	// Get the distance from node to landmark i, infinite if unreachable
+	float DistanceTo(int i, const PathNode* node) const { return to.dist[node->id * to.stride + i]; }
+
+	// Get the amount of nodes settled by the latest OnNodeChanged or Rebuild
+	int GetLastSettled() const { return lastSettled; }
+
+private:
+	// Distances and shortest path tree of one direction, indexed by node id * stride + landmark
+	struct Table
+	{
+		std::vector<float> dist;
+		std::vector<int> parent;
+		size_t stride = 1;    // the amount of landmarks in the table
+		bool towards = false; // true when measuring paths into the landmark, searched backwards from it
+	};
+
+	// Get the cost of the step the search takes from current to neighbor, infinite if the terrain forbids it
+	float Step(const PathNode* current, const PathNode* neighbor, bool towards) const;
+
+	// Measure column i of table from scratch, starting at landmark
+	void Measure(Table& table, int i, int landmark);
+
+	// Repair table for landmark i after the terrain of changed was edited
+	void Repair(Table& table, int i, const PathNode* changed);
+
+	// Settle the queued nodes of table for landmark i like Dijkstra
+	void Propagate(Table& table, int i);
+
+	PathNode* NodeOf(int id) const { return grid->GetNode(id); }
+
+	Grid* grid;
+	int cols;
+
+	std::vector<int> landmarkIds;
+	std::vector<PathNode::Type> measuredTypes; // the terrain of every node when the tables last followed it
+	Table from;
+	Table to;
+
+	// Reused by every repair
+	struct QueueEntry
+	{
+		float dist;
+		int id;
+
+		bool operator>(const QueueEntry& other) const { return dist > other.dist; }
+	};
+	std::vector<QueueEntry> queue;
+	std::vector<uint32_t> invalidStamps;
+	uint32_t invalidGeneration = 0;
+
+	int lastSettled = 0;
+};
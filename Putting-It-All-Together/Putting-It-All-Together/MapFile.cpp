@@ -0,0 +1,193 @@
+#include "MapFile.h"
+#include <fstream>
+#include <vector>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string& path)
+{
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		return;
+	file = handle;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart == 0)
+		return;
+
+	mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+		return;
+
+	data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data != nullptr)
+		size = (size_t)fileSize.QuadPart;
+}
+
+MappedFile::~MappedFile()
+{
+	if (data != nullptr)
+		UnmapViewOfFile(data);
+	if (mapping != nullptr)
+		CloseHandle(mapping);
+	if (file != nullptr)
+		CloseHandle(file);
+}
+#else
+MappedFile::MappedFile(const std::string& path)
+{
+	file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return;
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0)
+		return;
+
+	void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	if (view == MAP_FAILED)
+		return;
+
+	data = (const uint8_t*)view;
+	size = (size_t)info.st_size;
+}
+
+MappedFile::~MappedFile()
+{
+	if (data != nullptr)
+		munmap((void*)data, size);
+	if (file >= 0)
+		close(file);
+}
+#endif
+
+void MapFile::ParseTextCell(char cell, PathNode::Type& type, PathNode::ResourceType& resource)
+{
+	type = PathNode::Nothing;
+	resource = PathNode::None;
+
+	if (cell == 'M')
+	{
+		type = PathNode::Grass;
+	}
+	else if (cell == 'T')
+	{
+		type = PathNode::Grass;
+		resource = PathNode::Wood;
+	}
+	else if (cell == 'V')
+	{
+		type = PathNode::Water;
+	}
+	else if (cell == 'G')
+	{
+		type = PathNode::Swamp;
+	}
+	else if (cell == 'B')
+	{
+		type = PathNode::Rock;
+	}
+}
+
+std::string MapFile::ReadText(const std::string& path)
+{
+	std::string result;
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file)
+		return result;
+
+	// One read of the whole file, then the spaces and line breaks are squeezed out in place
+	result.resize((size_t)file.tellg());
+	file.seekg(0);
+	file.read(&result[0], result.size());
+	result.resize((size_t)file.gcount());
+
+	size_t kept = 0;
+	for (char c : result)
+		if (c != ' ' && c != '\n' && c != '\r')
+			result[kept++] = c;
+	result.resize(kept);
+
+	return result;
+}
+
+bool MapFile::ConvertText(const std::string& textPath, const std::string& binaryPath, int cols)
+{
+	std::string map = ReadText(textPath);
+	if (map.empty() || cols <= 0)
+		return false;
+
+	MapHeader header;
+	header.cols = (uint32_t)cols;
+	header.rows = (uint32_t)((map.size() + cols - 1) / cols);
+
+	// Cells past the end of the text stay Nothing, like in the text constructor of Grid
+	size_t cellCount = (size_t)header.rows * header.cols;
+	std::vector<uint8_t> layers(cellCount * 2);
+	for (size_t id = 0; id < cellCount; id++)
+	{
+		PathNode::Type type = PathNode::Nothing;
+		PathNode::ResourceType resource = PathNode::None;
+		if (id < map.size())
+			ParseTextCell(map[id], type, resource);
+
+		layers[id] = (uint8_t)type;
+		layers[cellCount + id] = (uint8_t)resource;
+	}
+
+	std::ofstream binary(binaryPath, std::ios::binary | std::ios::trunc);
+	if (!binary)
+		return false;
+
+	binary.write((const char*)&header, sizeof(header));
+	binary.write((const char*)layers.data(), layers.size());
+	return (bool)binary;
+}
+
+bool MapFile::Read(const MappedFile& file, MapView& out)
+{
+	if (!file.IsOpen() || file.GetSize() < sizeof(MapHeader))
+		return false;
+
+	MapHeader header;
+	std::memcpy(&header, file.GetData(), sizeof(header));
+
+	MapHeader expected;
+	if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.version != expected.version)
+		return false;
+
+	size_t cellCount = (size_t)header.rows * header.cols;
+	if (header.rows == 0 || header.cols == 0 || file.GetSize() < sizeof(MapHeader) + cellCount * 2)
+		return false;
+
+	// Grid casts the bytes straight to the enums, a corrupt file must not hand it values outside them
+	const uint8_t* terrain = file.GetData() + sizeof(MapHeader);
+	const uint8_t* resources = terrain + cellCount;
+	for (size_t id = 0; id < cellCount; id++)
+	{
+		int type = (int8_t)terrain[id];
+		int resource = (int8_t)resources[id];
+		if (type != PathNode::Nothing && (type <= PathNode::TypeStart || type >= PathNode::TypeEnd))
+			return false;
+		if (resource != PathNode::None && (resource <= PathNode::ResourceStart || resource >= PathNode::ResourceEnd))
+			return false;
+	}
+
+	out.rows = (int)header.rows;
+	out.cols = (int)header.cols;
+	out.resourceAmount = header.resourceAmount;
+	out.terrain = terrain;
+	out.resources = resources;
+	return true;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "PathNode.h"
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Binary map files
+// A MapHeader followed by the terrain layer, one PathNode::Type byte per cell, and the resource layer,
+// one PathNode::ResourceType byte per cell, both row by row like Grid::Index.
+// Files are read through a memory mapping, so Grid builds its layers straight from the mapped bytes
+
+namespace MapFile
+{
+	// Amount every resource cell of a text map starts with
+	const float TEXT_RESOURCE_AMOUNT = 5.0f;
+}
+
+// Header at the start of a binary map file
+struct MapHeader
+{
+	char magic[4] = { 'M', 'A', 'P', 'B' };
+	uint32_t version = 1;
+	uint32_t rows = 0;
+	uint32_t cols = 0;
+	float resourceAmount = MapFile::TEXT_RESOURCE_AMOUNT; // amount every resource cell of the map starts with
+};
+
+// The layers of a map, pointing into a MappedFile or any other bytes that outlive it
+struct MapView
+{
+	int rows = 0;
+	int cols = 0;
+	float resourceAmount = 0;
+	const uint8_t* terrain = nullptr;
+	const uint8_t* resources = nullptr;
+};
+
+// A whole file mapped read-only into memory
+class MappedFile
+{
+public:
+	// Map the file at path, IsOpen is false if it cannot be opened or is empty
+	explicit MappedFile(const std::string& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool IsOpen() const { return data != nullptr; }
+	const uint8_t* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+
+private:
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#else
+	int file = -1;
+#endif
+};
+
+namespace MapFile
+{
+	// Get the terrain and resource of a cell of a text map
+	// 'M' grass, 'T' grass with wood, 'V' water, 'G' swamp, 'B' rock, anything else stays Nothing
+	void ParseTextCell(char cell, PathNode::Type& type, PathNode::ResourceType& resource);
+
+	// Read a text map into one string of cells, without the spaces and line breaks
+	std::string ReadText(const std::string& path);
+
+	// Write the binary map of a text map
+	// --------------------------
+	// textPath - the text map to read
+	// binaryPath - the binary map to write, replaced if it exists
+	// cols - the amount of columns of the text map, the rows follow from its length
+	// --------------------------
+	// returns false if the text map is missing or empty, or the binary map cannot be written
+	bool ConvertText(const std::string& textPath, const std::string& binaryPath, int cols);
+
+	// Get the layers of a mapped binary map
+	// --------------------------
+	// file - the mapped binary map
+	// out - set to point into file
+	// --------------------------
+	// returns false if file is not a binary map of this version, is cut short or holds a terrain or resource that does not exist
+	bool Read(const MappedFile& file, MapView& out);
+}
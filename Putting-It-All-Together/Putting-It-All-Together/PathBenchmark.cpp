@@ -0,0 +1,1913 @@
+#include "PathBenchmark.h"
+#include "AStar.h"
+#include "JumpPointSearch.h"
+#include "HierarchicalPathfinder.h"
+#include "FlowField.h"
+#include "DStarLite.h"
+#include "Landmarks.h"
+#include "ThetaStar.h"
+#include "Reachability.h"
+#include "PathSmoothing.h"
+#include "Logger.h"
+#include "Movable.h"
+#include "random.h"
+#include "Renderer.h"
+#include "MapFile.h"
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+#include <queue>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	using clock = std::chrono::steady_clock;
+
+	// Pick random walkable start/goal pairs, the same pairs every run
+	std::vector<std::pair<PathNode*, PathNode*>> RandomPairs(Grid& grid, int count, uint32_t seed)
+	{
+		std::vector<PathNode*> walkable;
+		for (PathNode& node : grid.GetNodes())
+			if (!node.IsObstacle() && node.clearance >= Movable::baseRadius)
+				walkable.push_back(&node);
+
+		std::vector<std::pair<PathNode*, PathNode*>> pairs;
+		if (walkable.empty())
+			return pairs;
+
+		RNG rng(seed);
+		for (int i = 0; i < count; i++)
+		{
+			PathNode* a = walkable[rng.NextU32() % walkable.size()];
+			PathNode* b = walkable[rng.NextU32() % walkable.size()];
+			pairs.push_back({ a, b });
+		}
+		return pairs;
+	}
+
+	// Generate a map string of size x size cells, about one in five rock and one in ten swamp
+	std::string RandomMap(int size, uint32_t seed)
+	{
+		RNG rng(seed);
+		std::string map(size * size, 'M');
+		for (char& cell : map)
+		{
+			uint32_t roll = rng.NextU32() % 10;
+			if (roll < 2)
+				cell = 'B';
+			else if (roll == 2)
+				cell = 'G';
+		}
+		return map;
+	}
+
+	// Read a text map the way GameLoop did before MapFile::ReadText: one character at a time, appended to the result
+	std::string ReadTextByChar(const std::string& path)
+	{
+		std::string result;
+		std::ifstream file(path);
+		if (!file) return result;
+
+		char c;
+		while (file.get(c))
+		{
+			if (c == ' ' || c == '\n') continue;
+			result += c;
+		}
+		return result;
+	}
+
+	// Clearance the way Grid::SetClearance computed it before the distance transform: a breadth first flood from the obstacles
+	// and the map edge, one cell size per step. Obstacles have no neighbors, so only the edge actually floods
+	std::vector<float> FloodClearance(Grid& grid)
+	{
+		int rows = grid.GetRows();
+		int cols = grid.GetCols();
+		float cellSize = grid.cellSize;
+
+		std::vector<float> clearance(rows * cols, std::numeric_limits<float>::infinity());
+		std::queue<int> q;
+		for (int id = 0; id < rows * cols; id++)
+		{
+			int r = id / cols;
+			int c = id % cols;
+			if (grid.IsObstacle(id))
+				clearance[id] = 0.0f;
+			else if (r == 0 || r == rows - 1 || c == 0 || c == cols - 1)
+				clearance[id] = cellSize;
+			else
+				continue;
+			q.push(id);
+		}
+
+		while (!q.empty())
+		{
+			int current = q.front();
+			q.pop();
+
+			for (PathNode* n : grid.Neighbors(grid.GetNode(current)))
+			{
+				// The diagonal test compared world units against 2, so it only fired for a cell size of 1
+				bool diagonal = n->id / cols != current / cols && n->id % cols != current % cols;
+				float step = (diagonal && cellSize == 1) ? cellSize * 1.41421356f : cellSize;
+
+				if (clearance[current] + step < clearance[n->id])
+				{
+					clearance[n->id] = clearance[current] + step;
+					q.push(n->id);
+				}
+			}
+		}
+
+		for (float& value : clearance)
+			value = std::max(value - cellSize * 0.5f, 0.0f);
+		return clearance;
+	}
+
+	struct RunResult
+	{
+		double ms = 0;
+		long long expanded = 0;
+		int found = 0;
+		double totalDist = 0;
+	};
+
+	RunResult Run(Pathfinder& pathfinder, const std::vector<std::pair<PathNode*, PathNode*>>& pairs, const NodeFilter& filter)
+	{
+		RunResult result;
+		auto start = clock::now();
+		for (auto& p : pairs)
+		{
+			float dist = 0;
+			std::vector<PathNode*> path = pathfinder.RequestPath(p.first, p.second, dist, Movable::baseRadius, filter);
+			result.expanded += pathfinder.GetLastExpanded();
+			if (!path.empty())
+			{
+				result.found++;
+				result.totalDist += dist;
+			}
+		}
+		result.ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+		return result;
+	}
+
+	std::string Describe(const std::string& name, const RunResult& r, size_t queries)
+	{
+		std::ostringstream oss;
+		oss << std::fixed << std::setprecision(3);
+		oss << "  " << name << ": " << r.ms << " ms total, " << (queries ? r.ms * 1000.0 / queries : 0.0) << " us/query, "
+			<< r.expanded << " nodes expanded, " << r.found << " paths found, total distance " << r.totalDist << "\n";
+		return oss.str();
+	}
+}
+
+void PathBenchmark::RunAll(Grid& grid)
+{
+	RecordStorage(grid);
+	JumpPoint(grid);
+	Hierarchical(grid);
+	FlowFields(grid);
+	TimeSliced(grid);
+	Replanning(grid);
+	ClosestPath(grid);
+	AltHeuristic(grid);
+	AnyAngle(grid);
+	Components(grid);
+	FilterPolicies(grid);
+	Bidirectional(grid);
+	BatchPaths(grid);
+	BuildingDistances(grid);
+	PathCompaction(grid);
+	ClearanceUpdates(grid);
+	ClearanceTransform(grid);
+	MapLoading();
+	MovableIndex(grid);
+	ResourceQueries(grid);
+	LargeGrid();
+}
+
+void PathBenchmark::RecordStorage(Grid& grid, int queries)
+{
+	auto pairs = RandomPairs(grid, queries, Seed(1001));
+	if (pairs.empty())
+		return;
+
+	auto filter = [](const PathNode* node) { return !node->IsObstacle(); };
+
+	AStar hashed(&grid, AStar::RecordStorage::HashMap);
+	AStar flat(&grid, AStar::RecordStorage::Flat);
+
+	// warm up both so allocation of the flat array is not part of the timing
+	Run(hashed, { pairs.front() }, filter);
+	Run(flat, { pairs.front() }, filter);
+
+	RunResult hashedResult = Run(hashed, pairs, filter);
+	RunResult flatResult = Run(flat, pairs, filter);
+
+	std::ostringstream oss;
+	oss << "A* record storage benchmark (" << grid.GetCols() << "x" << grid.GetRows() << " grid, " << pairs.size() << " queries)\n";
+	oss << Describe("hash map", hashedResult, pairs.size());
+	oss << Describe("flat array", flatResult, pairs.size());
+	if (flatResult.ms > 0)
+		oss << "  speedup: " << std::fixed << std::setprecision(2) << hashedResult.ms / flatResult.ms << "x\n";
+	Logger::Instance().Log(oss.str());
+}
+
+void PathBenchmark::JumpPoint(Grid& grid, int queries)
+{
+	auto pairs = RandomPairs(grid, queries, Seed(1002));
+	if (pairs.empty())
+		return;
+
+	auto filter = [](const PathNode* node) { return !node->IsObstacle(); };
+
+	AStar astar(&grid);
+	JumpPointSearch jps(&grid);
+
+	Run(astar, { pairs.front() }, filter);
+	Run(jps, { pairs.front() }, filter);
+
+	RunResult astarResult = Run(astar, pairs, filter);
+	RunResult jpsResult = Run(jps, pairs, filter);
+
+	// Check every pair separately so a single wrong path is not hidden by the totals
+	// AStar::Heuristic divides by the truncated cell size and can overestimate, so JPS may be shorter but never longer
+	int longer = 0;
+	for (auto& p : pairs)
+	{
+		float astarDist = 0;
+		float jpsDist = 0;
+		astar.RequestPath(p.first, p.second, astarDist, Movable::baseRadius, filter);
+		jps.RequestPath(p.first, p.second, jpsDist, Movable::baseRadius, filter);
+		if ((astarDist < 0) != (jpsDist < 0) || jpsDist > astarDist + 0.01f)
+			longer++;
+	}
+
+	std::ostringstream oss;
+	oss << "Jump point search benchmark (" << grid.GetCols() << "x" << grid.GetRows() << " grid, " << pairs.size() << " queries)\n";
+	oss << Describe(astar.GetName(), astarResult, pairs.size());
+	oss << Describe(jps.GetName(), jpsResult, pairs.size());
+	if (jpsResult.ms > 0 && jpsResult.expanded > 0)
+		oss << "  speedup: " << std::fixed << std::setprecision(2) << astarResult.ms / jpsResult.ms << "x, "
+			<< (double)astarResult.expanded / jpsResult.expanded << "x fewer expansions\n";
+	oss << "  paths missing or longer than A*: " << longer << "\n";
+	Logger::Instance().Log(oss.str());
+}
+
+void PathBenchmark::Hierarchical(Grid& grid, int queries)
+{
+	auto pairs = RandomPairs(grid, queries, Seed(1003));
+	if (pairs.empty())
+		return;
+
+	auto filter = [](const PathNode* node) { return !node->IsObstacle(); };
+
+	AStar astar(&grid);
+	HierarchicalPathfinder hpa(&grid);
+
+	auto buildStart = clock::now();
+	int abstractNodes = hpa.GetAbstractNodeCount(Movable::baseRadius);
+	double buildMs = std::chrono::duration<double, std::milli>(clock::now() - buildStart).count();
+
+	Run(astar, { pairs.front() }, filter);
+
+	RunResult astarResult = Run(astar, pairs, filter);
+	RunResult hpaResult = Run(hpa, pairs, filter);
+
+	// Mark the cluster in the middle of the map as changed and time the repair
+	PathNode* middle = grid.GetNode(grid.GetRows() / 2, grid.GetCols() / 2);
+	int rebuiltBefore = hpa.GetRebuiltClusters();
+	hpa.OnNodeChanged(middle);
+	auto repairStart = clock::now();
+	hpa.GetAbstractNodeCount(Movable::baseRadius);
+	double repairMs = std::chrono::duration<double, std::milli>(clock::now() - repairStart).count();
+
+	std::ostringstream oss;
+	oss << "Hierarchical search benchmark (" << grid.GetCols() << "x" << grid.GetRows() << " grid, " << pairs.size() << " queries)\n";
+	oss << std::fixed << std::setprecision(3);
+	oss << "  abstract graph: " << abstractNodes << " nodes built in " << buildMs << " ms, "
+		<< hpa.GetRebuiltClusters() - rebuiltBefore << " clusters repaired in " << repairMs << " ms\n";
+	oss << Describe(astar.GetName(), astarResult, pairs.size());
+	oss << Describe(hpa.GetName(), hpaResult, pairs.size());
+	if (hpaResult.ms > 0 && hpaResult.expanded > 0 && astarResult.totalDist > 0)
+		oss << "  speedup: " << std::setprecision(2) << astarResult.ms / hpaResult.ms << "x, "
+			<< (double)astarResult.expanded / hpaResult.expanded << "x fewer expansions, path length "
+			<< hpaResult.totalDist / astarResult.totalDist << "x\n";
+	Logger::Instance().Log(oss.str());
+}
+
+void PathBenchmark::FlowFields(Grid& grid, int goals, int agents)
+{
+	auto goalPairs = RandomPairs(grid, goals, Seed(1004));
+	auto agentPairs = RandomPairs(grid, goals * agents, Seed(1005));
+	if (goalPairs.empty())
+		return;
+
+	// Every agent of a group walks to the same goal
+	std::vector<std::pair<PathNode*, PathNode*>> pairs;
+	for (size_t i = 0; i < agentPairs.size(); i++)
+		pairs.push_back({ agentPairs[i].first, goalPairs[i / agents].second });
+
+	auto filter = [](const PathNode* node) { return !node->IsObstacle(); };
+
+	AStar astar(&grid);
+	Run(astar, { pairs.front() }, filter);
+	RunResult astarResult = Run(astar, pairs, filter);
+
+	RunResult fieldResult;
+	FlowField field;
+	auto start = clock::now();
+	for (size_t i = 0; i < pairs.size(); i++)
+	{
+		if (i % agents == 0)
+		{
+			field.Build(&grid, pairs[i].second, Movable::baseRadius, filter);
+			fieldResult.expanded += field.GetSettled();
+		}
+
+		float dist = 0;
+		std::vector<PathNode*> path = field.ExtractPath(pairs[i].first, dist);
+		if (!path.empty())
+		{
+			fieldResult.found++;
+			fieldResult.totalDist += dist;
+		}
+	}
+	fieldResult.ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+	std::ostringstream oss;
+	oss << "Flow field benchmark (" << grid.GetCols() << "x" << grid.GetRows() << " grid, " << goals << " goals, " << agents << " agents per goal)\n";
+	oss << Describe(astar.GetName(), astarResult, pairs.size());
+	oss << Describe("Flow field", fieldResult, pairs.size());
+	if (fieldResult.ms > 0)
+		oss << "  speedup: " << std::fixed << std::setprecision(2) << astarResult.ms / fieldResult.ms << "x\n";
+	Logger::Instance().Log(oss.str());
+}
+
+void PathBenchmark::TimeSliced(Grid& grid, int queries, int expansionsPerTick)
+{
+	auto pairs = RandomPairs(grid, queries, Seed(1006));
+	if (pairs.empty())
+		return;
+
+	auto filter = [](const PathNode* node) { return !node->IsObstacle(); };
+
+	AStar astar(&grid);
+	Run(astar, { pairs.front() }, filter);
+	RunResult immediate = Run(astar, pairs, filter);
+
+	// Start every search on the same tick, then advance the oldest ones first until the budget is spent
+	std::vector<AStar::SlicedSearch> searches(pairs.size());
+	for (size_t i = 0; i < pairs.size(); i++)
+		astar.BeginSearch(searches[i], pairs[i].first, pairs[i].second, Movable::baseRadius, filter);
+
+	RunResult sliced;
+	double worstTickMs = 0;
+	int ticks = 0;
+	size_t next = 0;
+	while (next < searches.size())
+	{
+		auto tickStart = clock::now();
+		int spent = 0;
+		while (next < searches.size())
+		{
+			spent += astar.StepSearch(searches[next], expansionsPerTick - spent);
+			if (searches[next].status == AStar::SearchStatus::Running)
+				break;
+
+			float dist = 0;
+			if (!astar.GetSearchPath(searches[next], dist).empty())
+			{
+				sliced.found++;
+				sliced.totalDist += dist;
+			}
+			sliced.expanded += searches[next].expanded;
+			next++;
+		}
+		double tickMs = std::chrono::duration<double, std::milli>(clock::now() - tickStart).count();
+		worstTickMs = std::max(worstTickMs, tickMs);
+		sliced.ms += tickMs;
+		ticks++;
+	}
+
+	std::ostringstream oss;
+	oss << "Time-sliced search benchmark (" << grid.GetCols() << "x" << grid.GetRows() << " grid, " << pairs.size() << " searches started together, "
+		<< expansionsPerTick << " expansions per tick)\n";
+	oss << Describe("in one frame", immediate, pairs.size());
+	oss << Describe("sliced", sliced, pairs.size());
+	oss << std::fixed << std::setprecision(3);
+	oss << "  worst frame: " << immediate.ms << " ms in one frame, " << worstTickMs << " ms sliced over " << ticks << " ticks\n";
+	Logger::Instance().Log(oss.str());
+}
+
+void PathBenchmark::Replanning(Grid& grid, int agents, int revealPerStep)
+{
+	auto pairs = RandomPairs(grid, agents, Seed(1007));
+	if (pairs.empty() || revealPerStep <= 0)
+		return;
+
+	// Stands in for AIBrain::CanUseNode, a node is usable once discovered and walkable
+	std::vector<uint8_t> usable(grid.GetRows() * grid.GetCols(), 0);
+	auto filter = [&usable](const PathNode* node) { return usable[node->id] != 0; };
+
+	AStar astar(&grid);
+	DStarLite dstar(&grid);
+
+	RunResult scratch;
+	RunResult repaired;
+	int replans = 0;
+	int arrived = 0;
+	int longer = 0;
+
+	for (auto& p : pairs)
+	{
+		std::fill(usable.begin(), usable.end(), 0);
+
+		// Scouts discover the map in rings around the agent's start
+		std::vector<PathNode*> revealOrder;
+		std::vector<uint8_t> seen(usable.size(), 0);
+		std::queue<PathNode*> frontier;
+		frontier.push(p.first);
+		seen[p.first->id] = 1;
+		while (!frontier.empty())
+		{
+			PathNode* node = frontier.front();
+			frontier.pop();
+			revealOrder.push_back(node);
+			for (PathNode* neighbor : grid.Neighbors(node))
+			{
+				if (!seen[neighbor->id])
+				{
+					seen[neighbor->id] = 1;
+					frontier.push(neighbor);
+				}
+			}
+		}
+
+		PathNode* position = p.first;
+		size_t revealed = 0;
+		int maxSteps = (int)revealOrder.size();
+
+		auto initStart = clock::now();
+		dstar.Initialize(position, p.second, Movable::baseRadius, filter);
+		repaired.ms += std::chrono::duration<double, std::milli>(clock::now() - initStart).count();
+
+		for (int step = 0; step < maxSteps && position != p.second; step++)
+		{
+			// Reveal the next ring, only nodes that became usable change the belief
+			std::vector<PathNode*> changed;
+			size_t revealEnd = std::min(revealOrder.size(), revealed + revealPerStep);
+			for (; revealed < revealEnd; revealed++)
+			{
+				PathNode* node = revealOrder[revealed];
+				if (!node->IsObstacle())
+				{
+					usable[node->id] = 1;
+					changed.push_back(node);
+				}
+			}
+
+			float scratchDist = 0;
+			auto scratchStart = clock::now();
+			std::vector<PathNode*> scratchPath = astar.RequestPath(position, p.second, scratchDist, Movable::baseRadius, filter);
+			scratch.ms += std::chrono::duration<double, std::milli>(clock::now() - scratchStart).count();
+			scratch.expanded += astar.GetLastExpanded();
+
+			float repairedDist = 0;
+			auto repairStart = clock::now();
+			dstar.MoveStart(position);
+			for (PathNode* node : changed)
+				dstar.NodeChanged(node);
+			repaired.expanded += dstar.ComputeShortestPath();
+			std::vector<PathNode*> repairedPath = dstar.GetPath(repairedDist);
+			repaired.ms += std::chrono::duration<double, std::milli>(clock::now() - repairStart).count();
+
+			replans++;
+			if (!scratchPath.empty())
+			{
+				scratch.found++;
+				scratch.totalDist += scratchDist;
+			}
+			if (!repairedPath.empty())
+			{
+				repaired.found++;
+				repaired.totalDist += repairedDist;
+			}
+
+			// AStar::Heuristic can overestimate, so the repaired path may be shorter but never longer
+			if (scratchPath.empty() != repairedPath.empty() || repairedDist > scratchDist + 0.01f)
+				longer++;
+
+			// Step along the repaired path, paths are ordered from the goal back to the start
+			if (repairedPath.size() >= 2)
+				position = repairedPath[repairedPath.size() - 2];
+		}
+
+		if (position == p.second)
+			arrived++;
+	}
+
+	std::ostringstream oss;
+	oss << "Replanning benchmark (" << grid.GetCols() << "x" << grid.GetRows() << " grid, " << pairs.size() << " agents exploring from nothing, "
+		<< revealPerStep << " nodes revealed per step, " << replans << " replans, " << arrived << " arrived)\n";
+	oss << Describe("A* from scratch", scratch, replans);
+	oss << Describe("D* Lite repaired", repaired, replans);
+	if (repaired.ms > 0 && repaired.expanded > 0)
+		oss << "  speedup: " << std::fixed << std::setprecision(2) << scratch.ms / repaired.ms << "x, "
+			<< (double)scratch.expanded / repaired.expanded << "x fewer expansions\n";
+	oss << "  replans missing or longer than A*: " << longer << "\n";
+	Logger::Instance().Log(oss.str());
+}
+
+void PathBenchmark::ClosestPath(Grid& grid, int queries, int batch)
+{
+	std::vector<PathNode*> endNodes;
+	for (PathNode& node : grid.GetNodes())
+		if (node.resource == PathNode::Wood && !node.IsObstacle())
+			endNodes.push_back(&node);
+
+	auto starts = RandomPairs(grid, queries, Seed(1008));
+	if (starts.empty() || endNodes.empty())
+		return;
+
+	auto filter = [](const PathNode* node) { return !node->IsObstacle(); };
+
+	AStar astar(&grid);
+
+	auto runClosest = [&](AStar::ClosestSearch mode, std::vector<float>& dists)
+		{
+			astar.SetClosestSearch(mode);
+			RunResult result;
+			auto start = clock::now();
+			for (auto& p : starts)
+			{
+				float dist = 0;
+				std::vector<PathNode*> path = astar.RequestClosestPath(p.first, endNodes, dist, Movable::baseRadius, filter);
+				result.expanded += astar.GetLastExpanded();
+				dists.push_back(dist);
+				if (!path.empty())
+				{
+					result.found++;
+					result.totalDist += dist;
+				}
+			}
+			result.ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+			return result;
+		};
+
+	std::vector<float> perTargetDists;
+	std::vector<float> multiSourceDists;
+	RunResult perTarget = runClosest(AStar::ClosestSearch::PerTarget, perTargetDists);
+	RunResult multiSource = runClosest(AStar::ClosestSearch::MultiSource, multiSourceDists);
+
+	// Dijkstra gives the exact closest target, both heuristic searches are checked against it
+	RunResult batched;
+	int perTargetLonger = 0;
+	int multiSourceLonger = 0;
+	auto batchStart = clock::now();
+	for (size_t i = 0; i < starts.size(); i++)
+	{
+		std::vector<AStar::ClosestTarget> closest = astar.FindClosestTargets(starts[i].first, endNodes, batch, Movable::baseRadius, filter);
+		batched.expanded += astar.GetLastExpanded();
+		batched.found += (int)closest.size();
+		for (const AStar::ClosestTarget& target : closest)
+			batched.totalDist += target.dist;
+
+		float exact = closest.empty() ? -1 : closest.front().dist;
+		if ((perTargetDists[i] < 0) != (exact < 0) || perTargetDists[i] > exact + 0.01f)
+			perTargetLonger++;
+		if ((multiSourceDists[i] < 0) != (exact < 0) || multiSourceDists[i] > exact + 0.01f)
+			multiSourceLonger++;
+	}
+	batched.ms = std::chrono::duration<double, std::milli>(clock::now() - batchStart).count();
+
+	std::ostringstream oss;
+	oss << "Closest path benchmark (" << grid.GetCols() << "x" << grid.GetRows() << " grid, " << starts.size() << " queries, "
+		<< endNodes.size() << " targets each)\n";
+	oss << Describe("forward per target", perTarget, starts.size());
+	oss << Describe("backward multi-source", multiSource, starts.size());
+	oss << Describe("closest " + std::to_string(batch) + " by Dijkstra", batched, starts.size());
+	if (multiSource.ms > 0 && multiSource.expanded > 0)
+		oss << "  speedup: " << std::fixed << std::setprecision(2) << perTarget.ms / multiSource.ms << "x, "
+			<< (double)perTarget.expanded / multiSource.expanded << "x fewer expansions\n";
+	oss << "  longer than the closest target: " << perTargetLonger << " forward, " << multiSourceLonger << " multi-source\n";
+	Logger::Instance().Log(oss.str());
+}
+
+void PathBenchmark::AltHeuristic(Grid& grid, int queries, int landmarkCount, int edits)
+{
+	auto pairs = RandomPairs(grid, queries, Seed(1010));
+	if (pairs.empty())
+		return;
+
+	auto filter = [](const PathNode* node) { return !node->IsObstacle(); };
+
+	auto buildStart = clock::now();
+	Landmarks landmarks(&grid, landmarkCount);
+	double buildMs = std::chrono::duration<double, std::milli>(clock::now() - buildStart).count();
+
+	AStar octile(&grid);
+	AStar alt(&grid);
+	alt.SetLandmarks(&landmarks);
+
+	Run(octile, { pairs.front() }, filter);
+	Run(alt, { pairs.front() }, filter);
+
+	RunResult octileResult = Run(octile, pairs, filter);
+	RunResult altResult = Run(alt, pairs, filter);
+
+	int longer = 0;
+	for (auto& p : pairs)
+	{
+		float octileDist = 0;
+		float altDist = 0;
+		octile.RequestPath(p.first, p.second, octileDist, Movable::baseRadius, filter);
+		alt.RequestPath(p.first, p.second, altDist, Movable::baseRadius, filter);
+		if ((octileDist < 0) != (altDist < 0) || altDist > octileDist + 0.01f)
+			longer++;
+	}
+
+	// Turn random nodes into rock one after another, then back again in reverse order
+	auto editPairs = RandomPairs(grid, edits, Seed(1011));
+	std::vector<std::pair<PathNode*, PathNode::Type>> edited;
+	for (auto& p : editPairs)
+		edited.push_back({ p.first, p.first->type });
+
+	double repairMs = 0;
+	long long repairSettled = 0;
+	auto applyEdit = [&](PathNode* node, PathNode::Type type)
+		{
+			grid.SetTerrain(node, type);
+			auto repairStart = clock::now();
+			landmarks.OnNodeChanged(node);
+			repairMs += std::chrono::duration<double, std::milli>(clock::now() - repairStart).count();
+			repairSettled += landmarks.GetLastSettled();
+		};
+
+	float worstError = 0;
+	auto compareWithScratch = [&]()
+		{
+			Landmarks scratch = landmarks;
+			scratch.Rebuild();
+			for (PathNode& node : grid.GetNodes())
+			{
+				for (int i = 0; i < landmarks.GetCount(); i++)
+				{
+					float a = landmarks.DistanceFrom(i, &node);
+					float b = scratch.DistanceFrom(i, &node);
+					float c = landmarks.DistanceTo(i, &node);
+					float d = scratch.DistanceTo(i, &node);
+					if ((a == b || std::abs(a - b) <= worstError) && (c == d || std::abs(c - d) <= worstError))
+						continue;
+					worstError = std::max(a == b ? 0.0f : std::abs(a - b), c == d ? 0.0f : std::abs(c - d));
+				}
+			}
+		};
+
+	for (auto& e : edited)
+		applyEdit(e.first, PathNode::Rock);
+	compareWithScratch();
+
+	for (auto it = edited.rbegin(); it != edited.rend(); it++)
+		applyEdit(it->first, it->second);
+	compareWithScratch();
+
+	auto rebuildStart = clock::now();
+	landmarks.Rebuild();
+	double rebuildMs = std::chrono::duration<double, std::milli>(clock::now() - rebuildStart).count();
+
+	std::ostringstream oss;
+	oss << "ALT heuristic benchmark (" << grid.GetCols() << "x" << grid.GetRows() << " grid, " << pairs.size() << " queries, "
+		<< landmarks.GetCount() << " landmarks)\n";
+	oss << std::fixed << std::setprecision(3);
+	oss << "  tables: built in " << buildMs << " ms, measured again in " << rebuildMs << " ms\n";
+	oss << Describe("octile", octileResult, pairs.size());
+	oss << Describe("ALT", altResult, pairs.size());
+	if (altResult.ms > 0 && altResult.expanded > 0)
+		oss << "  speedup: " << std::setprecision(2) << octileResult.ms / altResult.ms << "x, "
+			<< (double)octileResult.expanded / altResult.expanded << "x fewer expansions\n";
+	oss << "  paths missing or longer than octile: " << longer << "\n";
+	oss << std::setprecision(3);
+	oss << "  " << edited.size() * 2 << " node edits repaired in " << repairMs << " ms total, " << repairSettled
+		<< " nodes settled, largest difference to tables measured from scratch: " << worstError << "\n";
+	Logger::Instance().Log(oss.str());
+}
+
+void PathBenchmark::AnyAngle(Grid& grid, int queries)
+{
+	auto pairs = RandomPairs(grid, queries, Seed(1012));
+	if (pairs.empty())
+		return;
+
+	auto filter = [](const PathNode* node) { return !node->IsObstacle(); };
+
+	AStar astar(&grid);
+	ThetaStar theta(&grid);
+
+	Run(astar, { pairs.front() }, filter);
+	Run(theta, { pairs.front() }, filter);
+
+	RunResult astarResult = Run(astar, pairs, filter);
+	RunResult thetaResult = Run(theta, pairs, filter);
+
+	// Waypoints are what Behaviour walks through, every non-adjacent segment costs one line of sight check
+	// when RefineSegment confirms it, instead of one per frame
+	long long astarWaypoints = 0;
+	long long thetaWaypoints = 0;
+	long long searchSightChecks = 0;
+	long long walkSightChecks = 0;
+	int blockedSegments = 0;
+	int longer = 0;
+	for (auto& p : pairs)
+	{
+		float astarDist = 0;
+		float thetaDist = 0;
+		std::vector<PathNode*> astarPath = astar.RequestPath(p.first, p.second, astarDist, Movable::baseRadius, filter);
+		std::vector<PathNode*> thetaPath = theta.RequestPath(p.first, p.second, thetaDist, Movable::baseRadius, filter);
+		astarWaypoints += astarPath.size();
+		thetaWaypoints += thetaPath.size();
+		searchSightChecks += theta.GetLastSightChecks();
+
+		for (size_t i = 0; i + 1 < thetaPath.size(); i++)
+		{
+			PathNode* to = thetaPath[i];
+			PathNode* from = thetaPath[i + 1];
+			if (grid.AreNeighbors(from, to))
+				continue;
+
+			walkSightChecks++;
+			if (!grid.HasLineOfSight(from->position, to->position, Movable::baseRadius))
+				blockedSegments++;
+		}
+
+		if ((astarDist < 0) != (thetaDist < 0) || thetaDist > astarDist + 0.01f)
+			longer++;
+	}
+
+	std::ostringstream oss;
+	oss << "Any-angle search benchmark (" << grid.GetCols() << "x" << grid.GetRows() << " grid, " << pairs.size() << " queries)\n";
+	oss << Describe(astar.GetName(), astarResult, pairs.size());
+	oss << Describe(theta.GetName(), thetaResult, pairs.size());
+	oss << std::fixed << std::setprecision(2);
+	if (thetaResult.ms > 0)
+		oss << "  time: " << astarResult.ms / thetaResult.ms << "x, path length " << thetaResult.totalDist / std::max(astarResult.totalDist, 1.0) << "x\n";
+	oss << "  waypoints per path: " << (double)astarWaypoints / pairs.size() << " A*, " << (double)thetaWaypoints / pairs.size() << " Theta*\n";
+	oss << "  line of sight checks per path: " << (double)searchSightChecks / pairs.size() << " searching, "
+		<< (double)walkSightChecks / pairs.size() << " walking\n";
+	oss << "  segments HasLineOfSight rejects: " << blockedSegments << ", paths missing or longer than A*: " << longer << "\n";
+	Logger::Instance().Log(oss.str());
+}
+
+void PathBenchmark::Components(Grid& grid, int queries, int edits)
+{
+	auto pairs = RandomPairs(grid, queries, Seed(1013));
+	if (pairs.empty())
+		return;
+
+	// Stands in for AIBrain::CanUseNode, most of the map is discovered in scattered patches
+	std::vector<uint8_t> usable(grid.GetRows() * grid.GetCols(), 0);
+	RNG rng(Seed(1014));
+	for (PathNode& node : grid.GetNodes())
+		usable[node.id] = !node.IsObstacle() && rng.NextU32() % 100 < 75;
+	auto filter = [&usable](const PathNode* node) { return usable[node->id] != 0; };
+
+	auto labelStart = clock::now();
+	Reachability reachability(&grid, filter);
+	int components = reachability.GetComponentCount(Movable::baseRadius);
+	double labelMs = std::chrono::duration<double, std::milli>(clock::now() - labelStart).count();
+
+	AStar astar(&grid);
+	Run(astar, { pairs.front() }, filter);
+
+	RunResult searched = Run(astar, pairs, filter);
+
+	// The same requests with the index asked first, rejected pairs never reach the search
+	RunResult checked;
+	int rejected = 0;
+	int wrongRejections = 0;
+	auto checkStart = clock::now();
+	for (auto& p : pairs)
+	{
+		if (!reachability.MayReach(p.first, p.second, Movable::baseRadius))
+		{
+			rejected++;
+			continue;
+		}
+
+		float dist = 0;
+		std::vector<PathNode*> path = astar.RequestPath(p.first, p.second, dist, Movable::baseRadius, filter);
+		checked.expanded += astar.GetLastExpanded();
+		if (!path.empty())
+		{
+			checked.found++;
+			checked.totalDist += dist;
+		}
+	}
+	checked.ms = std::chrono::duration<double, std::milli>(clock::now() - checkStart).count();
+
+	for (auto& p : pairs)
+	{
+		float dist = 0;
+		if (!reachability.MayReach(p.first, p.second, Movable::baseRadius) &&
+			!astar.RequestPath(p.first, p.second, dist, Movable::baseRadius, filter).empty())
+			wrongRejections++;
+	}
+
+	// Switch random nodes off one after another, then back on in reverse order
+	auto editPairs = RandomPairs(grid, edits, Seed(1015));
+	std::vector<std::pair<PathNode*, uint8_t>> edited;
+	for (auto& p : editPairs)
+		edited.push_back({ p.first, usable[p.first->id] });
+
+	double updateMs = 0;
+	long long relabeledBefore = reachability.GetRelabeled();
+	auto applyEdit = [&](PathNode* node, uint8_t value)
+		{
+			usable[node->id] = value;
+			auto updateStart = clock::now();
+			reachability.OnNodeChanged(node);
+			updateMs += std::chrono::duration<double, std::milli>(clock::now() - updateStart).count();
+		};
+
+	int mismatches = 0;
+	auto compareWithScratch = [&]()
+		{
+			Reachability scratch(&grid, filter);
+			if (scratch.GetComponentCount(Movable::baseRadius) != reachability.GetComponentCount(Movable::baseRadius))
+				mismatches++;
+			for (auto& p : pairs)
+				if (scratch.MayReach(p.first, p.second, Movable::baseRadius) != reachability.MayReach(p.first, p.second, Movable::baseRadius))
+					mismatches++;
+		};
+
+	for (size_t i = 0; i < edited.size(); i++)
+	{
+		applyEdit(edited[i].first, 0);
+		if (i % 20 == 0)
+			compareWithScratch();
+	}
+	compareWithScratch();
+
+	for (auto it = edited.rbegin(); it != edited.rend(); it++)
+		applyEdit(it->first, it->second);
+	compareWithScratch();
+
+	std::ostringstream oss;
+	oss << "Reachability benchmark (" << grid.GetCols() << "x" << grid.GetRows() << " grid, " << pairs.size() << " queries)\n";
+	oss << std::fixed << std::setprecision(3);
+	oss << "  index: " << components << " components labeled in " << labelMs << " ms\n";
+	oss << Describe("A* only", searched, pairs.size());
+	oss << Describe("index, then A*", checked, pairs.size());
+	if (checked.ms > 0 && checked.expanded > 0)
+		oss << "  speedup: " << std::setprecision(2) << searched.ms / checked.ms << "x, "
+			<< (double)searched.expanded / checked.expanded << "x fewer expansions\n";
+	oss << "  rejected without a search: " << rejected << ", rejected although A* finds a path: " << wrongRejections << "\n";
+	oss << std::setprecision(3);
+	oss << "  " << edited.size() * 2 << " node edits updated in " << updateMs << " ms total, "
+		<< reachability.GetRelabeled() - relabeledBefore << " nodes relabeled, answers differing from an index labeled from scratch: " << mismatches << "\n";
+	Logger::Instance().Log(oss.str());
+}
+
+void PathBenchmark::FilterPolicies(Grid& grid, int queries, int repeats)
+{
+	auto pairs = RandomPairs(grid, queries, Seed(1016));
+	if (pairs.empty())
+		return;
+
+	// A brain that has discovered the whole map, so both filters search the same paths
+	std::vector<uint8_t> usable(grid.GetRows() * grid.GetCols(), 0);
+	for (PathNode& node : grid.GetNodes())
+		usable[node.id] = !node.IsObstacle();
+
+	const uint8_t* mask = usable.data();
+	NodeFilter terrainLambda = [](const PathNode* node) { return !node->IsObstacle(); };
+	NodeFilter terrainPolicy = TerrainFilter();
+	NodeFilter maskLambda = [mask](const PathNode* node) { return mask[node->id] != 0; };
+	NodeFilter maskPolicy = MaskFilter{ mask };
+
+	AStar astar(&grid);
+	Run(astar, { pairs.front() }, terrainLambda);
+
+	auto fastest = [&](const NodeFilter& filter)
+		{
+			RunResult best;
+			for (int i = 0; i < std::max(repeats, 1); i++)
+			{
+				RunResult result = Run(astar, pairs, filter);
+				if (i == 0 || result.ms < best.ms)
+					best = result;
+			}
+			return best;
+		};
+
+	RunResult terrainLambdaResult = fastest(terrainLambda);
+	RunResult terrainPolicyResult = fastest(terrainPolicy);
+	RunResult maskLambdaResult = fastest(maskLambda);
+	RunResult maskPolicyResult = fastest(maskPolicy);
+
+	std::ostringstream oss;
+	oss << "Filter policy benchmark (" << grid.GetCols() << "x" << grid.GetRows() << " grid, " << pairs.size() << " queries, fastest of "
+		<< std::max(repeats, 1) << " runs)\n";
+	oss << Describe("terrain lambda", terrainLambdaResult, pairs.size());
+	oss << Describe("TerrainFilter", terrainPolicyResult, pairs.size());
+	oss << Describe("mask lambda", maskLambdaResult, pairs.size());
+	oss << Describe("MaskFilter", maskPolicyResult, pairs.size());
+	oss << std::fixed << std::setprecision(2);
+	if (terrainPolicyResult.ms > 0 && maskPolicyResult.ms > 0)
+		oss << "  speedup: " << terrainLambdaResult.ms / terrainPolicyResult.ms << "x terrain, "
+			<< maskLambdaResult.ms / maskPolicyResult.ms << "x mask\n";
+	Logger::Instance().Log(oss.str());
+}
+
+void PathBenchmark::Bidirectional(Grid& grid, int queries, float bucketCells)
+{
+	auto pairs = RandomPairs(grid, queries, Seed(1017));
+	if (pairs.empty() || bucketCells <= 0)
+		return;
+
+	auto filter = TerrainFilter();
+
+	AStar forward(&grid);
+	AStar both(&grid);
+	both.SetBidirectionalThreshold(std::numeric_limits<float>::min());
+
+	auto octile = [&](PathNode* a, PathNode* b)
+		{
+			float dx = std::abs(a->position.x - b->position.x) / grid.GetCellSize();
+			float dy = std::abs(a->position.y - b->position.y) / grid.GetCellSize();
+			return std::max(dx, dy) + 0.41421356f * std::min(dx, dy);
+		};
+
+	// Trips back to the Storage node, like the ones of the gathering workers, from every fourth walkable node
+	PathNode* storage = grid.GetNodeAt(Vec2(965, 491));
+	std::vector<std::vector<std::pair<PathNode*, PathNode*>>> storageBuckets;
+	if (storage)
+	{
+		for (PathNode& node : grid.GetNodes())
+		{
+			if (node.id % 4 != 0 || node.IsObstacle() || node.clearance < Movable::baseRadius)
+				continue;
+
+			size_t bucket = (size_t)(octile(&node, storage) / bucketCells);
+			if (storageBuckets.size() <= bucket)
+				storageBuckets.resize(bucket + 1);
+			storageBuckets[bucket].push_back({ &node, storage });
+		}
+	}
+
+	std::vector<std::vector<std::pair<PathNode*, PathNode*>>> buckets;
+	for (auto& p : pairs)
+	{
+		size_t bucket = (size_t)(octile(p.first, p.second) / bucketCells);
+		if (buckets.size() <= bucket)
+			buckets.resize(bucket + 1);
+		buckets[bucket].push_back(p);
+	}
+
+	Run(forward, { pairs.front() }, filter);
+	Run(both, { pairs.front() }, filter);
+
+	std::ostringstream oss;
+	oss << "Bidirectional search benchmark (" << grid.GetCols() << "x" << grid.GetRows() << " grid, " << pairs.size() << " queries)\n";
+
+	auto compare = [&](const std::string& name, const std::vector<std::pair<PathNode*, PathNode*>>& group)
+		{
+			if (group.empty())
+				return;
+
+			RunResult forwardResult = Run(forward, group, filter);
+			long long forwardBefore = both.GetForwardExpandedTotal();
+			long long backwardBefore = both.GetBackwardExpandedTotal();
+			RunResult bothResult = Run(both, group, filter);
+			long long fromStart = both.GetForwardExpandedTotal() - forwardBefore;
+			long long fromGoal = both.GetBackwardExpandedTotal() - backwardBefore;
+
+			int longer = 0;
+			for (auto& p : group)
+			{
+				float forwardDist = 0;
+				float bothDist = 0;
+				forward.RequestPath(p.first, p.second, forwardDist, Movable::baseRadius, filter);
+				both.RequestPath(p.first, p.second, bothDist, Movable::baseRadius, filter);
+				if ((forwardDist < 0) != (bothDist < 0) || bothDist > forwardDist + 0.01f)
+					longer++;
+			}
+
+			oss << " " << name << " (" << group.size() << " queries)\n";
+			oss << " " << Describe("forward", forwardResult, group.size());
+			oss << " " << Describe("bidirectional", bothResult, group.size());
+			oss << std::fixed << std::setprecision(2);
+			if (bothResult.ms > 0 && bothResult.expanded > 0)
+				oss << "    speedup: " << forwardResult.ms / bothResult.ms << "x, " << (double)forwardResult.expanded / bothResult.expanded
+					<< "x fewer expansions, " << fromStart << " from the start / " << fromGoal << " from the goal\n";
+			oss << "    paths missing or longer than forward: " << longer << ", length " << bothResult.totalDist / std::max(forwardResult.totalDist, 1.0) << "x\n";
+			oss << std::setprecision(3);
+		};
+
+	for (size_t i = 0; i < buckets.size(); i++)
+	{
+		std::ostringstream name;
+		name << "octile " << i * bucketCells << " to " << (i + 1) * bucketCells << " cells";
+		compare(name.str(), buckets[i]);
+	}
+	for (size_t i = 0; i < storageBuckets.size(); i++)
+	{
+		std::ostringstream name;
+		name << "to Storage, octile " << i * bucketCells << " to " << (i + 1) * bucketCells << " cells";
+		compare(name.str(), storageBuckets[i]);
+	}
+
+	Logger::Instance().Log(oss.str());
+}
+
+void PathBenchmark::BatchPaths(Grid& grid, int goals, int clusterCells)
+{
+	auto goalPairs = RandomPairs(grid, goals, Seed(1018));
+	if (goalPairs.empty())
+		return;
+
+	auto filter = TerrainFilter();
+
+	AStar astar(&grid);
+	FlowField field;
+	Run(astar, { goalPairs.front() }, filter);
+
+	// Walkable nodes within clusterCells of center, the center first
+	RNG rng(Seed(1020));
+	auto cluster = [&](PathNode* center, int count)
+		{
+			std::vector<PathNode*> nearby;
+			int cols = grid.GetCols();
+			for (PathNode& node : grid.GetNodes())
+				if (&node != center && !node.IsObstacle() && node.clearance >= Movable::baseRadius &&
+					std::abs(node.id / cols - center->id / cols) <= clusterCells && std::abs(node.id % cols - center->id % cols) <= clusterCells)
+					nearby.push_back(&node);
+
+			std::vector<PathNode*> starts{ center };
+			while ((int)starts.size() < count)
+				starts.push_back(nearby.empty() ? center : nearby[rng.NextU32() % nearby.size()]);
+			return starts;
+		};
+
+	std::ostringstream oss;
+	oss << "Batch path benchmark (" << grid.GetCols() << "x" << grid.GetRows() << " grid, " << goalPairs.size() << " goals per group size)\n";
+
+	for (bool clustered : { false, true })
+	{
+		for (int agents : { 2, 4, 8, 16 })
+		{
+			auto agentPairs = RandomPairs(grid, (int)goalPairs.size() * agents, Seed(1019));
+
+			std::vector<std::vector<PathNode*>> groups;
+			std::vector<std::pair<PathNode*, PathNode*>> pairs;
+			for (size_t g = 0; g < goalPairs.size(); g++)
+			{
+				std::vector<PathNode*> starts;
+				if (clustered)
+					starts = cluster(agentPairs[g * agents].first, agents);
+				else
+					for (int a = 0; a < agents; a++)
+						starts.push_back(agentPairs[g * agents + a].first);
+
+				for (PathNode* start : starts)
+					pairs.push_back({ start, goalPairs[g].second });
+				groups.push_back(starts);
+			}
+
+			RunResult singleResult = Run(astar, pairs, filter);
+
+			RunResult batchResult;
+			RunResult fieldResult;
+			int differing = 0;
+			for (size_t g = 0; g < groups.size(); g++)
+			{
+				PathNode* goal = goalPairs[g].second;
+				const std::vector<PathNode*>& starts = groups[g];
+
+				auto batchStart = clock::now();
+				std::vector<float> dists;
+				std::vector<std::vector<PathNode*>> paths = astar.RequestPaths(starts, goal, dists, Movable::baseRadius, filter);
+				batchResult.ms += std::chrono::duration<double, std::milli>(clock::now() - batchStart).count();
+				batchResult.expanded += astar.GetLastExpanded();
+
+				auto fieldStart = clock::now();
+				field.Build(&grid, goal, Movable::baseRadius, filter);
+				std::vector<float> fieldDists(starts.size());
+				for (size_t a = 0; a < starts.size(); a++)
+					field.ExtractPath(starts[a], fieldDists[a]);
+				fieldResult.ms += std::chrono::duration<double, std::milli>(clock::now() - fieldStart).count();
+				fieldResult.expanded += field.GetSettled();
+
+				for (size_t a = 0; a < starts.size(); a++)
+				{
+					if (!paths[a].empty())
+					{
+						batchResult.found++;
+						batchResult.totalDist += dists[a];
+					}
+					if (fieldDists[a] >= 0)
+					{
+						fieldResult.found++;
+						fieldResult.totalDist += fieldDists[a];
+					}
+					if ((dists[a] < 0) != (fieldDists[a] < 0) || std::abs(dists[a] - fieldDists[a]) > 0.01f)
+						differing++;
+				}
+			}
+
+			oss << " " << agents << " agents per goal, " << (clustered ? "clustered" : "anywhere") << "\n";
+			oss << " " << Describe("RequestPath per agent", singleResult, pairs.size());
+			oss << " " << Describe("RequestPaths per goal", batchResult, pairs.size());
+			oss << " " << Describe("FlowField per goal", fieldResult, pairs.size());
+			oss << std::fixed << std::setprecision(2);
+			if (batchResult.ms > 0)
+				oss << "    speedup: " << singleResult.ms / batchResult.ms << "x over RequestPath, " << fieldResult.ms / batchResult.ms
+					<< "x over FlowField, distances differing from the flow field: " << differing << "\n";
+			oss << std::setprecision(3);
+		}
+	}
+
+	Logger::Instance().Log(oss.str());
+}
+
+void PathBenchmark::BuildingDistances(Grid& grid, int buildings, int agents, int rounds)
+{
+	auto buildingPairs = RandomPairs(grid, buildings, Seed(1021));
+	auto agentPairs = RandomPairs(grid, agents, Seed(1022));
+	if (buildingPairs.empty() || agentPairs.empty())
+		return;
+
+	auto filter = TerrainFilter();
+
+	AStar astar(&grid);
+	Run(astar, { buildingPairs.front() }, filter);
+
+	std::vector<FlowField> fields(buildingPairs.size());
+
+	// The closest agent per building and round, -1 if none can reach it
+	std::vector<int> searchedPicks;
+	std::vector<int> fieldPicks;
+
+	RunResult searchResult;
+	auto searchStart = clock::now();
+	for (int round = 0; round < rounds; round++)
+	{
+		for (auto& building : buildingPairs)
+		{
+			float bestDist = std::numeric_limits<float>::max();
+			int best = -1;
+			for (int a = 0; a < (int)agentPairs.size(); a++)
+			{
+				float dist = 0;
+				std::vector<PathNode*> path = astar.RequestPath(agentPairs[a].first, building.second, dist, Movable::baseRadius, filter);
+				searchResult.expanded += astar.GetLastExpanded();
+				if (path.empty())
+					continue;
+
+				searchResult.found++;
+				searchResult.totalDist += dist;
+				if (dist < bestDist)
+				{
+					bestDist = dist;
+					best = a;
+				}
+			}
+			searchedPicks.push_back(best);
+		}
+	}
+	searchResult.ms = std::chrono::duration<double, std::milli>(clock::now() - searchStart).count();
+
+	RunResult builtOnceResult;
+	RunResult rebuiltResult;
+	for (bool rebuildEveryRound : { false, true })
+	{
+		RunResult& result = rebuildEveryRound ? rebuiltResult : builtOnceResult;
+		fieldPicks.clear();
+
+		auto fieldStart = clock::now();
+		for (int round = 0; round < rounds; round++)
+		{
+			for (size_t b = 0; b < buildingPairs.size(); b++)
+			{
+				if (round == 0 || rebuildEveryRound)
+				{
+					fields[b].Build(&grid, buildingPairs[b].second, Movable::baseRadius, filter);
+					result.expanded += fields[b].GetSettled();
+				}
+
+				float bestDist = std::numeric_limits<float>::max();
+				int best = -1;
+				for (int a = 0; a < (int)agentPairs.size(); a++)
+				{
+					float dist = fields[b].GetCost(agentPairs[a].first);
+					if (dist < 0)
+						continue;
+
+					result.found++;
+					result.totalDist += dist;
+					if (dist < bestDist)
+					{
+						bestDist = dist;
+						best = a;
+					}
+				}
+				fieldPicks.push_back(best);
+			}
+		}
+		result.ms = std::chrono::duration<double, std::milli>(clock::now() - fieldStart).count();
+	}
+
+	int differing = 0;
+	for (size_t i = 0; i < searchedPicks.size(); i++)
+		if (searchedPicks[i] != fieldPicks[i])
+			differing++;
+
+	size_t scored = (size_t)rounds * buildingPairs.size() * agentPairs.size();
+
+	std::ostringstream oss;
+	oss << "Building distance benchmark (" << grid.GetCols() << "x" << grid.GetRows() << " grid, " << buildingPairs.size() << " buildings, "
+		<< agentPairs.size() << " agents, " << rounds << " rounds)\n";
+	oss << Describe("AStar per agent", searchResult, scored);
+	oss << Describe("Field per building, built once", builtOnceResult, scored);
+	oss << Describe("Field per building, rebuilt every round", rebuiltResult, scored);
+	oss << std::fixed << std::setprecision(2);
+	if (builtOnceResult.ms > 0 && rebuiltResult.ms > 0)
+		oss << "  speedup: " << searchResult.ms / builtOnceResult.ms << "x built once, " << searchResult.ms / rebuiltResult.ms
+			<< "x rebuilt every round, picks differing from AStar: " << differing << " of " << searchedPicks.size() << "\n";
+
+	Logger::Instance().Log(oss.str());
+}
+
+void PathBenchmark::PathCompaction(Grid& grid, int queries)
+{
+	auto pairs = RandomPairs(grid, queries, Seed(1023));
+	if (pairs.empty())
+		return;
+
+	auto filter = TerrainFilter();
+	float radius = Movable::baseRadius;
+
+	AStar astar(&grid);
+	std::vector<std::vector<PathNode*>> paths;
+	for (auto& p : pairs)
+	{
+		float dist = 0;
+		std::vector<PathNode*> path = astar.RequestPath(p.first, p.second, dist, radius, filter);
+		if (!path.empty())
+			paths.push_back(std::move(path));
+	}
+
+	std::vector<std::vector<PathNode*>> compacted = paths;
+	long long sightChecks = 0;
+	auto compactStart = clock::now();
+	for (std::vector<PathNode*>& path : compacted)
+		sightChecks += CompactPath(grid, path, radius, filter);
+	double compactMs = std::chrono::duration<double, std::milli>(clock::now() - compactStart).count();
+
+	// Every compacted segment has to be walkable in a straight line
+	int invalid = 0;
+	for (const std::vector<PathNode*>& path : compacted)
+		for (size_t i = 1; i < path.size(); i++)
+			if (!grid.HasLineOfSight(path[i], path[i - 1], radius, [&](const PathNode* node) { return node == path.front() || filter(node); }))
+				invalid++;
+
+	struct FollowResult
+	{
+		size_t nodes = 0;
+		double length = 0;
+		long long frames = 0;
+		double ms = 0;
+	};
+
+	auto follow = [&](const std::vector<std::vector<PathNode*>>& set)
+		{
+			FollowResult result;
+			float step = grid.GetCellSize() * 0.25f;
+			auto start = clock::now();
+			for (const std::vector<PathNode*>& path : set)
+			{
+				result.nodes += path.size();
+				for (size_t i = 1; i < path.size(); i++)
+					result.length += DistanceBetween(path[i]->position, path[i - 1]->position) / grid.GetCellSize();
+
+				Vec2 position = path.back()->position;
+				int index = (int)path.size() - 1;
+				while (true)
+				{
+					result.frames++;
+					if (DistanceBetween(position, path[index]->position) < 10)
+					{
+						if (index == 0)
+							break;
+						index--;
+					}
+
+					Vec2 toTarget = path[index]->position - position;
+					float distance = toTarget.Length();
+					position = distance <= step ? path[index]->position : position + toTarget.Normalized() * step;
+				}
+			}
+			result.ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+			return result;
+		};
+
+	FollowResult cells = follow(paths);
+	FollowResult waypoints = follow(compacted);
+
+	auto describe = [&](const std::string& name, const FollowResult& r)
+		{
+			std::ostringstream line;
+			line << std::fixed << std::setprecision(3);
+			line << "  " << name << ": " << r.nodes << " nodes, " << r.nodes * sizeof(PathNode*) / 1024.0 << " KiB, length " << r.length
+				<< " cells, " << r.frames << " frames followed in " << r.ms << " ms, " << (r.frames ? r.ms * 1e6 / r.frames : 0.0) << " ns/frame\n";
+			return line.str();
+		};
+
+	std::ostringstream oss;
+	oss << "Path compaction benchmark (" << grid.GetCols() << "x" << grid.GetRows() << " grid, " << paths.size() << " paths)\n";
+	oss << describe("AStar paths", cells);
+	oss << describe("Compacted", waypoints);
+	oss << std::fixed << std::setprecision(3);
+	oss << "  compacting: " << compactMs << " ms total, " << (paths.empty() ? 0.0 : compactMs * 1000.0 / paths.size()) << " us/path, "
+		<< sightChecks << " line of sight checks, segments failing line of sight: " << invalid << "\n";
+
+	Logger::Instance().Log(oss.str());
+}
+
+
+void PathBenchmark::ClearanceUpdates(Grid& grid, int edits)
+{
+	Grid edited = grid;
+
+	auto editPairs = RandomPairs(edited, edits, Seed(1027));
+	if (editPairs.empty())
+		return;
+
+	std::vector<std::pair<PathNode*, PathNode::Type>> changes;
+	for (auto& p : editPairs)
+		changes.push_back({ p.first, p.first->type });
+
+	double updateMs = 0;
+	size_t changedNodes = 0;
+	auto applyEdit = [&](PathNode* node, PathNode::Type type)
+		{
+			auto updateStart = clock::now();
+			edited.SetTerrain(node, type);
+			updateMs += std::chrono::duration<double, std::milli>(clock::now() - updateStart).count();
+			changedNodes += edited.GetClearanceChanges().size();
+		};
+
+	// Clearance under maxAgentRadius has to match a full recompute, above it the update may leave older values
+	float radius = edited.maxAgentRadius;
+	int wrongBelow = 0;
+	int differentAbove = 0;
+	int wrongNeighbors = 0;
+	auto compareWithScratch = [&]()
+		{
+			Grid scratch = edited;
+			scratch.SetClearance();
+			for (int id = 0; id < (int)edited.GetNodes().size(); id++)
+			{
+				float a = edited.GetClearance(id);
+				float b = scratch.GetClearance(id);
+				if (a != b && (a < radius || b < radius))
+					wrongBelow++;
+				else if (a != b)
+					differentAbove++;
+
+				if (edited.IsObstacle(id) != (edited.GetNode(id)->neighborMask == 0))
+					wrongNeighbors++;
+			}
+		};
+
+	for (auto& c : changes)
+		applyEdit(c.first, PathNode::Rock);
+	compareWithScratch();
+
+	for (auto it = changes.rbegin(); it != changes.rend(); it++)
+		applyEdit(it->first, it->second);
+	compareWithScratch();
+
+	auto fullStart = clock::now();
+	for (int i = 0; i < 20; i++)
+		edited.SetClearance();
+	double fullMs = std::chrono::duration<double, std::milli>(clock::now() - fullStart).count() / 20;
+
+	size_t editCount = changes.size() * 2;
+
+	std::ostringstream oss;
+	oss << std::fixed << std::setprecision(3);
+	oss << "Clearance update benchmark (" << edited.GetCols() << "x" << edited.GetRows() << " grid, " << editCount << " edits, "
+		<< "exact below radius " << radius << ")\n";
+	oss << "  SetClearance: " << fullMs * 1000.0 << " us per edit\n";
+	oss << "  SetTerrain: " << updateMs * 1000.0 / editCount << " us per edit, " << (double)changedNodes / editCount << " other nodes changed per edit\n";
+	if (updateMs > 0)
+		oss << "  speedup: " << std::setprecision(1) << fullMs * editCount / updateMs << "x\n";
+	oss << "  nodes differing from a full recompute: " << wrongBelow << " below the radius, " << differentAbove << " above it, "
+		<< wrongNeighbors << " with neighbors not matching their terrain\n";
+	Logger::Instance().Log(oss.str());
+}
+
+void PathBenchmark::ClearanceTransform(Grid& grid, int largeSize)
+{
+	Grid edited = grid;
+	int nodeCount = (int)edited.GetNodes().size();
+	float cellSize = edited.cellSize;
+
+	auto floodStart = clock::now();
+	std::vector<float> flood = FloodClearance(edited);
+	double floodMs = std::chrono::duration<double, std::milli>(clock::now() - floodStart).count();
+
+	auto transformStart = clock::now();
+	edited.SetClearance();
+	double transformMs = std::chrono::duration<double, std::milli>(clock::now() - transformStart).count();
+
+	// Exact clearance measured against every obstacle and the four borders
+	std::vector<int> obstacles;
+	for (int id = 0; id < nodeCount; id++)
+		if (edited.IsObstacle(id))
+			obstacles.push_back(id);
+
+	int rows = edited.GetRows();
+	int cols = edited.GetCols();
+	float worstError = 0;
+	int differentFromFlood = 0;
+	int floodHigher = 0;
+	float radii[] = { Movable::baseRadius, cellSize * 0.25f, cellSize * 0.5f, cellSize };
+	int differentFits[4] = {};
+	for (int id = 0; id < nodeCount; id++)
+	{
+		int r = id / cols;
+		int c = id % cols;
+		float best = (float)std::min(std::min(r + 1, rows - r), std::min(c + 1, cols - c));
+		for (int obstacle : obstacles)
+		{
+			float dr = (float)(obstacle / cols - r);
+			float dc = (float)(obstacle % cols - c);
+			best = std::min(best, std::sqrt(dr * dr + dc * dc));
+		}
+		float exact = std::max(best * cellSize - cellSize * 0.5f, 0.0f);
+		worstError = std::max(worstError, std::abs(exact - edited.GetClearance(id)));
+
+		if (flood[id] != edited.GetClearance(id))
+			differentFromFlood++;
+		if (flood[id] > edited.GetClearance(id))
+			floodHigher++;
+		for (int i = 0; i < 4; i++)
+			if ((flood[id] < radii[i]) != (edited.GetClearance(id) < radii[i]))
+				differentFits[i]++;
+	}
+
+	// Both on a large random map
+	Grid large(largeSize * 10, largeSize * 10, largeSize, RandomMap(largeSize, Seed(1028)));
+
+	auto largeFloodStart = clock::now();
+	FloodClearance(large);
+	double largeFloodMs = std::chrono::duration<double, std::milli>(clock::now() - largeFloodStart).count();
+
+	auto largeTransformStart = clock::now();
+	large.SetClearance();
+	double largeTransformMs = std::chrono::duration<double, std::milli>(clock::now() - largeTransformStart).count();
+
+	std::ostringstream oss;
+	oss << std::fixed << std::setprecision(3);
+	oss << "Clearance transform benchmark (" << cols << "x" << rows << " grid, " << obstacles.size() << " obstacles)\n";
+	oss << "  flood: " << floodMs << " ms, distance transform: " << transformMs << " ms\n";
+	oss << "  " << large.GetCols() << "x" << large.GetRows() << " random map: flood " << largeFloodMs << " ms, distance transform "
+		<< largeTransformMs << " ms\n";
+	oss << "  largest difference to the exact Euclidean clearance: " << worstError << "\n";
+	oss << "  nodes whose clearance changed from the flood: " << differentFromFlood << ", " << floodHigher
+		<< " of them rated higher by the flood\n";
+	oss << "  nodes an agent fits on differently, by radius:";
+	for (int i = 0; i < 4; i++)
+		oss << " " << radii[i] << ": " << differentFits[i];
+	oss << "\n";
+	Logger::Instance().Log(oss.str());
+}
+
+void PathBenchmark::LargeGrid(int size, int queries)
+{
+	std::string map = RandomMap(size, Seed(1024));
+
+	auto buildStart = clock::now();
+	Grid grid(size * 10, size * 10, size, map);
+	double buildMs = std::chrono::duration<double, std::milli>(clock::now() - buildStart).count();
+
+	auto pairs = RandomPairs(grid, queries, Seed(1025));
+	if (pairs.empty())
+		return;
+
+	auto filter = TerrainFilter();
+	AStar astar(&grid);
+	Run(astar, { pairs.front() }, filter);
+	RunResult result = Run(astar, pairs, filter);
+
+	// Short sight lines between random cells, read only from the terrain and clearance layers
+	const int sightChecks = 200000;
+	RNG sightRng(Seed(1026));
+	int visible = 0;
+	auto sightStart = clock::now();
+	for (int i = 0; i < sightChecks; i++)
+	{
+		int from = sightRng.NextU32() % (size * size);
+		int row = std::clamp(from / size + (int)(sightRng.NextU32() % 17) - 8, 0, size - 1);
+		int col = std::clamp(from % size + (int)(sightRng.NextU32() % 17) - 8, 0, size - 1);
+		if (grid.HasLineOfSight(grid.GetPosition(from), grid.GetPosition(grid.Index(col, row)), Movable::baseRadius))
+			visible++;
+	}
+	double sightMs = std::chrono::duration<double, std::milli>(clock::now() - sightStart).count();
+
+	size_t nodeBytes = grid.GetNodes().capacity() * sizeof(PathNode);
+	size_t layerBytes = (size_t)size * size * (sizeof(uint8_t) + sizeof(float) + sizeof(int8_t) + sizeof(float));
+
+	std::ostringstream oss;
+	oss << std::fixed << std::setprecision(3);
+	oss << "Large grid benchmark (" << grid.GetCols() << "x" << grid.GetRows() << " grid, " << pairs.size() << " queries)\n";
+	oss << "  nodes: " << sizeof(PathNode) << " bytes each, " << nodeBytes / (1024.0 * 1024.0) << " MiB in one array, grid built in " << buildMs << " ms\n";
+	oss << Describe("A-star Search", result, pairs.size());
+	if (result.expanded > 0)
+		oss << "  " << result.ms * 1e6 / result.expanded << " ns per expanded node\n";
+	oss << "  layers: " << layerBytes / (1024.0 * 1024.0) << " MiB of terrain, clearance and resources\n";
+	oss << "  line of sight: " << sightChecks << " checks of up to 8 cells, " << sightMs * 1e6 / sightChecks << " ns per check, " << visible << " clear\n";
+
+	Logger::Instance().Log(oss.str());
+}
+
+void PathBenchmark::MapLoading(int size)
+{
+	// A random map with some water and wood, written as text rows the way Map/map.txt is
+	std::string map = RandomMap(size, Seed(1030));
+	RNG rng(Seed(1031));
+	for (char& cell : map)
+	{
+		uint32_t roll = rng.NextU32() % 20;
+		if (cell == 'M' && roll == 0)
+			cell = 'T';
+		else if (cell == 'M' && roll == 1)
+			cell = 'V';
+	}
+
+	std::error_code ec;
+	std::filesystem::path directory = std::filesystem::temp_directory_path(ec) / "map_loading_benchmark";
+	std::filesystem::create_directories(directory, ec);
+	std::string textPath = (directory / "map.txt").string();
+	std::string binaryPath = (directory / "map.bin").string();
+	{
+		std::ofstream text(textPath, std::ios::trunc);
+		for (int r = 0; r < size; r++)
+			text << map.substr((size_t)r * size, size) << "\n";
+	}
+
+	int width = size * 10;
+	int height = size * 10;
+
+	auto byCharStart = clock::now();
+	std::string byCharText = ReadTextByChar(textPath);
+	double byCharReadMs = std::chrono::duration<double, std::milli>(clock::now() - byCharStart).count();
+	Grid byChar(width, height, size, byCharText);
+	double byCharMs = std::chrono::duration<double, std::milli>(clock::now() - byCharStart).count();
+
+	auto textStart = clock::now();
+	std::string wholeText = MapFile::ReadText(textPath);
+	double textReadMs = std::chrono::duration<double, std::milli>(clock::now() - textStart).count();
+	Grid fromText(width, height, size, wholeText);
+	double textMs = std::chrono::duration<double, std::milli>(clock::now() - textStart).count();
+
+	auto convertStart = clock::now();
+	bool converted = MapFile::ConvertText(textPath, binaryPath, size);
+	double convertMs = std::chrono::duration<double, std::milli>(clock::now() - convertStart).count();
+
+	auto binaryStart = clock::now();
+	MappedFile file(binaryPath);
+	MapView view;
+	bool read = MapFile::Read(file, view);
+	double binaryReadMs = std::chrono::duration<double, std::milli>(clock::now() - binaryStart).count();
+	Grid fromBinary(read ? Grid(width, height, view) : Grid(width, height, 10));
+	double binaryMs = std::chrono::duration<double, std::milli>(clock::now() - binaryStart).count();
+
+	// Every grid has to come out the same as the one built from the old text read
+	int nodeCount = (int)byChar.GetNodes().size();
+	int different[2] = {};
+	Grid* loaded[2] = { &fromText, &fromBinary };
+	for (int i = 0; i < 2; i++)
+	{
+		Grid& other = *loaded[i];
+		if ((int)other.GetNodes().size() != nodeCount || other.GetRows() != byChar.GetRows())
+		{
+			different[i] = nodeCount;
+			continue;
+		}
+
+		for (int id = 0; id < nodeCount; id++)
+		{
+			const PathNode* a = byChar.GetNode(id);
+			const PathNode* b = other.GetNode(id);
+			if (byChar.GetTerrain(id) != other.GetTerrain(id) || byChar.GetResource(id) != other.GetResource(id) ||
+				byChar.GetResourceAmount(id) != other.GetResourceAmount(id) || byChar.GetClearance(id) != other.GetClearance(id) ||
+				a->type != b->type || a->resource != b->resource || a->neighborMask != b->neighborMask || a->position != b->position)
+				different[i]++;
+		}
+	}
+
+	size_t textBytes = (size_t)std::filesystem::file_size(textPath, ec);
+	size_t binaryBytes = converted ? (size_t)std::filesystem::file_size(binaryPath, ec) : 0;
+	std::filesystem::remove_all(directory, ec);
+
+	std::ostringstream oss;
+	oss << std::fixed << std::setprecision(3);
+	oss << "Map loading benchmark (" << size << "x" << size << " random map, text " << textBytes / 1024.0 << " KiB, binary "
+		<< binaryBytes / 1024.0 << " KiB)\n";
+	oss << "  text read one character at a time: " << byCharReadMs << " ms to read, " << byCharMs << " ms with the grid\n";
+	oss << "  text read whole: " << textReadMs << " ms to read, " << textMs << " ms with the grid\n";
+	oss << "  binary mapped: " << binaryReadMs << " ms to map, " << binaryMs << " ms with the grid"
+		<< (read ? "" : " (the binary map could not be read)") << "\n";
+	oss << "  converting the text map: " << convertMs << " ms\n";
+	oss << "  nodes differing from the text grid: " << different[0] << " read whole, " << different[1] << " mapped\n";
+	Logger::Instance().Log(oss.str());
+}
+
+void PathBenchmark::MovableIndex(Grid& grid, int agents, int frames)
+{
+	Grid indexed = grid;
+	float cellSize = indexed.cellSize;
+	int rows = indexed.GetRows();
+	int cols = indexed.GetCols();
+	Vec2 origin = indexed.GetPosition(0) - Vec2(cellSize, cellSize) * 0.5f;
+	Vec2 extent = Vec2(cols * cellSize, rows * cellSize);
+
+	// Movables spread over the map, each walking in its own direction and turning back at the edges
+	RNG rng(Seed(1050));
+	std::vector<Movable> movables(agents);
+	std::vector<Vec2> steps(agents);
+	std::vector<Movable*> pointers;
+	for (int i = 0; i < agents; i++)
+	{
+		movables[i].SetPos(origin + Vec2(rng.NextFloat01() * extent.x, rng.NextFloat01() * extent.y));
+		float angle = rng.NextFloat01() * 2 * PI;
+		steps[i] = Vec2(std::cos(angle), std::sin(angle)) * cellSize * 0.3f;
+		pointers.push_back(&movables[i]);
+	}
+
+	// The index Grid kept before: a vector of movables per cell, moved between cells one movable at a time
+	std::vector<std::vector<Movable*>> cellLists(rows * cols);
+	std::vector<int> listCells(agents, -1);
+	auto listCell = [&](const Vec2& pos)
+		{
+			int row, col;
+			indexed.WorldToGrid(pos, row, col);
+			return std::clamp(row, 0, rows - 1) * cols + std::clamp(col, 0, cols - 1);
+		};
+
+	const float queryRadius = 50.0f; // the separation steering of Behaviour asks for 40 plus a margin of 10
+	double rebuildMs = 0;
+	double queryMs = 0;
+	double listUpdateMs = 0;
+	double listQueryMs = 0;
+	long long found = 0;
+	long long listFound = 0;
+	int checked = 0;
+	int wrong = 0;
+	std::vector<Movable*> out;
+
+	for (int frame = 0; frame < frames; frame++)
+	{
+		for (int i = 0; i < agents; i++)
+		{
+			Vec2 pos = movables[i].GetPosition() + steps[i];
+			if (pos.x < origin.x || pos.x > origin.x + extent.x)
+				steps[i].x = -steps[i].x;
+			if (pos.y < origin.y || pos.y > origin.y + extent.y)
+				steps[i].y = -steps[i].y;
+			movables[i].SetPos(movables[i].GetPosition() + steps[i]);
+		}
+
+		auto rebuildStart = clock::now();
+		indexed.RebuildMovableIndex(pointers);
+		rebuildMs += std::chrono::duration<double, std::milli>(clock::now() - rebuildStart).count();
+
+		auto queryStart = clock::now();
+		for (int i = 0; i < agents; i++)
+		{
+			out.clear();
+			indexed.QueryEnt(movables[i].GetPosition(), queryRadius, out);
+			found += out.size();
+		}
+		queryMs += std::chrono::duration<double, std::milli>(clock::now() - queryStart).count();
+
+		auto listUpdateStart = clock::now();
+		for (int i = 0; i < agents; i++)
+		{
+			int cell = listCell(movables[i].GetPosition());
+			if (cell == listCells[i])
+				continue;
+			if (listCells[i] != -1)
+			{
+				std::vector<Movable*>& oldCell = cellLists[listCells[i]];
+				oldCell.erase(std::remove(oldCell.begin(), oldCell.end(), &movables[i]), oldCell.end());
+			}
+			cellLists[cell].push_back(&movables[i]);
+			listCells[i] = cell;
+		}
+		listUpdateMs += std::chrono::duration<double, std::milli>(clock::now() - listUpdateStart).count();
+
+		auto listQueryStart = clock::now();
+		for (int i = 0; i < agents; i++)
+		{
+			Vec2 pos = movables[i].GetPosition() - origin;
+			int minX = std::max((int)((pos.x - queryRadius) / cellSize), 0);
+			int maxX = std::min((int)((pos.x + queryRadius) / cellSize), cols - 1);
+			int minY = std::max((int)((pos.y - queryRadius) / cellSize), 0);
+			int maxY = std::min((int)((pos.y + queryRadius) / cellSize), rows - 1);
+
+			out.clear();
+			for (int cy = minY; cy <= maxY; ++cy)
+				for (int cx = minX; cx <= maxX; ++cx)
+					for (Movable* m : cellLists[cy * cols + cx])
+						out.push_back(m);
+			listFound += out.size();
+		}
+		listQueryMs += std::chrono::duration<double, std::milli>(clock::now() - listQueryStart).count();
+
+		// Some queries against a scan of every movable for the cells the query box covers
+		for (int i = frame; i < agents; i += 97)
+		{
+			out.clear();
+			indexed.QueryEnt(movables[i].GetPosition(), queryRadius, out);
+			std::sort(out.begin(), out.end());
+
+			Vec2 pos = movables[i].GetPosition() - origin;
+			int minX = std::max((int)((pos.x - queryRadius) / cellSize), 0);
+			int maxX = std::min((int)((pos.x + queryRadius) / cellSize), cols - 1);
+			int minY = std::max((int)((pos.y - queryRadius) / cellSize), 0);
+			int maxY = std::min((int)((pos.y + queryRadius) / cellSize), rows - 1);
+
+			std::vector<Movable*> expected;
+			for (Movable& m : movables)
+			{
+				int cell = listCell(m.GetPosition());
+				if (cell / cols >= minY && cell / cols <= maxY && cell % cols >= minX && cell % cols <= maxX)
+					expected.push_back(&m);
+			}
+			std::sort(expected.begin(), expected.end());
+
+			checked++;
+			if (out != expected)
+				wrong++;
+		}
+	}
+
+	double queries = (double)agents * frames;
+	std::ostringstream oss;
+	oss << std::fixed << std::setprecision(3);
+	oss << "Movable index benchmark (" << cols << "x" << rows << " grid, " << agents << " movables, " << frames << " frames, queries of radius "
+		<< queryRadius << ")\n";
+	oss << "  rebuilt every frame: " << rebuildMs / frames << " ms per rebuild, " << queryMs * 1000.0 / queries << " us per query, "
+		<< found / queries << " movables per query\n";
+	oss << "  vector per cell: " << listUpdateMs / frames << " ms per frame of updates, " << listQueryMs * 1000.0 / queries << " us per query, "
+		<< listFound / queries << " movables per query\n";
+	oss << "  queries differing from a scan of every movable: " << wrong << " of " << checked << "\n";
+	Logger::Instance().Log(oss.str());
+}
+
+void PathBenchmark::ResourceQueries(Grid& grid, int size, int queries)
+{
+	std::string map = RandomMap(size, Seed(1060));
+	RNG mapRng(Seed(1061));
+	for (char& cell : map)
+		if (cell == 'M' && mapRng.NextU32() % 10 == 0)
+			cell = 'T';
+
+	Grid gameGrid = grid;
+	Grid large(size * 10, size * 10, size, map);
+
+	const PathNode::ResourceType type = PathNode::Wood;
+	const int nearestCount = 8;
+
+	std::ostringstream oss;
+	oss << std::fixed << std::setprecision(3);
+	oss << "Resource index benchmark (" << queries << " queries, the " << nearestCount << " nearest and radius of 5 cells)\n";
+
+	auto measure = [&](Grid& g, const std::string& name)
+		{
+			const ResourceIndex& index = g.GetResourceIndex();
+			float radius = g.cellSize * 5;
+			Vec2 origin = g.GetOrigin();
+			Vec2 extent = Vec2(g.GetCols() * g.cellSize, g.GetRows() * g.cellSize);
+
+			// Every node that started with wood, the list KnownNodesOfType used to filter on every call
+			std::vector<PathNode*> list;
+			for (PathNode& node : g.GetNodes())
+				if (node.resource == type && node.resourceAmount > 0)
+					list.push_back(&node);
+
+			RNG rng(Seed(1062));
+			std::vector<Vec2> positions;
+			for (int i = 0; i < queries; i++)
+				positions.push_back(origin + Vec2(rng.NextFloat01() * extent.x, rng.NextFloat01() * extent.y));
+
+			// The scan: skip nodes without wood left, measure the distance to every other one
+			auto scanNearest = [&](const Vec2& pos, std::vector<int>& out)
+				{
+					std::vector<std::pair<float, int>> all;
+					for (PathNode* node : list)
+					{
+						int row, col;
+						g.WorldToGrid(node->position, row, col);
+						if (g.GetResource(g.Index(col, row)) != type || g.GetResourceAmount(g.Index(col, row)) <= 0)
+							continue;
+						Vec2 offset = g.GetPosition(node->id) - pos;
+						all.push_back({ offset.x * offset.x + offset.y * offset.y, node->id });
+					}
+					size_t count = std::min(all.size(), (size_t)nearestCount);
+					std::partial_sort(all.begin(), all.begin() + count, all.end());
+					for (size_t i = 0; i < count; i++)
+						out.push_back(all[i].second);
+				};
+			auto scanRadius = [&](const Vec2& pos, std::vector<int>& out)
+				{
+					for (PathNode* node : list)
+					{
+						int row, col;
+						g.WorldToGrid(node->position, row, col);
+						if (g.GetResource(g.Index(col, row)) != type || g.GetResourceAmount(g.Index(col, row)) <= 0)
+							continue;
+						Vec2 offset = g.GetPosition(node->id) - pos;
+						if (offset.x * offset.x + offset.y * offset.y <= radius * radius)
+							out.push_back(node->id);
+					}
+					std::sort(out.begin(), out.end());
+				};
+
+			std::vector<int> out;
+			std::vector<int> expected;
+			long long nearestFound = 0;
+			long long radiusFound = 0;
+			int wrong = 0;
+
+			auto nearestStart = clock::now();
+			for (const Vec2& pos : positions)
+			{
+				out.clear();
+				index.QueryNearest(pos, nearestCount, type, out);
+				nearestFound += out.size();
+			}
+			double nearestMs = std::chrono::duration<double, std::milli>(clock::now() - nearestStart).count();
+
+			auto radiusStart = clock::now();
+			for (const Vec2& pos : positions)
+			{
+				out.clear();
+				index.QueryRadius(pos, radius, type, out);
+				radiusFound += out.size();
+			}
+			double radiusMs = std::chrono::duration<double, std::milli>(clock::now() - radiusStart).count();
+
+			auto scanStart = clock::now();
+			for (const Vec2& pos : positions)
+			{
+				expected.clear();
+				scanNearest(pos, expected);
+				scanRadius(pos, expected);
+			}
+			double scanMs = std::chrono::duration<double, std::milli>(clock::now() - scanStart).count();
+
+			// Check every query, then again after half the wood ran out
+			auto check = [&]()
+				{
+					for (const Vec2& pos : positions)
+					{
+						out.clear();
+						expected.clear();
+						index.QueryNearest(pos, nearestCount, type, out);
+						scanNearest(pos, expected);
+						if (out != expected)
+							wrong++;
+
+						out.clear();
+						expected.clear();
+						index.QueryRadius(pos, radius, type, out);
+						scanRadius(pos, expected);
+						if (out != expected)
+							wrong++;
+					}
+				};
+			check();
+			for (size_t i = 0; i < list.size(); i += 2)
+				g.SetResource(list[i], PathNode::None, 0);
+			check();
+
+			oss << "  " << name << ", " << list.size() << " wood nodes: " << nearestMs * 1000.0 / queries << " us per nearest query, "
+				<< radiusMs * 1000.0 / queries << " us per radius query, " << radiusFound / (double)queries << " nodes per radius query, "
+				<< scanMs * 1000.0 / queries << " us to scan the list for both\n";
+			oss << "  " << name << " queries differing from a scan of the list, before and after half the wood ran out: " << wrong << " of "
+				<< queries * 4 << "\n";
+		};
+
+	measure(gameGrid, "game map");
+	measure(large, std::to_string(size) + "x" + std::to_string(size) + " map");
+	Logger::Instance().Log(oss.str());
+}
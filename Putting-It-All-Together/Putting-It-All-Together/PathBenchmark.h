@@ -0,0 +1,173 @@
+#pragma once
+#include "Grid.h"
+
+// Offline pathfinding comparisons run on the loaded grid, results are written to the log
+namespace PathBenchmark
+{
+	// Run every benchmark below
+	void RunAll(Grid& grid);
+
+	// Compare AStar with hash-map records against AStar with the flat record array
+	// --------------------------
+	// grid - the grid to search
+	// queries - the amount of random start/goal pairs to time
+	void RecordStorage(Grid& grid, int queries = 500);
+
+	// Compare AStar against JumpPointSearch, JPS paths must never be longer than the AStar ones
+	// --------------------------
+	// grid - the grid to search
+	// queries - the amount of random start/goal pairs to time
+	void JumpPoint(Grid& grid, int queries = 500);
+
+	// Compare AStar against HierarchicalPathfinder, including the abstract graph build and a cluster repair
+	// --------------------------
+	// grid - the grid to search
+	// queries - the amount of random start/goal pairs to time
+	void Hierarchical(Grid& grid, int queries = 500);
+
+	// Compare one AStar search per agent against one shared FlowField per destination
+	// --------------------------
+	// grid - the grid to search
+	// goals - the amount of random destinations
+	// agents - the amount of random agents walking to each destination
+	void FlowFields(Grid& grid, int goals = 10, int agents = 50);
+
+	// Compare the frame spent on many agents retargeting at once against spreading the searches with AStar::StepSearch
+	// --------------------------
+	// grid - the grid to search
+	// queries - the amount of searches started on the same frame
+	// expansionsPerTick - the node budget all sliced searches share per tick
+	void TimeSliced(Grid& grid, int queries = 200, int expansionsPerTick = 4000);
+
+	// Compare RequestClosestPath searching forwards per target against one search backwards from all targets,
+	// and time FindClosestTargets handing out several targets at once
+	// Every query looks for the closest wood on the map, like a gatherer whose brain knows every tree
+	// --------------------------
+	// grid - the grid to search
+	// queries - the amount of random starts
+	// batch - the amount of closest targets asked from FindClosestTargets
+	void ClosestPath(Grid& grid, int queries = 200, int batch = 8);
+
+	// Compare AStar with the octile heuristic against AStar with the landmark (ALT) heuristic,
+	// then turn nodes into rock and back and check the repaired landmark tables against tables measured from scratch
+	// --------------------------
+	// grid - the grid to search
+	// queries - the amount of random start/goal pairs to time
+	// landmarkCount - the amount of landmarks
+	// edits - the amount of random nodes edited
+	void AltHeuristic(Grid& grid, int queries = 500, int landmarkCount = 8, int edits = 20);
+
+	// Compare AStar against ThetaStar: time, waypoints per path and the line of sight checks while searching and walking
+	// Every segment of the any-angle paths is checked with Grid::HasLineOfSight
+	// --------------------------
+	// grid - the grid to search
+	// queries - the amount of random start/goal pairs to time
+	void AnyAngle(Grid& grid, int queries = 500);
+
+	// Compare replanning from scratch with AStar against repairing a DStarLite while the map is explored
+	// Every agent starts with nothing discovered, scouts reveal the map outwards from the agent's start and
+	// the agent replans and takes one step after every reveal, until it arrives or runs out of steps
+	// --------------------------
+	// grid - the grid to search
+	// agents - the amount of random start/goal pairs, each explored from nothing
+	// revealPerStep - the amount of nodes discovered between two replans
+	void Replanning(Grid& grid, int agents = 20, int revealPerStep = 100);
+
+	// Compare AStar failing on unreachable goals against Reachability rejecting them without a search,
+	// then switch nodes off and on again and check the repaired components against an index labeled from scratch
+	// The filter stands in for a brain that has discovered part of the map, which leaves many separate components
+	// --------------------------
+	// grid - the grid to search
+	// queries - the amount of random start/goal pairs to time
+	// edits - the amount of random nodes edited
+	void Components(Grid& grid, int queries = 500, int edits = 200);
+
+	// Compare AStar given lambdas against AStar given the filters of TraversalFilters.h, which it runs without a std::function call
+	// Both kinds are timed for the terrain filter and for a usable mask like AIBrain::CanUseNode
+	// --------------------------
+	// grid - the grid to search
+	// queries - the amount of random start/goal pairs to time
+	// repeats - the amount of times every filter runs all pairs, the fastest run is kept
+	void FilterPolicies(Grid& grid, int queries = 500, int repeats = 5);
+
+	// Compare AStar searching from the start only against searching from both ends, grouped by the octile distance of the pairs,
+	// and on trips from across the map back to the node AIBrain places its Storage on, grouped the same way
+	// --------------------------
+	// grid - the grid to search
+	// queries - the amount of random start/goal pairs to time
+	// bucketCells - width of the octile distance groups in cells
+	void Bidirectional(Grid& grid, int queries = 1000, float bucketCells = 25.0f);
+
+	// Compare one AStar search per agent against one AStar::RequestPaths call per goal and against building a FlowField per goal,
+	// for groups of 2, 4, 8 and 16 agents sent to the same goal on the same tick
+	// The agents of a group start anywhere on the map, then within clusterCells of each other like workers leaving the same building
+	// --------------------------
+	// grid - the grid to search
+	// goals - the amount of random destinations per group size
+	// clusterCells - the most cells a clustered agent starts away from the first agent of its group
+	void BatchPaths(Grid& grid, int goals = 50, int clusterCells = 6);
+
+	// Compare scoring idle agents for a task at a building with one AStar search per agent, like AIBrain::GetBestAgent used to,
+	// against reading their walking distance off a FlowField per building, like BuildManager::GetDistanceField
+	// The fields are timed built once for every round and rebuilt every round, as when the brain's belief changes every tick
+	// --------------------------
+	// grid - the grid to search
+	// buildings - the amount of random building nodes
+	// agents - the amount of random idle agents scored for every building
+	// rounds - the amount of times every building picks its closest agent
+	void BuildingDistances(Grid& grid, int buildings = 6, int agents = 20, int rounds = 20);
+
+	// Compare the paths AStar returns against the same paths after CompactPath: nodes, memory, length and the cost of following them
+	// Following is timed with a walker stepping a quarter cell per frame towards the next node and moving on within 10 units of it,
+	// like Behaviour::FollowPath. Every compacted segment is checked with Grid::HasLineOfSight
+	// --------------------------
+	// grid - the grid to search
+	// queries - the amount of random start/goal pairs
+	void PathCompaction(Grid& grid, int queries = 500);
+
+	// Compare recomputing all clearance with Grid::SetClearance after every terrain edit against the update Grid::SetTerrain makes
+	// around the edited node, then check the updated clearance and neighbors against a grid recomputed from scratch
+	// Random nodes are turned into rock one after another, then back again in reverse order, on a copy of grid
+	// --------------------------
+	// grid - the grid to copy
+	// edits - the amount of random nodes edited
+	void ClearanceUpdates(Grid& grid, int edits = 200);
+
+	// Compare the clearance Grid::SetClearance got from a breadth first flood against the exact Euclidean distance transform it uses now:
+	// time on grid and on a large random map, the largest error against distances measured to every obstacle,
+	// and the nodes agents of a few radii fit on differently
+	// --------------------------
+	// grid - the grid to copy
+	// largeSize - the amount of rows and columns of the random map
+	void ClearanceTransform(Grid& grid, int largeSize = 1000);
+
+	// Time loading a large random map three ways: the text map read one character at a time, the text map read whole,
+	// and the binary map of MapFile mapped into memory, each including building the grid. Checks the three grids are the same
+	// The map files are written to the temporary directory and removed afterwards
+	// --------------------------
+	// size - the amount of rows and columns of the map
+	void MapLoading(int size = 1000);
+
+	// Time Grid::RebuildMovableIndex and Grid::QueryEnt against the vector of movables per cell Grid used to keep,
+	// with every movable moving and querying around itself each frame, and check queries against a scan of every movable
+	// --------------------------
+	// grid - the grid to copy
+	// agents - the amount of movables
+	// frames - the amount of frames to move them for
+	void MovableIndex(Grid& grid, int agents = 10000, int frames = 20);
+
+	// Time nearest and radius queries of the resource index against scanning a list of every resource node,
+	// on the game map and a large random one, and check them against the scan before and after half the resources run out
+	// --------------------------
+	// grid - the grid to copy
+	// size - the amount of rows and columns of the random map, about one cell in fourteen is wood
+	// queries - the amount of random positions to query around
+	void ResourceQueries(Grid& grid, int size = 500, int queries = 500);
+
+	// Time AStar on a large random map, and the memory its nodes take
+	// The map is generated, about one cell in five is rock and one in ten swamp
+	// --------------------------
+	// size - the amount of rows and columns of the map
+	// queries - the amount of random start/goal pairs to time
+	void LargeGrid(int size = 1000, int queries = 20);
+}
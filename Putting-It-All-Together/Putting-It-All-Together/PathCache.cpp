@@ -0,0 +1,86 @@
+#include "PathCache.h"
+#include "AIBrain.h"
+
+std::vector<PathNode*> PathCache::RequestPath(PathNode* startNode, PathNode* endNode, float& outDist, float agentRadius, const NodeFilter& canTraverse, const AIBrain* belief)
+{
+	std::vector<PathNode*> path;
+	if (Find(startNode, endNode, agentRadius, belief, path, outDist))
+		return path;
+
+	path = pathfinder->RequestPath(startNode, endNode, outDist, agentRadius, canTraverse);
+	Store(startNode, endNode, agentRadius, belief, path, outDist, epoch, BeliefVersion(belief));
+
+	return path;
+}
+
+bool PathCache::Find(const PathNode* startNode, const PathNode* endNode, float agentRadius, const AIBrain* belief, std::vector<PathNode*>& outPath, float& outDist)
+{
+	DropOldEpoch();
+
+	auto it = lookup.find(Key{ startNode, endNode, agentRadius, belief });
+	if (it == lookup.end())
+	{
+		misses++;
+		return false;
+	}
+
+	// The brain learned something since the path was searched, only its own paths are dropped
+	if (it->second->beliefVersion != BeliefVersion(belief))
+	{
+		entries.erase(it->second);
+		lookup.erase(it);
+		misses++;
+		return false;
+	}
+
+	hits++;
+	entries.splice(entries.begin(), entries, it->second);
+	outPath = it->second->path;
+	outDist = it->second->dist;
+	return true;
+}
+
+void PathCache::Store(const PathNode* startNode, const PathNode* endNode, float agentRadius, const AIBrain* belief, const std::vector<PathNode*>& path, float dist,
+	uint32_t searchedEpoch, uint32_t searchedBeliefVersion)
+{
+	if (searchedEpoch != epoch)
+		return;
+	if (belief && searchedBeliefVersion != BeliefVersion(belief))
+		return;
+
+	DropOldEpoch();
+
+	Key key{ startNode, endNode, agentRadius, belief };
+
+	auto it = lookup.find(key);
+	if (it != lookup.end())
+	{
+		entries.erase(it->second);
+		lookup.erase(it);
+	}
+
+	if (entries.size() >= capacity)
+	{
+		lookup.erase(entries.back().key);
+		entries.pop_back();
+	}
+
+	entries.push_front({ key, path, dist, BeliefVersion(belief) });
+	lookup[key] = entries.begin();
+}
+
+void PathCache::DropOldEpoch()
+{
+	// Paths from an older epoch can never be hit again
+	if (cachedEpoch == epoch)
+		return;
+
+	entries.clear();
+	lookup.clear();
+	cachedEpoch = epoch;
+}
+
+uint32_t PathCache::BeliefVersion(const AIBrain* belief)
+{
+	return belief ? belief->GetBeliefVersion() : 0;
+}
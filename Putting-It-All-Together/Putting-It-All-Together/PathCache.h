@@ -0,0 +1,100 @@
+#pragma once
+#include "Pathfinder.h"
+#include <list>
+#include <unordered_map>
+
+class AIBrain;
+
+// Least recently used cache of complete path results in front of a pathfinder
+// Entries are keyed by start, goal, agent radius and the belief they were searched with.
+// An entry only lives as long as the terrain epoch it was stored in and, for a belief, as long as that brain's
+// belief version, so a brain exploring only drops its own paths. Failed searches are cached as well
+class PathCache
+{
+public:
+	// Constructor
+	// --------------------------
+	// pathfinder - the pathfinder asked on a miss, not owned by the cache
+	// capacity - the amount of paths kept before the least recently used is dropped
+	PathCache(Pathfinder* pathfinder, size_t capacity = 512) : pathfinder(pathfinder), capacity(capacity) { }
+
+	// Get the path from start to end, searching only if the same request is cached and still current
+	// --------------------------
+	// belief - the brain whose CanUseNode canTraverse answers like, nullptr if canTraverse only looks at the terrain
+	// --------------------------
+	// returns the same as Pathfinder::RequestPath
+	std::vector<PathNode*> RequestPath(PathNode* startNode, PathNode* endNode, float& outDist, float agentRadius, const NodeFilter& canTraverse, const AIBrain* belief);
+
+	// Look up a request without searching on a miss
+	// --------------------------
+	// returns true and fills outPath and outDist if the request is cached and neither the terrain nor the belief changed since
+	bool Find(const PathNode* startNode, const PathNode* endNode, float agentRadius, const AIBrain* belief, std::vector<PathNode*>& outPath, float& outDist);
+
+	// Store a path searched elsewhere, ignored if the terrain or the belief changed since the search started
+	// --------------------------
+	// searchedEpoch - GetEpoch when the search started
+	// searchedBeliefVersion - AIBrain::GetBeliefVersion of belief when the search started, ignored without a belief
+	void Store(const PathNode* startNode, const PathNode* endNode, float agentRadius, const AIBrain* belief, const std::vector<PathNode*>& path, float dist,
+		uint32_t searchedEpoch, uint32_t searchedBeliefVersion);
+
+	// Start a new terrain epoch, every cached path is dropped
+	// Called whenever a node changes terrain, beliefs are checked through AIBrain::GetBeliefVersion instead
+	void BumpEpoch() { epoch++; }
+
+	uint32_t GetEpoch() const { return epoch; }
+	int GetHits() const { return hits; }
+	int GetMisses() const { return misses; }
+
+private:
+	struct Key
+	{
+		const PathNode* start;
+		const PathNode* goal;
+		float radius;
+		const AIBrain* belief;
+
+		bool operator==(const Key& other) const
+		{
+			return start == other.start && goal == other.goal && radius == other.radius && belief == other.belief;
+		}
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const
+		{
+			size_t h = std::hash<const void*>()(key.start);
+			h = h * 31 + std::hash<const void*>()(key.goal);
+			h = h * 31 + std::hash<float>()(key.radius);
+			h = h * 31 + std::hash<const void*>()(key.belief);
+			return h;
+		}
+	};
+
+	struct Entry
+	{
+		Key key;
+		std::vector<PathNode*> path;
+		float dist;
+		uint32_t beliefVersion; // of key.belief when the path was searched
+	};
+
+	// Clear the cache if the terrain epoch moved on since the last lookup
+	void DropOldEpoch();
+
+	// Get the belief version a path searched for belief now has to match, 0 without a belief
+	static uint32_t BeliefVersion(const AIBrain* belief);
+
+	Pathfinder* pathfinder;
+	size_t capacity;
+
+	// Most recently used first
+	std::list<Entry> entries;
+	std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> lookup;
+
+	uint32_t epoch = 0;
+	uint32_t cachedEpoch = 0;
+
+	int hits = 0;
+	int misses = 0;
+};
@@ -2,6 +2,7 @@
 #include "Vec2.h"
 #include "Constants.h"
 #include <vector>
+#include <cstdint>
 
 class PathNode
 {
@@ -34,6 +35,8 @@ public:
 
 	int id = -1; // Id of the node
 
+	// The terrain, clearance and resource fields of grid nodes are a view of the Grid layers,
+	// change them through Grid::SetNode so both stay the same
 	float size = 0; // radius of this node
 	float clearance = 0;
 	float resourceAmount = 0;
@@ -42,7 +45,7 @@ public:
 
 	ResourceType resource = ResourceType::None;
 
-	std::vector<PathNode*> neighbors; // Adjecent nodes
+	uint8_t neighborMask = 0; // Adjecent nodes, one bit per direction Grid::Neighbors steps in
 	Vec2 position; // Position of the node
 
 	bool IsObstacle() const
@@ -0,0 +1,322 @@
+#include "PathRequestQueue.h"
+#include "GameLoop.h"
+#include "GameAI.h"
+#include "AIBrain.h"
+#include <algorithm>
+
+PathRequestQueue::PathRequestQueue(Grid* grid, PathfinderFactory createPathfinder, int deliveriesPerTick, int workerCount) :
+	grid(grid), createPathfinder(createPathfinder), deliveriesPerTick(deliveriesPerTick)
+{
+	if (workerCount <= 0)
+		workerCount = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+
+	workerVersions.assign(workerCount, 0);
+	workerStarted.assign(workerCount, false);
+	for (int i = 0; i < workerCount; i++)
+		workerGrids.push_back(std::make_unique<Grid>(*grid));
+	for (int i = 0; i < workerCount; i++)
+		workers.emplace_back(&PathRequestQueue::WorkerLoop, this, i);
+}
+
+PathRequestQueue::~PathRequestQueue()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wakeWorkers.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void PathRequestQueue::Submit(GameAI* ai, PathNode* startNode, PathNode* endNode, float agentRadius, AIBrain* belief, uint32_t cacheEpoch)
+{
+	if (!ai || !startNode || !endNode)
+		return;
+
+	Request request;
+	request.ai = ai;
+	request.startId = startNode->id;
+	request.goalId = endNode->id;
+	request.radius = agentRadius;
+	request.belief = belief;
+	request.cacheEpoch = cacheEpoch;
+	Enqueue(std::move(request));
+}
+
+void PathRequestQueue::SubmitClosest(GameAI* ai, PathNode* startNode, const std::vector<PathNode*>& targets, float agentRadius, AIBrain* belief)
+{
+	if (!ai || !startNode || targets.empty())
+		return;
+
+	Request request;
+	request.ai = ai;
+	request.startId = startNode->id;
+	request.targetIds.reserve(targets.size());
+	for (PathNode* target : targets)
+		request.targetIds.push_back(target->id);
+	request.radius = agentRadius;
+	request.belief = belief;
+	request.cacheEpoch = GameLoop::Instance().pathCache ? GameLoop::Instance().pathCache->GetEpoch() : 0;
+	Enqueue(std::move(request));
+}
+
+void PathRequestQueue::Enqueue(Request request)
+{
+	GameAI* ai = request.ai;
+	request.ticket = nextTicket++;
+	request.beliefVersion = request.belief ? request.belief->GetBeliefVersion() : 0;
+	if (request.belief)
+		request.usable = BeliefSnapshot(request.belief);
+
+	pending[ai] = { request.ticket, request.goalId, !request.targetIds.empty() };
+	submitted++;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		request.terrainVersion = terrainVersion;
+
+		// An older request of the same agent that no worker picked up yet is not worth searching
+		requests.erase(std::remove_if(requests.begin(), requests.end(), [ai](const Request& r) { return r.ai == ai; }), requests.end());
+		requests.push_back(std::move(request));
+	}
+	wakeWorkers.notify_one();
+}
+
+void PathRequestQueue::OnNodeChanged(const PathNode* node)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	terrainChanges.push_back({ node->id, node->type });
+	terrainVersion++;
+
+	// Workers that never searched have no pathfinder to repair yet, their copies take the change right away
+	// so they never hold back the log
+	for (size_t i = 0; i < workerGrids.size(); i++)
+	{
+		if (workerStarted[i])
+			continue;
+
+		workerGrids[i]->SetTerrain(workerGrids[i]->GetNode(node->id), node->type);
+		workerVersions[i] = terrainVersion;
+	}
+	TrimChanges();
+}
+
+void PathRequestQueue::TrimChanges()
+{
+	uint64_t oldest = *std::min_element(workerVersions.begin(), workerVersions.end());
+	terrainChanges.erase(terrainChanges.begin(), terrainChanges.begin() + (oldest - changesBase));
+	changesBase = oldest;
+}
+
+bool PathRequestQueue::IsPending(const GameAI* ai, const PathNode* endNode) const
+{
+	auto it = pending.find(ai);
+	return it != pending.end() && endNode && it->second.goalId == endNode->id;
+}
+
+bool PathRequestQueue::IsSearchingClosest(const GameAI* ai) const
+{
+	auto it = pending.find(ai);
+	return it != pending.end() && it->second.closest;
+}
+
+void PathRequestQueue::Cancel(const GameAI* ai)
+{
+	pending.erase(ai);
+	closestTargets.erase(ai);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	requests.erase(std::remove_if(requests.begin(), requests.end(), [ai](const Request& r) { return r.ai == ai; }), requests.end());
+}
+
+void PathRequestQueue::Update()
+{
+	GameLoop& game = GameLoop::Instance();
+
+	deliveredLastTick = 0;
+	while (deliveredLastTick < deliveriesPerTick)
+	{
+		Result result;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (results.empty())
+				return;
+			result = std::move(results.front());
+			results.pop_front();
+		}
+
+		// Drop results of cancelled agents and of requests that were replaced since
+		auto it = pending.find(result.request.ai);
+		if (it == pending.end() || it->second.ticket != result.request.ticket)
+			continue;
+		pending.erase(it);
+
+		std::vector<PathNode*> path;
+		path.reserve(result.path.size());
+		for (int id : result.path)
+			path.push_back(grid->GetNode(id));
+
+		// A closest search ends at the target it found, if it found one
+		bool closest = !result.request.targetIds.empty();
+		PathNode* startNode = grid->GetNode(result.request.startId);
+		PathNode* endNode = nullptr;
+		if (closest)
+			endNode = path.empty() ? nullptr : path.front();
+		else
+			endNode = grid->GetNode(result.request.goalId);
+
+		if (game.pathCache && endNode)
+			game.pathCache->Store(startNode, endNode, result.request.radius, result.request.belief, path, result.dist, result.request.cacheEpoch, result.request.beliefVersion);
+
+		// An agent that walked off the path is searched for again from where it is, once, so a moving agent is not chased forever
+		GameAI* ai = result.request.ai;
+		PathNode* currentNode = grid->GetNodeAt(ai->GetPosition());
+		if (!path.empty() && !StartAt(currentNode, path) && !result.request.resubmitted && currentNode)
+		{
+			Request again = std::move(result.request);
+			again.startId = currentNode->id;
+			again.cacheEpoch = game.pathCache ? game.pathCache->GetEpoch() : 0;
+			again.resubmitted = true;
+			Enqueue(std::move(again));
+			continue;
+		}
+
+		if (closest)
+			closestTargets[ai] = endNode;
+		ai->ReceivePath(std::move(path), result.request.belief == nullptr);
+
+		deliveredLastTick++;
+		delivered++;
+	}
+}
+
+bool PathRequestQueue::StartAt(PathNode* currentNode, std::vector<PathNode*>& path) const
+{
+	if (currentNode == nullptr)
+		return false;
+	if (path.back() == currentNode)
+		return true;
+
+	// Paths run from the goal back to the start, the first match is the furthest along
+	for (size_t i = 0; i < path.size(); i++)
+	{
+		if (path[i] != currentNode && !grid->AreNeighbors(currentNode, path[i]))
+			continue;
+
+		path.resize(i + 1);
+		if (path[i] != currentNode)
+			path.push_back(currentNode);
+		return true;
+	}
+
+	return false;
+}
+
+std::string PathRequestQueue::GetStatus() const
+{
+	return "Path requests: " + std::to_string(pending.size()) + " pending, " + std::to_string(deliveredLastTick) + " delivered this tick";
+}
+
+void PathRequestQueue::WorkerLoop(int index)
+{
+	Grid* searchGrid = workerGrids[index].get();
+	std::unique_ptr<Pathfinder> pathfinder;
+	uint64_t replayed = 0;
+	std::vector<TerrainChange> changes;
+
+	while (true)
+	{
+		Request request;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeWorkers.wait(lock, [this] { return stopping || !requests.empty(); });
+			if (stopping)
+				return;
+			request = std::move(requests.front());
+			requests.pop_front();
+
+			// Until now the game thread kept the copy up to date, it may already be past the request
+			if (!workerStarted[index])
+			{
+				workerStarted[index] = true;
+				replayed = workerVersions[index];
+			}
+
+			// Requests are taken in the order they were submitted, so a worker only ever has to catch up
+			uint64_t version = std::max(replayed, request.terrainVersion);
+			changes.assign(terrainChanges.begin() + (replayed - changesBase), terrainChanges.begin() + (version - changesBase));
+			replayed = version;
+			workerVersions[index] = replayed;
+			TrimChanges();
+		}
+
+		// The same steps Grid::SetNode takes on the live grid, for this worker's copy and pathfinder
+		for (const TerrainChange& change : changes)
+		{
+			PathNode* node = searchGrid->GetNode(change.id);
+			searchGrid->SetTerrain(node, change.type);
+			if (!pathfinder)
+				continue;
+
+			pathfinder->OnNodeChanged(node);
+			for (int id : searchGrid->GetClearanceChanges())
+				pathfinder->OnNodeChanged(searchGrid->GetNode(id));
+		}
+
+		// Created on the first request, a pathfinder created after the changes already searches the changed copy
+		if (!pathfinder)
+			pathfinder.reset(createPathfinder(searchGrid));
+
+		NodeFilter filter;
+		if (request.usable)
+		{
+			filter = MaskFilter{ request.usable->data() };
+		}
+		else
+			filter = TerrainFilter();
+
+		Result result;
+		std::vector<PathNode*> path;
+		if (request.targetIds.empty())
+		{
+			path = pathfinder->RequestPath(
+				searchGrid->GetNode(request.startId),
+				searchGrid->GetNode(request.goalId),
+				result.dist, request.radius, filter);
+		}
+		else
+		{
+			std::vector<PathNode*> targets;
+			targets.reserve(request.targetIds.size());
+			for (int id : request.targetIds)
+				targets.push_back(searchGrid->GetNode(id));
+			path = pathfinder->RequestClosestPath(searchGrid->GetNode(request.startId), targets, result.dist, request.radius, filter);
+		}
+
+		result.path.reserve(path.size());
+		for (PathNode* node : path)
+			result.path.push_back(node->id);
+
+		// The belief copy is released on this thread, not while the game thread holds the lock
+		request.usable.reset();
+		result.request = std::move(request);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		results.push_back(std::move(result));
+	}
+}
+
+std::shared_ptr<const std::vector<uint8_t>> PathRequestQueue::BeliefSnapshot(AIBrain* belief)
+{
+	Belief& snapshot = beliefs[belief];
+	if (snapshot.usable && snapshot.version == belief->GetBeliefVersion())
+		return snapshot.usable;
+
+	auto usable = std::make_shared<std::vector<uint8_t>>(belief->GetUsableNodes());
+
+	snapshot.version = belief->GetBeliefVersion();
+	snapshot.usable = usable;
+	return snapshot.usable;
+}
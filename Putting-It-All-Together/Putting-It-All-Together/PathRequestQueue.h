@@ -0,0 +1,161 @@
+#pragma once
+#include "Pathfinder.h"
+#include "PathRequestService.h"
+#include "Grid.h"
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+// Path searches served by worker threads
+// Every worker searches its own copy of the grid with its own pathfinder, both kept for the life of the queue.
+// Terrain changes are logged and replayed on a worker's copy and forwarded to its pathfinder before it searches
+// a request submitted after them, so pathfinders that repair themselves, like HierarchicalPathfinder, only redo what changed.
+// The copies of workers that never took a request are changed by the game thread right away instead, so idle workers hold back no log.
+// Requests also carry a copy of the requesting brain's belief taken when they were submitted,
+// so the game thread never waits on a search and a search never reads state the game thread is writing.
+// At most deliveriesPerTick finished paths are handed out per Update, so frame time stays bounded
+class PathRequestQueue : public PathRequestService
+{
+public:
+	using PathfinderFactory = std::function<Pathfinder*(Grid*)>;
+
+	// Constructor
+	// --------------------------
+	// grid - the live grid, copied once per worker
+	// createPathfinder - creates the pathfinder a worker searches with, one per worker
+	// deliveriesPerTick - the most paths handed out per Update, the rest wait for the next tick
+	// workerCount - the amount of worker threads, 0 picks one less than the hardware threads
+	PathRequestQueue(Grid* grid, PathfinderFactory createPathfinder, int deliveriesPerTick, int workerCount = 0);
+	~PathRequestQueue();
+
+	PathRequestQueue(const PathRequestQueue&) = delete;
+	void operator=(const PathRequestQueue&) = delete;
+
+	// Overrides base Submit
+	void Submit(GameAI* ai, PathNode* startNode, PathNode* endNode, float agentRadius, AIBrain* belief, uint32_t cacheEpoch) override;
+
+	// Overrides base SubmitClosest, searched by the workers like the other requests
+	void SubmitClosest(GameAI* ai, PathNode* startNode, const std::vector<PathNode*>& targets, float agentRadius, AIBrain* belief) override;
+
+	// Overrides base IsPending
+	bool IsPending(const GameAI* ai, const PathNode* endNode) const override;
+
+	// Overrides base IsSearchingClosest
+	bool IsSearchingClosest(const GameAI* ai) const override;
+
+	// Overrides base Cancel
+	void Cancel(const GameAI* ai) override;
+
+	// Overrides base Update, hands finished paths to their agents
+	void Update() override;
+
+	// Overrides base OnNodeChanged, the change reaches the copies of the workers before they search a later request
+	void OnNodeChanged(const PathNode* node) override;
+
+	// Overrides base GetStatus
+	std::string GetStatus() const override;
+
+	int GetSubmitted() const { return submitted; }
+	int GetDelivered() const { return delivered; }
+
+private:
+	struct Request
+	{
+		uint64_t ticket = 0;
+		GameAI* ai = nullptr;
+		int startId = -1;
+		int goalId = -1;
+		std::vector<int> targetIds; // searched for the closest of them instead of goalId when not empty
+		float radius = 0;
+		AIBrain* belief = nullptr;
+		uint32_t cacheEpoch = 0;
+		uint32_t beliefVersion = 0; // of belief at submission, with cacheEpoch decides if the result may be cached
+		uint64_t terrainVersion = 0; // terrain changes the search has to see
+		bool resubmitted = false;    // searched again because the agent had left the first path, see StartAt
+		std::shared_ptr<const std::vector<uint8_t>> usable; // CanUseNode per node id, empty without a belief
+	};
+
+	struct Result
+	{
+		Request request;
+		std::vector<int> path; // node ids, ordered like Pathfinder::RequestPath
+		float dist = -1;
+	};
+
+	struct Pending
+	{
+		uint64_t ticket = 0;
+		int goalId = -1;
+		bool closest = false; // searching for the closest of several targets
+	};
+
+	// A node that changed terrain
+	struct TerrainChange
+	{
+		int id = -1;
+		PathNode::Type type = PathNode::Nothing;
+	};
+
+	struct Belief
+	{
+		uint32_t version = 0;
+		std::shared_ptr<const std::vector<uint8_t>> usable;
+	};
+
+	// Queue a request, replacing any request its agent still has pending
+	// Gives it a ticket and the belief and terrain versions of now
+	void Enqueue(Request request);
+
+	// Search the requests on one worker thread
+	// --------------------------
+	// index - the worker, its entry in workerGrids and workerVersions
+	void WorkerLoop(int index);
+
+	// Drop the terrain changes every worker replayed, called with the lock held
+	void TrimChanges();
+
+	// Start a delivered path where its agent stands now, the agent kept walking while the path was searched and waited
+	// The path is cut at the first node, counted from the goal, that is the agent's node or next to it
+	// --------------------------
+	// currentNode - the node the agent stands on
+	// --------------------------
+	// returns false if the agent's node is not on or next to the path
+	bool StartAt(PathNode* currentNode, std::vector<PathNode*>& path) const;
+
+	// Get the copy of belief's CanUseNode answers, copied if the belief changed
+	std::shared_ptr<const std::vector<uint8_t>> BeliefSnapshot(AIBrain* belief);
+
+	Grid* grid;
+	PathfinderFactory createPathfinder;
+	int deliveriesPerTick;
+
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable wakeWorkers;
+	std::deque<Request> requests;
+	std::deque<Result> results;
+	bool stopping = false;
+
+	// Terrain changes not every worker replayed yet, the oldest one is change number changesBase
+	std::deque<TerrainChange> terrainChanges;
+	uint64_t changesBase = 0;
+	uint64_t terrainVersion = 0;          // changes made so far
+	std::vector<uint64_t> workerVersions; // changes each worker replayed
+	std::vector<bool> workerStarted;      // the worker took a request, from then on only it touches its grid copy
+
+	// Each worker's copy of the grid, taken on the game thread, which keeps it up to date until the worker starts
+	std::vector<std::unique_ptr<Grid>> workerGrids;
+
+	// Game thread only
+	std::map<const GameAI*, Pending> pending; // latest request of every agent still waiting
+	std::map<const AIBrain*, Belief> beliefs;
+	uint64_t nextTicket = 1;
+
+	int submitted = 0;
+	int delivered = 0;
+	int deliveredLastTick = 0;
+};
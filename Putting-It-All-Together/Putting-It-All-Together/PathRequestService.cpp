@@ -0,0 +1,33 @@
+#include "PathRequestService.h"
+#include "GameLoop.h"
+#include "GameAI.h"
+#include "AIBrain.h"
+
+void PathRequestService::SubmitClosest(GameAI* ai, PathNode* startNode, const std::vector<PathNode*>& targets, float agentRadius, AIBrain* belief)
+{
+	if (!ai || !startNode || targets.empty())
+		return;
+
+	NodeFilter filter;
+	if (belief)
+		filter = belief->UsableFilter();
+	else
+		filter = TerrainFilter();
+
+	float dist;
+	std::vector<PathNode*> path = GameLoop::Instance().pathfinder->RequestClosestPath(startNode, targets, dist, agentRadius, filter);
+
+	closestTargets[ai] = path.empty() ? nullptr : path.front();
+	ai->ReceivePath(std::move(path), belief == nullptr);
+}
+
+bool PathRequestService::TakeClosestTarget(const GameAI* ai, PathNode*& target)
+{
+	auto it = closestTargets.find(ai);
+	if (it == closestTargets.end())
+		return false;
+
+	target = it->second;
+	closestTargets.erase(it);
+	return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "PathNode.h"
+#include <map>
+#include <string>
+#include <vector>
+
+class GameAI;
+class AIBrain;
+
+// Path searches answered on a later tick
+// Finished paths are handed to their agents through GameAI::ReceivePath from the game thread
+class PathRequestService
+{
+public:
+	virtual ~PathRequestService() = default;
+
+	// Queue a path search for ai, replacing any request ai still has pending
+	// --------------------------
+	// belief - the brain whose CanUseNode the search respects, nullptr to only avoid obstacles
+	// cacheEpoch - the PathCache epoch at submission, the result is only cached if it did not change
+	virtual void Submit(GameAI* ai, PathNode* startNode, PathNode* endNode, float agentRadius, AIBrain* belief, uint32_t cacheEpoch) = 0;
+
+	// Queue a search for the closest of several targets for ai, replacing any request ai still has pending
+	// The path is handed out through GameAI::ReceivePath like the others, the target it ends at through TakeClosestTarget
+	// Services that do not queue these search on the spot
+	// --------------------------
+	// belief - the brain whose CanUseNode the search respects, nullptr to only avoid obstacles
+	virtual void SubmitClosest(GameAI* ai, PathNode* startNode, const std::vector<PathNode*>& targets, float agentRadius, AIBrain* belief);
+
+	// Check if ai is waiting on a path to endNode
+	virtual bool IsPending(const GameAI* ai, const PathNode* endNode) const = 0;
+
+	// Check if ai is waiting on a search for the closest of several targets
+	virtual bool IsSearchingClosest(const GameAI* ai) const { return false; }
+
+	// Take the target the latest finished closest search of ai ended at
+	// --------------------------
+	// returns false if no closest search of ai finished since the last call, target is nullptr if no target could be reached
+	bool TakeClosestTarget(const GameAI* ai, PathNode*& target);
+
+	// Forget every request of ai, called before the agent is deleted
+	virtual void Cancel(const GameAI* ai) = 0;
+
+	// Advance the searches and hand out finished paths, called once per tick from the game thread
+	virtual void Update() = 0;
+
+	// Called by the grid when the terrain of a node changes
+	virtual void OnNodeChanged(const PathNode* node) { }
+
+	// Get a line describing the work of the latest tick for the debug overlay
+	virtual std::string GetStatus() const = 0;
+
+protected:
+	std::map<const GameAI*, PathNode*> closestTargets; // targets of finished closest searches not taken yet
+};
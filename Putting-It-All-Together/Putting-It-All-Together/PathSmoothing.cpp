@@ -0,0 +1,61 @@
+#include "PathSmoothing.h"
+#include <algorithm>
+
+int RefinedFrom(const Grid& grid, const std::vector<PathNode*>& path)
+{
+	int first = (int)path.size() - 1;
+	while (first > 0 && grid.AreNeighbors(path[first], path[first - 1]))
+		first--;
+	return std::max(first, 0);
+}
+
+int CompactPath(const Grid& grid, std::vector<PathNode*>& path, float agentRadius, const NodeFilter& canTraverse)
+{
+	int first = RefinedFrom(grid, path);
+	if ((int)path.size() - first < 3)
+		return 0;
+
+	int cols = grid.GetCols();
+	PathNode* destination = path.front();
+
+	int sightChecks = 0;
+	auto shortcut = [&](const PathNode* from, const PathNode* to)
+		{
+			sightChecks++;
+			return grid.HasLineOfSight(from, to, agentRadius, [&](const PathNode* node)
+				{
+					return node == destination || (canTraverse(node) && SurfaceSpeed(node->type) == 1.0f);
+				});
+		};
+
+	// Kept nodes are written from the back, where the start is, towards the front, never ahead of the node being read
+	int kept = (int)path.size() - 1;
+	PathNode* anchor = path.back();
+
+	for (int i = kept - 1; i > first; i--)
+	{
+		PathNode* node = path[i];
+		PathNode* next = path[i - 1];
+
+		int row = anchor->id / cols;
+		int col = anchor->id % cols;
+		int dRow = node->id / cols - row;
+		int dCol = node->id % cols - col;
+		int nextRow = next->id / cols - node->id / cols;
+		int nextCol = next->id % cols - node->id % cols;
+
+		// In the middle of a straight run of neighboring cells the agent walks the same cells without stopping at node
+		bool straight = dRow * nextCol == dCol * nextRow && dRow * nextRow + dCol * nextCol > 0;
+
+		if (straight || shortcut(anchor, next))
+			continue;
+
+		anchor = node;
+		path[--kept] = node;
+	}
+
+	path[--kept] = path[first];
+	path.erase(path.begin() + first, path.begin() + kept);
+
+	return sightChecks;
+}
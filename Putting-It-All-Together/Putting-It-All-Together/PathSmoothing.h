@@ -0,0 +1,29 @@
+#pragma once
+#include "Pathfinder.h"
+#include "Grid.h"
+
+// Post-processing for paths handed to agents
+// Drops the nodes an agent would walk past in a straight line anyway: first the ones in the middle of a straight run,
+// then the ones a straight line from the previous kept node to the next one avoids (string pulling).
+// Every two neighboring nodes of a compacted path can be walked in a straight line by an agent of the given radius.
+// Only the part of a path at its start made of steps between neighboring cells is compacted, waypoints further on,
+// like the ones HierarchicalPathfinder leaves for RefineSegment, are kept where they are
+
+// Get where the part of a path at its start made of steps between neighboring cells begins
+// --------------------------
+// path - the path ordered like Pathfinder::RequestPath, from the destination back to the start
+// --------------------------
+// returns the index of the first node of that part, 0 if every step of the path is one
+int RefinedFrom(const Grid& grid, const std::vector<PathNode*>& path);
+
+// Compact a path in place, the nodes before RefinedFrom keep their index
+// Shortcuts follow the rules of ThetaStar: the line may only cross cells the filter accepts, the agent fits on and of normal speed,
+// so a path through swamp keeps its cells there. The destination itself may be one the filter rejects, like the pathfinders allow
+// --------------------------
+// grid - the grid the path was searched on
+// path - the path ordered like Pathfinder::RequestPath, from the destination back to the start
+// agentRadius - the radius of the agent that will walk the path
+// canTraverse - the filter the path was searched with
+// --------------------------
+// returns the amount of line of sight checks made
+int CompactPath(const Grid& grid, std::vector<PathNode*>& path, float agentRadius, const NodeFilter& canTraverse);
@@ -2,13 +2,99 @@
 #include "PathNode.h"
 #include "Constants.h"
 #include <unordered_map>
+#include <unordered_set>
 #include <functional>
+#include <limits>
 
 using NodeFilter = std::function<bool(const PathNode*)>;
 
+// Entry in the open list of the best-first searches
+struct OpenEntry
+{
+	PathNode* node;
+	float f;
+};
+
+struct OpenEntryCompare
+{
+	bool operator()(OpenEntry& a, OpenEntry& b) const
+	{
+		return a.f > b.f; // min-heap by f
+	}
+};
+
+// Search records kept in hash containers that are rebuilt for every search
+struct NodeRecordMap
+{
+	std::unordered_map<PathNode*, NodeRecord> records;
+	std::unordered_set<PathNode*> closed;
+
+	void NewSearch(size_t nodeCount) { (void)nodeCount; records.clear(); closed.clear(); }
+
+	NodeRecord& Get(PathNode* node) { return records[node]; }
+	const NodeRecord& At(PathNode* node) const { return records.at(node); }
+
+	bool Has(PathNode* node) const { return records.find(node) != records.end(); }
+
+	bool IsClosed(PathNode* node) const { return closed.find(node) != closed.end(); }
+	void Close(PathNode* node) { closed.insert(node); }
+};
+
+// Search records kept in a flat array indexed by PathNode::id
+// Every entry carries a generation stamp, so the array is reused between searches without clearing
+class NodeRecordArray
+{
+public:
+	// Start a new search
+	// --------------------------
+	// nodeCount - the amount of nodes in the grid
+	void NewSearch(size_t nodeCount)
+	{
+		if (records.size() < nodeCount)
+		{
+			records.resize(nodeCount);
+			stamps.resize(nodeCount, 0);
+		}
+
+		// Each generation uses two stamps: generation = seen, generation + 1 = closed
+		if (generation >= std::numeric_limits<uint32_t>::max() - 2)
+		{
+			std::fill(stamps.begin(), stamps.end(), 0);
+			generation = 0;
+		}
+		generation += 2;
+	}
+
+	NodeRecord& Get(const PathNode* node)
+	{
+		uint32_t& stamp = stamps[node->id];
+		NodeRecord& rec = records[node->id];
+		if (stamp < generation)
+		{
+			rec = NodeRecord();
+			stamp = generation;
+		}
+		return rec;
+	}
+
+	const NodeRecord& At(const PathNode* node) const { return records[node->id]; }
+
+	bool Has(const PathNode* node) const { return stamps[node->id] >= generation; }
+
+	bool IsClosed(const PathNode* node) const { return stamps[node->id] == generation + 1; }
+	void Close(const PathNode* node) { Get(node); stamps[node->id] = generation + 1; }
+
+private:
+	std::vector<NodeRecord> records;
+	std::vector<uint32_t> stamps;
+	uint32_t generation = 0;
+};
+
 class Pathfinder
 {
 public:
+	virtual ~Pathfinder() = default;
+
 	// Get the path from start to end
 	// --------------------------
 	// startNode - reference to the node where the path start
@@ -19,11 +105,47 @@ public:
 	virtual std::vector<PathNode*> RequestPath(PathNode* startNode, PathNode* endNode, float& outDist, float agentRadius, const NodeFilter& canTraverse) = 0;
 	virtual std::vector<PathNode*> RequestClosestPath(PathNode* startNode, const std::vector<PathNode*>& possibleEndNodes, float& outDist, float agentRadius, const NodeFilter& canTraverse) = 0;
 
+	// Get the paths from several start nodes to the same end node
+	// Pathfinders that can answer all starts with one search override this, the default asks RequestPath for every start
+	// --------------------------
+	// startNodes - the nodes the paths start at
+	// outDists - output parameter to receive the distance of every path, -1 where there is none
+	// --------------------------
+	// returns one path per start node in the same order, each ordered like RequestPath
+	virtual std::vector<std::vector<PathNode*>> RequestPaths(const std::vector<PathNode*>& startNodes, PathNode* endNode, std::vector<float>& outDists, float agentRadius, const NodeFilter& canTraverse)
+	{
+		std::vector<std::vector<PathNode*>> paths(startNodes.size());
+		outDists.assign(startNodes.size(), -1);
+		int expanded = 0;
+		for (size_t i = 0; i < startNodes.size(); i++)
+		{
+			paths[i] = RequestPath(startNodes[i], endNode, outDists[i], agentRadius, canTraverse);
+			expanded += lastExpanded;
+		}
+		lastExpanded = expanded;
+		return paths;
+	}
+
+	// Get the cells between two consecutive nodes of a path that are not adjacent
+	// Only pathfinders that return partially refined paths need to override this
+	// --------------------------
+	// from - the node the agent is walking from
+	// to - the next node in the path
+	// --------------------------
+	// returns the path from to back to from including both, empty if the agent can no longer get there
+	virtual std::vector<PathNode*> RefineSegment(PathNode* from, PathNode* to, float agentRadius, const NodeFilter& canTraverse) { return std::vector<PathNode*>(); }
+
+	// Called by the grid when the terrain of a node changes
+	virtual void OnNodeChanged(const PathNode* node) { }
+
 	// Get the name of the algorithm
 	// --------------------------
 	// returns a string of the name of the algorithm
 	virtual std::string GetName() const = 0;
 
+	// Get the amount of nodes expanded by the latest request
+	int GetLastExpanded() const { return lastExpanded; }
+
 protected:
 	// Get the path from the beginning to the end after calculations
 	// --------------------------
@@ -39,4 +161,20 @@ protected:
 		//std::reverse(path.begin(), path.end());
 		return path;
 	}
+
+	std::vector<PathNode*> ReconstructPath(const NodeRecordMap& records, PathNode* endNode)
+	{
+		return ReconstructPath(records.records, endNode);
+	}
+
+	std::vector<PathNode*> ReconstructPath(const NodeRecordArray& records, PathNode* endNode)
+	{
+		std::vector<PathNode*> path;
+		for (PathNode* n = endNode; n != nullptr; n = records.At(n).parent)
+			path.push_back(n);
+
+		return path;
+	}
+
+	int lastExpanded = 0;
 };
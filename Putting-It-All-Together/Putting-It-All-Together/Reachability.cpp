@@ -0,0 +1,312 @@
+#include "Reachability.h"
+#include <algorithm>
+#include <cmath>
+
+bool Reachability::MayReach(const PathNode* start, const PathNode* goal, float agentRadius)
+{
+	if (start == nullptr || goal == nullptr || start == goal)
+		return true;
+
+	// The pathfinders move goals the agent does not fit on to a neighbor first, leave those to them
+	if (goal->clearance < agentRadius)
+		return true;
+
+	// A goal next to the start is entered directly, whatever the filter says about either
+	if (grid->AreNeighbors(start, goal))
+		return true;
+
+	Labels& labels = LabelsFor(agentRadius);
+
+	int startLabels[9];
+	int goalLabels[9];
+	int startCount = Entry(labels, start, startLabels);
+	int goalCount = Entry(labels, goal, goalLabels);
+
+	for (int i = 0; i < startCount; i++)
+		for (int j = 0; j < goalCount; j++)
+			if (startLabels[i] == goalLabels[j])
+				return true;
+
+	return false;
+}
+
+void Reachability::OnNodeChanged(const PathNode* node)
+{
+	if (node == nullptr)
+		return;
+
+	for (Labels& labels : radii)
+		Update(labels, node->id);
+}
+
+int Reachability::GetComponentCount(float agentRadius)
+{
+	return LabelsFor(agentRadius).count;
+}
+
+Reachability::Labels& Reachability::LabelsFor(float agentRadius)
+{
+	for (Labels& labels : radii)
+		if (labels.radius == agentRadius)
+			return labels;
+
+	cols = grid->GetCols();
+	size_t nodeCount = grid->GetRows() * cols;
+
+	radii.emplace_back();
+	Labels& labels = radii.back();
+	labels.radius = agentRadius;
+	labels.label.assign(nodeCount, -1);
+	labels.passes.assign(nodeCount, 0);
+	labels.fits.assign(nodeCount, 0);
+
+	for (PathNode& node : grid->GetNodes())
+	{
+		bool passes = canTraverse(&node);
+		labels.passes[node.id] = passes;
+		labels.fits[node.id] = passes && node.clearance >= agentRadius;
+	}
+
+	long long relabeledBefore = relabeled;
+	for (size_t id = 0; id < nodeCount; id++)
+		if (labels.fits[id] && labels.label[id] == -1)
+			Relabel(labels, (int)id, -1, NewLabel(labels));
+	relabeled = relabeledBefore;
+
+	return labels;
+}
+
+void Reachability::Update(Labels& labels, int id)
+{
+	PathNode* node = grid->GetNode(id);
+
+	bool oldPasses = labels.passes[id];
+	bool oldFits = labels.fits[id];
+	bool newPasses = canTraverse(node);
+	bool newFits = newPasses && node->clearance >= labels.radius;
+
+	if (oldPasses == newPasses && oldFits == newFits)
+		return;
+
+	labels.passes[id] = newPasses;
+	labels.fits[id] = newFits;
+
+	// The node and the neighbors the agent fits on are the only ends of steps that changed
+	std::vector<int> ring;
+	for (PathNode* neighbor : grid->Around(node))
+		if (labels.fits[neighbor->id])
+			ring.push_back(neighbor->id);
+
+	if ((oldFits && !newFits) || (oldPasses && !newPasses))
+	{
+		if (oldFits)
+		{
+			int oldLabel = labels.label[id];
+			labels.label[id] = -1;
+			if (--labels.sizes[oldLabel] == 0)
+				labels.count--;
+		}
+
+		// A component can only have split if its nodes around the changed node no longer connect among themselves
+		std::vector<int> group(ring.size());
+		for (size_t i = 0; i < ring.size(); i++)
+			group[i] = (int)i;
+		auto find = [&](int i) { while (group[i] != i) i = group[i] = group[group[i]]; return i; };
+
+		for (size_t i = 0; i < ring.size(); i++)
+			for (size_t j = i + 1; j < ring.size(); j++)
+				if (Connected(labels, ring[i], ring[j]))
+					group[find((int)i)] = find((int)j);
+
+		for (size_t i = 0; i < ring.size(); i++)
+		{
+			for (size_t j = i + 1; j < ring.size(); j++)
+			{
+				// Another group of the same component, the floods tell if a path around still joins them
+				if (labels.label[ring[j]] == labels.label[ring[i]] && find((int)i) != find((int)j))
+					Split(labels, ring[i], ring[j]);
+			}
+		}
+	}
+
+	if ((!oldFits && newFits) || (!oldPasses && newPasses))
+	{
+		// Gains can only join components
+		if (newFits)
+		{
+			for (int neighbor : ring)
+			{
+				if (!Connected(labels, id, neighbor))
+					continue;
+
+				if (labels.label[id] == -1)
+				{
+					labels.label[id] = labels.label[neighbor];
+					labels.sizes[labels.label[id]]++;
+				}
+				else
+				{
+					Merge(labels, id, neighbor);
+				}
+			}
+
+			if (labels.label[id] == -1)
+			{
+				labels.label[id] = NewLabel(labels);
+				labels.sizes[labels.label[id]] = 1;
+				labels.count++;
+			}
+		}
+
+		// Diagonal steps cutting past the node may have opened up
+		for (size_t i = 0; i < ring.size(); i++)
+			for (size_t j = i + 1; j < ring.size(); j++)
+				if (Connected(labels, ring[i], ring[j]))
+					Merge(labels, ring[i], ring[j]);
+	}
+}
+
+bool Reachability::Connected(const Labels& labels, int a, int b) const
+{
+	if (!labels.fits[a] || !labels.fits[b])
+		return false;
+
+	int row = a / cols;
+	int col = a % cols;
+	int otherRow = b / cols;
+	int otherCol = b % cols;
+
+	if (std::abs(row - otherRow) > 1 || std::abs(col - otherCol) > 1)
+		return false;
+
+	// Same rule as AStar: a diagonal step needs both cells it cuts past to pass the filter
+	if (row != otherRow && col != otherCol)
+		return labels.passes[row * cols + otherCol] && labels.passes[otherRow * cols + col];
+
+	return true;
+}
+
+void Reachability::Split(Labels& labels, int a, int b)
+{
+	int oldLabel = labels.label[a];
+
+	if (seen.size() != labels.label.size())
+		seen.assign(labels.label.size(), 0);
+	seenGeneration += 2;
+
+	// Flood from both sides one node at a time, the side that runs out first is the smaller part of a split
+	std::vector<int>* queues[2] = { &splitQueues[0], &splitQueues[1] };
+	size_t heads[2] = { 0, 0 };
+	for (int side = 0; side < 2; side++)
+	{
+		queues[side]->clear();
+		queues[side]->push_back(side == 0 ? a : b);
+		seen[side == 0 ? a : b] = seenGeneration + side;
+	}
+
+	while (true)
+	{
+		for (int side = 0; side < 2; side++)
+		{
+			std::vector<int>& queue = *queues[side];
+			if (heads[side] == queue.size())
+			{
+				// Split, everything this side reached is cut off from the other side
+				int newLabel = NewLabel(labels);
+				for (int id : queue)
+					labels.label[id] = newLabel;
+				relabeled += queue.size();
+				labels.sizes[oldLabel] -= (int)queue.size();
+				labels.sizes[newLabel] = (int)queue.size();
+				labels.count++;
+				return;
+			}
+
+			int id = queue[heads[side]++];
+			for (PathNode* neighbor : grid->Neighbors(grid->GetNode(id)))
+			{
+				if (labels.label[neighbor->id] != oldLabel || !Connected(labels, id, neighbor->id))
+					continue;
+
+				int mark = seen[neighbor->id];
+				if (mark == seenGeneration + 1 - side)
+					return; // the floods met, still one component
+				if (mark == seenGeneration + side)
+					continue;
+
+				seen[neighbor->id] = seenGeneration + side;
+				queue.push_back(neighbor->id);
+			}
+		}
+	}
+}
+
+void Reachability::Relabel(Labels& labels, int from, int oldLabel, int newLabel)
+{
+	int moved = 0;
+	labels.label[from] = newLabel;
+	stack.clear();
+	stack.push_back(from);
+
+	while (!stack.empty())
+	{
+		int id = stack.back();
+		stack.pop_back();
+		moved++;
+
+		for (PathNode* neighbor : grid->Neighbors(grid->GetNode(id)))
+		{
+			if (labels.label[neighbor->id] != oldLabel || !Connected(labels, id, neighbor->id))
+				continue;
+
+			labels.label[neighbor->id] = newLabel;
+			stack.push_back(neighbor->id);
+		}
+	}
+
+	relabeled += moved;
+
+	if (oldLabel >= 0)
+	{
+		labels.sizes[oldLabel] -= moved;
+		if (labels.sizes[oldLabel] == 0)
+			labels.count--;
+	}
+	if (labels.sizes[newLabel] == 0)
+		labels.count++;
+	labels.sizes[newLabel] += moved;
+}
+
+void Reachability::Merge(Labels& labels, int a, int b)
+{
+	int labelA = labels.label[a];
+	int labelB = labels.label[b];
+	if (labelA == labelB || labelA == -1 || labelB == -1)
+		return;
+
+	if (labels.sizes[labelA] < labels.sizes[labelB])
+		Relabel(labels, a, labelA, labelB);
+	else
+		Relabel(labels, b, labelB, labelA);
+}
+
+int Reachability::NewLabel(Labels& labels)
+{
+	labels.sizes.push_back(0);
+	return (int)labels.sizes.size() - 1;
+}
+
+int Reachability::Entry(Labels& labels, const PathNode* node, int* out)
+{
+	if (labels.fits[node->id])
+	{
+		out[0] = labels.label[node->id];
+		return 1;
+	}
+
+	int count = 0;
+	for (PathNode* neighbor : grid->Neighbors(node))
+		if (labels.fits[neighbor->id])
+			out[count++] = labels.label[neighbor->id];
+	return count;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "Pathfinder.h"
+#include "Grid.h"
+#include <vector>
+
+// Connected components of the nodes a filter accepts, per agent radius
+// Two nodes in different components can never be joined by a path, so such requests are rejected without a search.
+// Components follow the steps the searches take: 8 neighbors, no cutting past corners the filter rejects.
+// Nodes that start accepting the filter merge components, nodes that stop may split one, which relabels only that component
+class Reachability
+{
+public:
+	// Constructor
+	// --------------------------
+	// grid - the grid to label
+	// canTraverse - the filter of the searches this index answers for, OnNodeChanged must be called when its answer changes
+	Reachability(Grid* grid, NodeFilter canTraverse) : grid(grid), canTraverse(canTraverse) { }
+
+	// Check if a path from start to goal can exist
+	// Like the pathfinders the start itself does not need to be accepted by the filter, and neither does the goal
+	// --------------------------
+	// returns false only if no pathfinder could find a path, true does not promise one
+	bool MayReach(const PathNode* start, const PathNode* goal, float agentRadius);
+
+	// Called when the terrain or the filter's answer of a node changes
+	void OnNodeChanged(const PathNode* node);
+
+	// Get the amount of components of the nodes an agent of agentRadius fits on
+	int GetComponentCount(float agentRadius);
+
+	// Get the amount of nodes relabeled since the index was created, not counting the first labeling of a radius
+	long long GetRelabeled() const { return relabeled; }
+
+private:
+	// Labels for one agent radius, indexed by PathNode::id
+	struct Labels
+	{
+		float radius = 0;
+		std::vector<int> label;       // component of the node, -1 if the agent cannot stand on it
+		std::vector<uint8_t> passes;  // the filter accepts the node, it may be cut past
+		std::vector<uint8_t> fits;    // the filter accepts the node and the agent fits on it
+		std::vector<int> sizes;       // nodes per component
+		int count = 0;                // components that are not empty
+	};
+
+	// Get the labels for agentRadius, labeled on first use
+	Labels& LabelsFor(float agentRadius);
+
+	// Update the labels after the node with id changed
+	void Update(Labels& labels, int id);
+
+	// Check if an agent can step between two neighbors in both directions
+	bool Connected(const Labels& labels, int a, int b) const;
+
+	// Check if two nodes of one component are still connected, if not the part of the smaller one gets a new label
+	void Split(Labels& labels, int a, int b);
+
+	// Give every node of oldLabel connected to from the label newLabel
+	void Relabel(Labels& labels, int from, int oldLabel, int newLabel);
+
+	// Join the components of two connected nodes, the smaller one is relabeled
+	void Merge(Labels& labels, int a, int b);
+
+	int NewLabel(Labels& labels);
+
+	// Get the components a node can step into, its own if the agent can stand on it, otherwise those of its neighbors
+	int Entry(Labels& labels, const PathNode* node, int* out);
+
+	Grid* grid;
+	NodeFilter canTraverse;
+	int cols = 0;
+
+	std::vector<Labels> radii; // one entry per agent radius asked for, few in practice
+	std::vector<int> stack;
+	std::vector<int> splitQueues[2];
+	std::vector<int> seen; // seenGeneration marks nodes the first flood of Split reached, seenGeneration + 1 the second
+	int seenGeneration = 0;
+
+	long long relabeled = 0;
+};
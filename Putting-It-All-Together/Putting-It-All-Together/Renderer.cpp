@@ -457,8 +457,7 @@ void Renderer::UpdateDirtyNodes(const AIBrain* brain)
 		if (!nodeNeedsUpdate[i]) continue;
 
 		DrawNode& node = nodeCache[i];
-		auto indexPair = grid.TwoDIndex(i);
-		PathNode& gridNode = grid.GetNodes()[indexPair.first][indexPair.second];
+		PathNode& gridNode = *grid.GetNode((int)i);
 
 		if (brain == nullptr || brain->IsDiscovered(i) || !game.USE_FOG_OF_WAR)
 		{
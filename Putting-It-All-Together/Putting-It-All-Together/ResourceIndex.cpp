@@ -0,0 +1,217 @@
+#include "ResourceIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+void ResourceIndex::Reset(int rows, int cols, float cellSize, const Vec2& origin)
+{
+	this->rows = rows;
+	this->cols = cols;
+	this->cellSize = cellSize;
+	this->origin = origin;
+
+	bucketRows = (rows + BUCKET_SIZE - 1) / BUCKET_SIZE;
+	bucketCols = (cols + BUCKET_SIZE - 1) / BUCKET_SIZE;
+
+	buckets.assign(TYPES * bucketRows * bucketCols, std::vector<int>());
+	types.assign(rows * cols, (int8_t)PathNode::None);
+	places.assign(rows * cols, -1);
+	std::fill(counts, counts + TYPES, 0);
+}
+
+void ResourceIndex::Set(int id, PathNode::ResourceType type)
+{
+	if (!Indexed(type))
+		type = PathNode::None;
+
+	PathNode::ResourceType current = GetType(id);
+	if (current == type)
+		return;
+
+	int bucket = BucketOf(id);
+
+	// Swap the last id of the bucket into the place of the removed one
+	if (current != PathNode::None)
+	{
+		std::vector<int>& ids = buckets[current * bucketRows * bucketCols + bucket];
+		int last = ids.back();
+		ids[places[id]] = last;
+		places[last] = places[id];
+		ids.pop_back();
+		counts[current]--;
+	}
+
+	types[id] = (int8_t)type;
+	places[id] = -1;
+
+	if (type != PathNode::None)
+	{
+		std::vector<int>& ids = buckets[type * bucketRows * bucketCols + bucket];
+		places[id] = (int)ids.size();
+		ids.push_back(id);
+		counts[type]++;
+	}
+}
+
+int ResourceIndex::Count(PathNode::ResourceType type) const
+{
+	return Indexed(type) ? counts[type] : 0;
+}
+
+void ResourceIndex::QueryCells(int top, int left, int bottom, int right, PathNode::ResourceType type, std::vector<int>& out) const
+{
+	if (!Indexed(type) || counts[type] == 0 || top > bottom || left > right)
+		return;
+
+	const std::vector<int>* typeBuckets = &buckets[type * bucketRows * bucketCols];
+	size_t first = out.size();
+
+	for (int br = top / BUCKET_SIZE; br <= bottom / BUCKET_SIZE; br++)
+		for (int bc = left / BUCKET_SIZE; bc <= right / BUCKET_SIZE; bc++)
+			for (int id : typeBuckets[br * bucketCols + bc])
+			{
+				int r = id / cols;
+				int c = id % cols;
+				if (r >= top && r <= bottom && c >= left && c <= right)
+					out.push_back(id);
+			}
+
+	std::sort(out.begin() + first, out.end());
+}
+
+void ResourceIndex::QueryRadius(const Vec2& pos, float radius, PathNode::ResourceType type, std::vector<int>& out) const
+{
+	if (!Indexed(type) || counts[type] == 0 || radius < 0)
+		return;
+
+	// The cells whose centers can be within radius, clamped to the grid
+	Vec2 local = pos - origin;
+	int top = std::max((int)std::ceil((local.y - radius) / cellSize - 0.5f), 0);
+	int bottom = std::min((int)std::floor((local.y + radius) / cellSize - 0.5f), rows - 1);
+	int left = std::max((int)std::ceil((local.x - radius) / cellSize - 0.5f), 0);
+	int right = std::min((int)std::floor((local.x + radius) / cellSize - 0.5f), cols - 1);
+	if (top > bottom || left > right)
+		return;
+
+	const std::vector<int>* typeBuckets = &buckets[type * bucketRows * bucketCols];
+	size_t first = out.size();
+	float radiusSq = radius * radius;
+
+	for (int br = top / BUCKET_SIZE; br <= bottom / BUCKET_SIZE; br++)
+		for (int bc = left / BUCKET_SIZE; bc <= right / BUCKET_SIZE; bc++)
+		{
+			if (BucketDistanceSq(pos, br, bc) > radiusSq)
+				continue;
+
+			for (int id : typeBuckets[br * bucketCols + bc])
+			{
+				Vec2 offset = CenterOf(id) - pos;
+				if (offset.x * offset.x + offset.y * offset.y <= radiusSq)
+					out.push_back(id);
+			}
+		}
+
+	std::sort(out.begin() + first, out.end());
+}
+
+void ResourceIndex::QueryNearest(const Vec2& pos, int count, PathNode::ResourceType type, std::vector<int>& out) const
+{
+	if (!Indexed(type) || count <= 0)
+		return;
+
+	count = std::min(count, counts[type]);
+	if (count == 0)
+		return;
+
+	const std::vector<int>* typeBuckets = &buckets[type * bucketRows * bucketCols];
+
+	// The bucket closest to pos, pos may be outside the grid
+	Vec2 local = pos - origin;
+	float bucketWidth = BUCKET_SIZE * cellSize;
+	int centerRow = std::clamp((int)std::floor(local.y / bucketWidth), 0, bucketRows - 1);
+	int centerCol = std::clamp((int)std::floor(local.x / bucketWidth), 0, bucketCols - 1);
+
+	// The closest nodes found so far, the farthest of them on top
+	std::vector<std::pair<float, int>> best;
+	best.reserve(count + 1);
+
+	// Visit the buckets in rings around the center one. Every bucket of ring n is at least n - 1 buckets away from pos,
+	// so once that is farther than the farthest of count found nodes no bucket left can hold a closer one
+	int rings = std::max(bucketRows, bucketCols);
+	for (int ring = 0; ring < rings; ring++)
+	{
+		if ((int)best.size() == count)
+		{
+			float gap = (ring - 1) * bucketWidth;
+			if (ring > 0 && gap * gap > best.front().first)
+				break;
+		}
+
+		for (int br = centerRow - ring; br <= centerRow + ring; br++)
+		{
+			if (br < 0 || br >= bucketRows)
+				continue;
+
+			// Rows inside the ring only have a bucket at either end
+			bool edgeRow = br == centerRow - ring || br == centerRow + ring;
+			int step = edgeRow ? 1 : std::max(2 * ring, 1);
+
+			for (int bc = centerCol - ring; bc <= centerCol + ring; bc += step)
+			{
+				if (bc < 0 || bc >= bucketCols)
+					continue;
+
+				const std::vector<int>& ids = typeBuckets[br * bucketCols + bc];
+				if (ids.empty())
+					continue;
+				if ((int)best.size() == count && BucketDistanceSq(pos, br, bc) > best.front().first)
+					continue;
+
+				for (int id : ids)
+				{
+					Vec2 offset = CenterOf(id) - pos;
+					std::pair<float, int> entry(offset.x * offset.x + offset.y * offset.y, id);
+
+					if ((int)best.size() < count)
+					{
+						best.push_back(entry);
+						std::push_heap(best.begin(), best.end());
+					}
+					else if (entry < best.front())
+					{
+						std::pop_heap(best.begin(), best.end());
+						best.back() = entry;
+						std::push_heap(best.begin(), best.end());
+					}
+				}
+			}
+		}
+	}
+
+	std::sort_heap(best.begin(), best.end());
+	for (const std::pair<float, int>& entry : best)
+		out.push_back(entry.second);
+}
+
+void ResourceIndex::GetAll(PathNode::ResourceType type, std::vector<int>& out) const
+{
+	if (!Indexed(type))
+		return;
+
+	out.reserve(out.size() + counts[type]);
+
+	const std::vector<int>* typeBuckets = &buckets[type * bucketRows * bucketCols];
+	for (int bucket = 0; bucket < bucketRows * bucketCols; bucket++)
+		out.insert(out.end(), typeBuckets[bucket].begin(), typeBuckets[bucket].end());
+}
+
+float ResourceIndex::BucketDistanceSq(const Vec2& pos, int bucketRow, int bucketCol) const
+{
+	float bucketWidth = BUCKET_SIZE * cellSize;
+	float left = origin.x + bucketCol * bucketWidth;
+	float top = origin.y + bucketRow * bucketWidth;
+
+	float dx = std::max({ left - pos.x, 0.0f, pos.x - (left + bucketWidth) });
+	float dy = std::max({ top - pos.y, 0.0f, pos.y - (top + bucketWidth) });
+	return dx * dx + dy * dy;
+}
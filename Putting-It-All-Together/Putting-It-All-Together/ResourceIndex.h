@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+#include "PathNode.h"
+#include "Vec2.h"
+
+// Nodes holding resources, kept apart per resource type and sorted into square buckets of cells
+// Queries only look at the buckets that can hold an answer, so finding resources never walks the whole map or every known node
+// Nodes are stored by id, row * cols + col like Grid::Index, so a copied Grid can copy its index as is
+class ResourceIndex
+{
+public:
+	static constexpr int BUCKET_SIZE = 8; // rows and columns of cells per bucket
+
+	// Empty the index and fit it to a grid
+	// --------------------------
+	// rows, cols - the size of the grid
+	// cellSize - the diameter of each cell
+	// origin - the world position of the top left corner of the grid
+	void Reset(int rows, int cols, float cellSize, const Vec2& origin);
+
+	// Put a node under a type, moving it if it was under another one
+	// None, Building and other types that are not resources take the node out of the index
+	void Set(int id, PathNode::ResourceType type);
+
+	// Get the type a node is under, None if it is not in the index
+	PathNode::ResourceType GetType(int id) const { return (PathNode::ResourceType)types[id]; }
+
+	// Get the amount of nodes under a type
+	int Count(PathNode::ResourceType type) const;
+
+	// Get the nodes of a type in a box of cells, in id order
+	// --------------------------
+	// top, left, bottom, right - the first and last row and column of the box, inside the grid
+	// out - the ids are added to the end of it
+	void QueryCells(int top, int left, int bottom, int right, PathNode::ResourceType type, std::vector<int>& out) const;
+
+	// Get the nodes of a type whose cell centers are within radius of a position, in id order
+	void QueryRadius(const Vec2& pos, float radius, PathNode::ResourceType type, std::vector<int>& out) const;
+
+	// Get the nodes of a type with the cell centers closest to a position, closest first, the lower id first on a tie
+	// --------------------------
+	// count - the most nodes to find, fewer if the type has fewer
+	void QueryNearest(const Vec2& pos, int count, PathNode::ResourceType type, std::vector<int>& out) const;
+
+	// Get every node of a type, bucket by bucket
+	void GetAll(PathNode::ResourceType type, std::vector<int>& out) const;
+
+private:
+	static constexpr int TYPES = PathNode::ResourceEnd;
+
+	static bool Indexed(PathNode::ResourceType type) { return type >= PathNode::ResourceStart && type < PathNode::ResourceEnd; }
+
+	int BucketOf(int id) const { return (id / cols / BUCKET_SIZE) * bucketCols + (id % cols) / BUCKET_SIZE; }
+
+	Vec2 CenterOf(int id) const { return origin + Vec2((id % cols + 0.5f) * cellSize, (id / cols + 0.5f) * cellSize); }
+
+	// Get the squared distance from a position to the closest point of a bucket
+	float BucketDistanceSq(const Vec2& pos, int bucketRow, int bucketCol) const;
+
+	int rows = 0;
+	int cols = 0;
+	int bucketRows = 0;
+	int bucketCols = 0;
+	float cellSize = 0;
+	Vec2 origin;
+
+	std::vector<std::vector<int>> buckets; // ids per type and bucket, type * bucketRows * bucketCols + bucket
+	std::vector<int8_t> types;             // PathNode::ResourceType per id, None if not in the index
+	std::vector<int> places;               // where each id is in its bucket
+	int counts[TYPES] = {};
+};
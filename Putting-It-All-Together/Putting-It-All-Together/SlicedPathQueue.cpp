@@ -0,0 +1,118 @@
+#include "SlicedPathQueue.h"
+#include "GameLoop.h"
+#include "GameAI.h"
+#include "AIBrain.h"
+#include <algorithm>
+
+void SlicedPathQueue::Submit(GameAI* ai, PathNode* startNode, PathNode* endNode, float agentRadius, AIBrain* belief, uint32_t cacheEpoch)
+{
+	if (!ai || !startNode || !endNode)
+		return;
+
+	Cancel(ai);
+
+	Request request;
+	request.ai = ai;
+	request.endNode = endNode;
+	request.belief = belief;
+	request.cacheEpoch = cacheEpoch;
+	request.beliefVersion = belief ? belief->GetBeliefVersion() : 0;
+	request.state = TakeState();
+
+	NodeFilter filter;
+	if (belief)
+		filter = belief->UsableFilter();
+	else
+		filter = TerrainFilter();
+
+	search.BeginSearch(*request.state, startNode, endNode, agentRadius, filter);
+
+	requests.push_back(std::move(request));
+}
+
+bool SlicedPathQueue::IsPending(const GameAI* ai, const PathNode* endNode) const
+{
+	for (const Request& request : requests)
+		if (request.ai == ai)
+			return request.endNode == endNode;
+	return false;
+}
+
+void SlicedPathQueue::Cancel(const GameAI* ai)
+{
+	closestTargets.erase(ai);
+
+	for (auto it = requests.begin(); it != requests.end(); ++it)
+	{
+		if (it->ai == ai)
+		{
+			if (freeStates.size() < MAX_FREE_STATES)
+				freeStates.push_back(std::move(it->state));
+			requests.erase(it);
+			return;
+		}
+	}
+}
+
+void SlicedPathQueue::Update()
+{
+	// The records of running searches may lead through nodes that changed, start them over
+	if (terrainChanged)
+	{
+		for (Request& request : requests)
+		{
+			AStar::SlicedSearch& state = *request.state;
+			search.BeginSearch(state, state.startNode, request.endNode, state.agentRadius, state.canTraverse);
+		}
+		terrainChanged = false;
+	}
+
+	spentLastTick = 0;
+
+	while (!requests.empty())
+	{
+		Request& request = requests.front();
+
+		int budget = expansionsPerTick - spentLastTick;
+		spentLastTick += search.StepSearch(*request.state, budget);
+
+		if (request.state->status == AStar::SearchStatus::Running)
+			break;
+
+		Request finished = std::move(request);
+		requests.pop_front();
+		Finish(finished);
+	}
+}
+
+void SlicedPathQueue::Finish(Request& request)
+{
+	GameLoop& game = GameLoop::Instance();
+	AStar::SlicedSearch& state = *request.state;
+
+	float dist = 0;
+	std::vector<PathNode*> path = search.GetSearchPath(state, dist);
+
+	if (game.pathCache)
+		game.pathCache->Store(state.startNode, request.endNode, state.agentRadius, request.belief, path, dist, request.cacheEpoch, request.beliefVersion);
+
+	if (freeStates.size() < MAX_FREE_STATES)
+		freeStates.push_back(std::move(request.state));
+
+	request.ai->ReceivePath(std::move(path), request.belief == nullptr);
+}
+
+std::unique_ptr<AStar::SlicedSearch> SlicedPathQueue::TakeState()
+{
+	if (freeStates.empty())
+		return std::make_unique<AStar::SlicedSearch>();
+
+	std::unique_ptr<AStar::SlicedSearch> state = std::move(freeStates.back());
+	freeStates.pop_back();
+	return state;
+}
+
+std::string SlicedPathQueue::GetStatus() const
+{
+	return "Path requests: " + std::to_string(requests.size()) + " pending, " + std::to_string(spentLastTick) + "/" + std::to_string(expansionsPerTick) + " nodes expanded this tick";
+}
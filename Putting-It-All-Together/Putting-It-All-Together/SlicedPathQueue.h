@@ -0,0 +1,72 @@
+#pragma once
+#include "PathRequestService.h"
+#include "AStar.h"
+#include <deque>
+#include <map>
+#include <memory>
+
+// Path searches spread over several ticks on the game thread
+// Every tick the searches share a budget of node expansions, the oldest search is advanced first,
+// so many agents retargeting at once lengthen their wait instead of the frame
+class SlicedPathQueue : public PathRequestService
+{
+public:
+	// Constructor
+	// --------------------------
+	// grid - the grid to search
+	// expansionsPerTick - the amount of nodes all searches together may expand per Update
+	SlicedPathQueue(Grid* grid, int expansionsPerTick) : grid(grid), search(grid), expansionsPerTick(expansionsPerTick) { }
+
+	// Overrides base Submit
+	void Submit(GameAI* ai, PathNode* startNode, PathNode* endNode, float agentRadius, AIBrain* belief, uint32_t cacheEpoch) override;
+
+	// Overrides base IsPending
+	bool IsPending(const GameAI* ai, const PathNode* endNode) const override;
+
+	// Overrides base Cancel
+	void Cancel(const GameAI* ai) override;
+
+	// Overrides base Update, spends the expansion budget and hands finished paths to their agents
+	void Update() override;
+
+	// Overrides base OnNodeChanged, searches in progress start over
+	void OnNodeChanged(const PathNode* node) override { terrainChanged = true; }
+
+	// Overrides base GetStatus
+	std::string GetStatus() const override;
+
+	void SetExpansionsPerTick(int expansions) { expansionsPerTick = expansions; }
+	int GetExpansionsPerTick() const { return expansionsPerTick; }
+	int GetSpentLastTick() const { return spentLastTick; }
+	int GetPendingCount() const { return (int)requests.size(); }
+
+private:
+	struct Request
+	{
+		GameAI* ai = nullptr;
+		PathNode* endNode = nullptr; // requested goal, the search may end next to it
+		AIBrain* belief = nullptr;
+		uint32_t cacheEpoch = 0;
+		uint32_t beliefVersion = 0; // of belief at submission, with cacheEpoch decides if the result may be cached
+		std::unique_ptr<AStar::SlicedSearch> state;
+	};
+
+	// Hand a finished search to its agent and recycle its records
+	void Finish(Request& request);
+
+	// Get a search state, reusing the records of a finished one if possible
+	std::unique_ptr<AStar::SlicedSearch> TakeState();
+
+	// The amount of finished search states kept for reuse, each holds records for the whole grid
+	static constexpr size_t MAX_FREE_STATES = 16;
+
+	Grid* grid;
+	AStar search;
+	int expansionsPerTick;
+
+	std::deque<Request> requests; // oldest first, at most one per agent
+	std::vector<std::unique_ptr<AStar::SlicedSearch>> freeStates;
+
+	bool terrainChanged = false;
+	int spentLastTick = 0;
+};
@@ -0,0 +1,173 @@
+#include "ThetaStar.h"
+#include <cmath>
+#include <limits>
+#include <queue>
+
+std::vector<PathNode*> ThetaStar::RequestPath(PathNode* startNode, PathNode* endNode, float& outDist, float agentRadius, const NodeFilter& canTraverse)
+{
+	lastExpanded = 0;
+	lastSightChecks = 0;
+	outDist = -1;
+
+	goal = ResolveGoalNode(*grid, endNode, agentRadius);
+	if (startNode == nullptr || goal == nullptr)
+		return std::vector<PathNode*>();
+
+	cols = grid->GetCols();
+	radius = agentRadius;
+	filter = &canTraverse;
+
+	records.NewSearch(grid->GetRows() * cols);
+
+	std::priority_queue<OpenEntry, std::vector<OpenEntry>, OpenEntryCompare> openQueue;
+
+	NodeRecord& startRec = records.Get(startNode);
+	startRec.gCost = 0.0f;
+	startRec.hCost = Distance(startNode, goal);
+	startRec.fCost = startRec.hCost;
+	startRec.parent = nullptr;
+
+	openQueue.push({ startNode, startRec.fCost });
+
+	while (!openQueue.empty())
+	{
+		OpenEntry entry = openQueue.top();
+		openQueue.pop();
+
+		PathNode* current = entry.node;
+
+		// Ignore stale queue entries
+		if (records.IsClosed(current) || records.Get(current).fCost != entry.f)
+			continue;
+
+		NodeRecord& rec = records.Get(current);
+
+		// The parent was only assumed to be visible when current was pushed, fall back to the cheapest expanded neighbor if it is not
+		float cost = 0;
+		if (rec.parent && !Segment(rec.parent, current, cost))
+		{
+			rec.gCost = std::numeric_limits<float>::infinity();
+			rec.parent = nullptr;
+			for (PathNode* neighbor : grid->Neighbors(current))
+			{
+				if (!records.IsClosed(neighbor) || !Segment(neighbor, current, cost))
+					continue;
+
+				float g = records.At(neighbor).gCost + cost;
+				if (g < rec.gCost)
+				{
+					rec.gCost = g;
+					rec.parent = neighbor;
+				}
+			}
+			rec.fCost = rec.gCost + rec.hCost;
+		}
+
+		if (current == goal)
+		{
+			outDist = rec.gCost;
+			return ReconstructPath(records, goal);
+		}
+
+		records.Close(current);
+		lastExpanded++;
+
+		for (PathNode* neighbor : grid->Neighbors(current))
+		{
+			if (records.IsClosed(neighbor))
+				continue;
+
+			if (!canTraverse(neighbor) && neighbor != goal)
+				continue;
+
+			if (neighbor->clearance < agentRadius)
+				continue;
+
+			// The grid step has to exist, it is what a failed line of sight falls back to
+			float stepCost = 0;
+			if (!Segment(current, neighbor, stepCost))
+				continue;
+
+			PathNode* parent = current;
+			float g = rec.gCost + stepCost;
+
+			// Straight from current's parent, checked when neighbor is expanded
+			if (rec.parent && SurfaceSpeed(neighbor->type) == 1.0f)
+			{
+				float throughParent = records.At(rec.parent).gCost + Distance(rec.parent, neighbor);
+				if (throughParent < g)
+				{
+					parent = rec.parent;
+					g = throughParent;
+				}
+			}
+
+			NodeRecord& neighborRec = records.Get(neighbor);
+			if (g >= neighborRec.gCost)
+				continue;
+
+			neighborRec.parent = parent;
+			neighborRec.gCost = g;
+			neighborRec.hCost = Distance(neighbor, goal);
+			neighborRec.fCost = g + neighborRec.hCost;
+
+			openQueue.push({ neighbor, neighborRec.fCost });
+		}
+	}
+
+	return std::vector<PathNode*>();
+}
+
+std::vector<PathNode*> ThetaStar::RequestClosestPath(PathNode* startNode, const std::vector<PathNode*>& possibleEndNodes, float& outDist, float agentRadius, const NodeFilter& canTraverse)
+{
+	std::vector<PathNode*> path = closestSearch.RequestClosestPath(startNode, possibleEndNodes, outDist, agentRadius, canTraverse);
+	lastExpanded = closestSearch.GetLastExpanded();
+	return path;
+}
+
+std::vector<PathNode*> ThetaStar::RefineSegment(PathNode* from, PathNode* to, float agentRadius, const NodeFilter& canTraverse)
+{
+	// The end of the segment may be a goal the filter rejects, like the pathfinders allow
+	if (!grid->HasLineOfSight(from, to, agentRadius, [&](const PathNode* node) { return node == to || canTraverse(node); }))
+		return std::vector<PathNode*>();
+
+	return std::vector<PathNode*>{ to, from };
+}
+
+bool ThetaStar::Segment(const PathNode* from, const PathNode* to, float& outCost)
+{
+	int row = from->id / cols;
+	int col = from->id % cols;
+	int toRow = to->id / cols;
+	int toCol = to->id % cols;
+
+	// A single grid step follows the same rules as AStar, to itself was checked before it was pushed
+	if (std::abs(row - toRow) <= 1 && std::abs(col - toCol) <= 1)
+	{
+		bool diagonal = row != toRow && col != toCol;
+		if (diagonal)
+		{
+			if (!(*filter)(grid->GetNode(row, toCol)) || !(*filter)(grid->GetNode(toRow, col)))
+				return false;
+		}
+
+		outCost = (diagonal ? 1.41421356f : 1.0f) / SurfaceSpeed(to->type);
+		return true;
+	}
+
+	lastSightChecks++;
+	bool clear = grid->HasLineOfSight(from, to, radius, [this](const PathNode* node)
+		{
+			return node == goal || ((*filter)(node) && SurfaceSpeed(node->type) == 1.0f);
+		});
+
+	outCost = Distance(from, to);
+	return clear;
+}
+
+float ThetaStar::Distance(const PathNode* a, const PathNode* b) const
+{
+	float dx = (float)(a->id % cols - b->id % cols);
+	float dy = (float)(a->id / cols - b->id / cols);
+	return std::sqrt(dx * dx + dy * dy);
+}
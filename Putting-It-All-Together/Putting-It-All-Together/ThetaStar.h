@@ -0,0 +1,54 @@
+#pragma once
+#include "Pathfinder.h"
+#include "AStar.h"
+#include "Grid.h"
+
+// Lazy Theta*, any-angle paths over the 8-connected grid
+// A node pushed from current takes current's parent as its own, assuming the two can see each other,
+// and the line of sight is only checked once the node is expanded. Paths come out as few waypoints
+// joined by straight lines that Grid::HasLineOfSight accepts for the agent's radius.
+// Straight lines only cross cells of normal speed, swamp cells are entered one grid step at a time
+class ThetaStar : public Pathfinder
+{
+public:
+	ThetaStar(Grid* grid) : grid(grid), closestSearch(grid) { }
+
+	// Overrides base RequestPath, consecutive nodes of the path are usually not neighbors
+	std::vector<PathNode*> RequestPath(PathNode* startNode, PathNode* endNode, float& outDist, float agentRadius, const NodeFilter& canTraverse) override;
+
+	// Overrides base RequestClosestPath, multi-goal searches are handed to AStar
+	std::vector<PathNode*> RequestClosestPath(PathNode* startNode, const std::vector<PathNode*>& possibleEndNodes, float& outDist, float agentRadius, const NodeFilter& canTraverse) override;
+
+	// Overrides base RefineSegment, a straight segment needs no cells in between as long as it is still clear
+	std::vector<PathNode*> RefineSegment(PathNode* from, PathNode* to, float agentRadius, const NodeFilter& canTraverse) override;
+
+	// Overrides base GetName
+	std::string GetName() const override { return "Lazy Theta*"; }
+
+	// Get the amount of line of sight checks made by the latest request
+	int GetLastSightChecks() const { return lastSightChecks; }
+
+private:
+	// Check if the straight segment between two nodes may be walked, and its cost
+	// --------------------------
+	// outCost - output parameter to receive the cost of the segment
+	// --------------------------
+	// returns false if the segment cuts a corner, crosses a blocked cell or a straight line crosses a slow cell
+	bool Segment(const PathNode* from, const PathNode* to, float& outCost);
+
+	// Get the Euclidean distance between a and b measured in cells
+	float Distance(const PathNode* a, const PathNode* b) const;
+
+	Grid* grid;
+	AStar closestSearch;
+
+	NodeRecordArray records;
+
+	// State of the running search
+	int cols = 0;
+	PathNode* goal = nullptr;
+	float radius = 0;
+	const NodeFilter* filter = nullptr;
+
+	int lastSightChecks = 0;
+};
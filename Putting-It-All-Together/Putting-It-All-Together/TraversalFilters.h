@@ -0,0 +1,40 @@
+#pragma once
+#include "PathNode.h"
+#include <cstdint>
+#include <functional>
+
+using NodeFilter = std::function<bool(const PathNode*)>;
+
+// Filters for the searches that can be called without going through std::function
+// A NodeFilter holding one of these is recognised by AStar, which then runs a search compiled for that filter,
+// so the check inlines into the neighbor loop. Any other NodeFilter still works, through the std::function call
+
+// Accepts every node that is not an obstacle, the filter of searches that ignore fog of war
+struct TerrainFilter
+{
+	bool operator()(const PathNode* node) const { return !node->IsObstacle(); }
+};
+
+// Accepts the nodes whose entry in a mask indexed by PathNode::id is set
+// Used for AIBrain::CanUseNode, which the brain keeps as such a mask, and for copies of it
+struct MaskFilter
+{
+	const uint8_t* usable;
+
+	bool operator()(const PathNode* node) const { return usable[node->id] != 0; }
+};
+
+// Call search with the filter stored in canTraverse if it is one of the above, otherwise with canTraverse itself
+// --------------------------
+// search - generic callable taking the filter, every call must return the same type
+// --------------------------
+// returns what search returns
+template<typename Search>
+auto WithFilter(const NodeFilter& canTraverse, Search search)
+{
+	if (const TerrainFilter* terrain = canTraverse.target<TerrainFilter>())
+		return search(*terrain);
+	if (const MaskFilter* mask = canTraverse.target<MaskFilter>())
+		return search(*mask);
+	return search(canTraverse);
+}